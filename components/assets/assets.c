@@ -0,0 +1,155 @@
+// assets.c
+//
+// assets 分区保存 tools/mkassets.py 打包的图片：
+//   文件头 | 索引 (按名字哈希排序) | 名字表 | 像素数据 (按 lv_img_dsc_t 的格式存放)
+// 启动时用 esp_partition_mmap 把分区映射到数据 cache 地址空间，
+// 每张图片的 lv_img_dsc_t.data 直接指向 flash，LVGL 绘制时经 cache 读取像素。
+// 常用的背景图不再占用 RAM，也不再经过 FatFs 和 SPI 总线。
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_partition.h"
+#include "assets.h"
+
+static const char *TAG = "assets";
+
+#define ASSETS_PARTITION_LABEL      "assets"
+#define ASSETS_PARTITION_SUBTYPE    ((esp_partition_subtype_t)0x40)
+#define ASSETS_MAGIC                (0x5041564C)    // "LVAP"
+#define ASSETS_VERSION              (1)
+#define ASSETS_FLAG_SWAP16          (0x0001)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t count;
+    uint32_t index_off;
+    uint32_t names_off;
+    uint32_t data_off;
+    uint32_t total_size;
+    uint32_t reserved;
+} assets_header_t;
+
+typedef struct {
+    uint32_t hash;              // 名字的 FNV-1a 哈希
+    uint32_t name_off;
+    uint32_t data_off;
+    uint32_t data_size;
+    uint32_t img_header;        // lv_img_header_t
+    uint32_t reserved;
+} assets_entry_t;
+
+_Static_assert(sizeof(assets_header_t) == 32, "assets header must match tools/mkassets.py");
+_Static_assert(sizeof(assets_entry_t) == 24, "assets entry must match tools/mkassets.py");
+
+static const uint8_t *s_base;
+static esp_partition_mmap_handle_t s_map;
+static const assets_entry_t *s_index;
+static uint32_t s_count;
+static lv_img_dsc_t *s_dsc;
+
+static uint32_t assets_hash(const char *name)
+{
+    uint32_t h = 0x811C9DC5;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+static bool assets_header_valid(const assets_header_t *hdr, uint32_t part_size)
+{
+    return hdr->total_size <= part_size &&
+           hdr->index_off + hdr->count * sizeof(assets_entry_t) <= hdr->names_off &&
+           hdr->names_off <= hdr->data_off && hdr->data_off <= hdr->total_size &&
+           (hdr->index_off & 3) == 0;
+}
+
+esp_err_t assets_init(void)
+{
+    // 防止重复初始化
+    if (s_base) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ASSETS_PARTITION_SUBTYPE,
+                                                           ASSETS_PARTITION_LABEL);
+    ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "no assets partition");
+
+    // 先读文件头，只映射实际用到的部分，少占 MMU 页
+    assets_header_t hdr;
+    ESP_RETURN_ON_ERROR(esp_partition_read(part, 0, &hdr, sizeof(hdr)), TAG, "read header failed");
+    ESP_RETURN_ON_FALSE(hdr.magic == ASSETS_MAGIC && hdr.version == ASSETS_VERSION, ESP_ERR_NOT_FOUND,
+                        TAG, "assets partition is empty or not made by mkassets.py v%d", ASSETS_VERSION);
+    ESP_RETURN_ON_FALSE(assets_header_valid(&hdr, part->size), ESP_ERR_INVALID_SIZE, TAG, "corrupted assets header");
+    // flash 中的像素不能就地交换字节，打包时的字节序必须和 LVGL 的配置一致
+    ESP_RETURN_ON_FALSE(((hdr.flags & ASSETS_FLAG_SWAP16) != 0) == LV_COLOR_16_SWAP, ESP_ERR_INVALID_STATE,
+                        TAG, "assets packed %s --swap16 but LV_COLOR_16_SWAP is %d",
+                        (hdr.flags & ASSETS_FLAG_SWAP16) ? "with" : "without", LV_COLOR_16_SWAP);
+
+    s_dsc = calloc(hdr.count, sizeof(lv_img_dsc_t));
+    ESP_RETURN_ON_FALSE(s_dsc || hdr.count == 0, ESP_ERR_NO_MEM, TAG, "no mem for %" PRIu32 " assets", hdr.count);
+
+    const void *ptr = NULL;
+    esp_err_t ret = esp_partition_mmap(part, 0, hdr.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &s_map);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "mmap %" PRIu32 " bytes failed (%s)", hdr.total_size, esp_err_to_name(ret));
+        free(s_dsc);
+        s_dsc = NULL;
+        return ret;
+    }
+
+    const uint8_t *base = ptr;
+    const assets_entry_t *index = (const assets_entry_t *)(base + hdr.index_off);
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        const assets_entry_t *e = &index[i];
+        if (e->name_off < hdr.names_off || e->name_off >= hdr.data_off ||
+                e->data_off < hdr.data_off || e->data_size > hdr.total_size - e->data_off) {
+            ESP_LOGE(TAG, "corrupted entry %" PRIu32, i);
+            esp_partition_munmap(s_map);
+            free(s_dsc);
+            s_dsc = NULL;
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(&s_dsc[i].header, &e->img_header, sizeof(lv_img_header_t));
+        s_dsc[i].data_size = e->data_size;
+        s_dsc[i].data = base + e->data_off;
+    }
+
+    s_base = base;
+    s_index = index;
+    s_count = hdr.count;
+    ESP_LOGI(TAG, "%" PRIu32 " assets, %" PRIu32 " KB mapped at %p", s_count, hdr.total_size / 1024, s_base);
+    return ESP_OK;
+}
+
+const lv_img_dsc_t *assets_get_img(const char *name)
+{
+    if (s_base == NULL || name == NULL) {
+        return NULL;
+    }
+
+    // 二分查找第一个哈希相同的条目，再逐个比较名字
+    uint32_t hash = assets_hash(name);
+    uint32_t lo = 0;
+    uint32_t hi = s_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (s_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < s_count && s_index[lo].hash == hash; lo++) {
+        if (strcmp((const char *)s_base + s_index[lo].name_off, name) == 0) {
+            return &s_dsc[lo];
+        }
+    }
+    return NULL;
+}
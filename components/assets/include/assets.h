@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 映射 assets 分区 (tools/mkassets.py 生成)，建立图片描述符
+ *
+ * 图片像素留在 flash 中，通过 cache 直接交给 LVGL 绘制，不占用 RAM，也不经过文件系统。
+ * 分区为空或格式不符时返回错误，调用者可以退回到从 TF 卡读取。
+ */
+esp_err_t assets_init(void);
+
+/**
+ * @brief 按名字查找图片
+ *
+ * @param name 打包时相对于资源目录的路径，去掉扩展名，例如 "Chie_240"、"icons/wifi"
+ * @return 可以直接传给 lv_img_set_src 的描述符，找不到或没有初始化时返回 NULL
+ */
+const lv_img_dsc_t *assets_get_img(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
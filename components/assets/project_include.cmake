@@ -0,0 +1,50 @@
+# assets_create_partition_image
+#
+# Pack the images (*.bin, *.png) in base_dir with tools/mkassets.py into an
+# image for the given partition; other files in base_dir are ignored. With
+# FLASH_IN_PROJECT the image is written by `idf.py flash`.
+function(assets_create_partition_image partition base_dir)
+    set(options FLASH_IN_PROJECT)
+    set(multi DEPENDS)
+    cmake_parse_arguments(arg "${options}" "" "${multi}" "${ARGN}")
+
+    idf_build_get_property(python PYTHON)
+    idf_build_get_property(project_dir PROJECT_DIR)
+    idf_build_get_property(build_dir BUILD_DIR)
+    get_filename_component(base_dir_full_path ${base_dir} ABSOLUTE)
+
+    partition_table_get_partition_info(size "--partition-name ${partition}" "size")
+    partition_table_get_partition_info(offset "--partition-name ${partition}" "offset")
+
+    if("${size}" AND "${offset}")
+        set(image_file ${build_dir}/${partition}.bin)
+        set(mkassets ${project_dir}/tools/mkassets.py)
+
+        # The pixels are mapped straight from flash, so they must already be in
+        # the byte order LVGL draws with
+        set(swap_arg "")
+        if(CONFIG_LV_COLOR_16_SWAP)
+            set(swap_arg "--swap16")
+        endif()
+
+        file(GLOB_RECURSE asset_files CONFIGURE_DEPENDS
+            "${base_dir_full_path}/*.bin" "${base_dir_full_path}/*.png")
+        add_custom_command(OUTPUT ${image_file}
+            COMMAND ${python} ${mkassets} ${base_dir_full_path} -o ${image_file} --size ${size} ${swap_arg}
+            DEPENDS ${asset_files} ${mkassets} ${arg_DEPENDS}
+            COMMENT "Packing assets from ${base_dir} for partition ${partition}"
+            VERBATIM)
+        add_custom_target(${partition}_bin ALL DEPENDS ${image_file})
+        set_property(DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}" APPEND PROPERTY
+            ADDITIONAL_CLEAN_FILES ${image_file})
+
+        if(arg_FLASH_IN_PROJECT)
+            esptool_py_flash_to_partition(flash "${partition}" "${image_file}")
+            add_dependencies(flash ${partition}_bin)
+        endif()
+    else()
+        set(message "Failed to create assets image for partition '${partition}'. "
+                    "Check project configuration if using the correct partition table file.")
+        fail_at_build_time(assets_${partition}_bin "${message}")
+    endif()
+endfunction()
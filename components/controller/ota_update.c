@@ -1,6 +1,7 @@
 #include "controller.h"
 #include "wifi_bt_net_model.h"
 #include "ui.h"
+#include "lv_port_tick.h"
 #include "freertos/FreeRTOS.h"
 #include "wifi_prov_mgr.h"
 #include "esp_app_desc.h"
@@ -25,7 +26,9 @@ void ota_update_prov_task(void *pv)
     if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
         ESP_LOGE(TAG, "Wi-Fi is not connected");
 
+        lv_port_lock(0);
         wifi_view_update_status("Wi-Fi is not connected");
+        lv_port_unlock();
         vTaskDelay(pdMS_TO_TICKS(1000));
         goto err;
     }
@@ -72,18 +75,24 @@ void ota_update_prov_task(void *pv)
             break;
         case OTA_NO_UPDATE_AVAILABLE:
             ESP_LOGI(TAG, "OTA Info: No new updates available.");
+            lv_port_lock(0);
             wifi_view_update_status("No new updates available");
+            lv_port_unlock();
             vTaskDelay(pdMS_TO_TICKS(1000));
             break;
         case OTA_CHECK_FAILED:
             ESP_LOGE(TAG, "OTA Error: Failed to check or download update.");
+            lv_port_lock(0);
             wifi_view_update_status("Failed to check or download update");
+            lv_port_unlock();
             vTaskDelay(pdMS_TO_TICKS(1000));
             break;
     }
 
 err:
+    lv_port_lock(0);
     wifi_view_load_main();
+    lv_port_unlock();
     vTaskDelete(NULL);
 }
 
@@ -1,6 +1,8 @@
 #include "controller.h"
 #include "wifi_bt_net_model.h"
 #include "ui.h"
+#include "lv_port_tick.h"
+#include "lv_port_storage.h"
 #include "freertos/FreeRTOS.h"
 #include "wifi_prov_mgr.h"
 #include "web_download.h"
@@ -10,6 +12,8 @@
 
 static char *TAG = "web_download_controller";
 
+#define SD_READY_TIMEOUT_MS (10 * 1000)
+
 void download_file_task(void *pvParameters)
 {
 
@@ -22,7 +26,20 @@ void download_file_task(void *pvParameters)
     if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
         ESP_LOGE(TAG, "Wi-Fi is not connected");
 
+        lv_port_lock(0);
         wifi_view_update_status("Wi-Fi is not connected");
+        lv_port_unlock();
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        goto err;
+    }
+
+    // TF 卡在后台挂载，开机后马上下载时等它完成
+    if (!lv_port_storage_wait(LV_PORT_STORAGE_SD, SD_READY_TIMEOUT_MS)) {
+        ESP_LOGE(TAG, "SD card is not mounted");
+
+        lv_port_lock(0);
+        wifi_view_update_status("SD card not ready");
+        lv_port_unlock();
         vTaskDelay(pdMS_TO_TICKS(1000));
         goto err;
     }
@@ -34,17 +51,23 @@ void download_file_task(void *pvParameters)
         // snprintf(lvgl_show_file_url, sizeof(lvgl_show_file_url), "A:%s", download_file);
         snprintf(lvgl_show_file_url, sizeof(lvgl_show_file_url), "A:/sdcard/%s", download_file + 3);
         ESP_LOGI(TAG, "download_file %s", lvgl_show_file_url);
+        lv_port_lock(0);
         wifi_view_show_image(lvgl_show_file_url);
+        lv_port_unlock();
         vTaskDelay(pdMS_TO_TICKS(1000));
     } else {
         ESP_LOGE(TAG, "Failed to download file");
+        lv_port_lock(0);
         wifi_view_update_status("Download failed");
+        lv_port_unlock();
         vTaskDelay(pdMS_TO_TICKS(1000));
         // No return here, allow the task to proceed to cleanup and exit.
     }
 
 err:
+    lv_port_lock(0);
     wifi_view_load_main();
+    lv_port_unlock();
     vTaskDelete(NULL);
 }
 
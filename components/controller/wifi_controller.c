@@ -1,6 +1,7 @@
 #include "controller.h"
 #include "wifi_bt_net_model.h"
 #include "ui.h"
+#include "lv_port_tick.h"
 #include "freertos/FreeRTOS.h"
 #include "wifi_prov_mgr.h"
 #include <esp_wifi_types_generic.h>
@@ -17,16 +18,22 @@ void wifi_prov_task(void *pv)
     if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
         ESP_LOGE(TAG, "Wi-Fi is already connected");
 
+        lv_port_lock(0);
         wifi_view_update_status("Wi-Fi is already connected");
+        lv_port_unlock();
         vTaskDelay(pdMS_TO_TICKS(1000));
         goto err;
     }
 
     if(!wifi_bt_net_init())
     {
+       lv_port_lock(0);
        wifi_view_update_status("wifi bt net");
+       lv_port_unlock();
        wifi_bt_net_run(url);
+       lv_port_lock(0);
        wifi_view_show_qrcode(url);
+       lv_port_unlock();
     }
     else
     {
@@ -38,12 +45,16 @@ void wifi_prov_task(void *pv)
     // wifi_bt_net_net();
 
     wifi_bt_net_wait();
+    lv_port_lock(0);
     wifi_view_update_status("over connect Wi-Fi...");
+    lv_port_unlock();
 
     vTaskDelay(pdMS_TO_TICKS(1000));
 
 err:
+    lv_port_lock(0);
     wifi_view_load_main();
+    lv_port_unlock();
     vTaskDelete(NULL);
 }
 
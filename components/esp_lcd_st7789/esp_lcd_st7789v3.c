@@ -5,6 +5,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/cdefs.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -16,9 +17,28 @@
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 #include "esp_lcd_st7789v3.h"
+#include "spi_bus_sched.h"
 
-extern SemaphoreHandle_t spi_mutex;
+// The LCD shares SPI2_HOST with the SD card, every command sequence goes through the bus scheduler
+#define LCD_BUS_LOCK()      spi_bus_sched_acquire(SPI_BUS_CLIENT_LCD, portMAX_DELAY)
+#define LCD_BUS_UNLOCK()    spi_bus_sched_release(SPI_BUS_CLIENT_LCD)
+
+#ifndef LCD_CMD_RAMWRC
+#define LCD_CMD_RAMWRC      0x3C // Write Memory Continue
+#endif
+
+#ifndef LCD_CMD_VSCRDEF
+#define LCD_CMD_VSCRDEF     0x33 // Vertical Scrolling Definition
+#endif
+#ifndef LCD_CMD_VSCSAD
+#define LCD_CMD_VSCSAD      0x37 // Vertical Scroll Start Address of RAM
+#endif
+
+// ST7789V3 frame memory is 240 columns x 320 rows
+#define ST7789V3_GRAM_COLS  (240)
+#define ST7789V3_GRAM_ROWS  (320)
 
 static const char *TAG = "st7789v3";
 
@@ -45,8 +65,26 @@ typedef struct
     uint8_t colmod_cal; // save current value of LCD_CMD_COLMOD register
     uint16_t width;
     uint16_t height;
+    // Address window left open by the last RAMWR/RAMWRC, used to merge adjacent strips
+    struct {
+        bool valid;
+        int x_start;
+        int x_end;
+        int next_y;
+    } window;
+    esp_lcd_st7789v3_stats_t stats;
+    // Vertical scroll area in frame memory rows, as sent with VSCRDEF
+    struct {
+        int top;
+        int height;
+    } scroll;
 } st7789v3_panel_t;
 
+static inline void st7789v3_window_invalidate(st7789v3_panel_t *st7789v3)
+{
+    st7789v3->window.valid = false;
+}
+
 esp_err_t esp_lcd_new_panel_st7789v3(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel)
 {
 
@@ -148,6 +186,8 @@ static esp_err_t panel_st7789v3_reset(esp_lcd_panel_t *panel)
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
+    st7789v3->scroll.height = 0; // reset restores the default scroll definition
     esp_lcd_panel_io_handle_t io = st7789v3->io;
 
     // perform hardware reset
@@ -160,10 +200,10 @@ static esp_err_t panel_st7789v3_reset(esp_lcd_panel_t *panel)
     }
     else
     {                                            // perform software reset
-        xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+        LCD_BUS_LOCK(); // 加锁
         esp_lcd_panel_io_tx_param(io, LCD_CMD_SWRESET, NULL, 0);
         
-        xSemaphoreGive(spi_mutex);      // 解锁
+        LCD_BUS_UNLOCK();      // 解锁
         vTaskDelay(pdMS_TO_TICKS(20)); // spec, wait at least 5ms before sending new command
     }
 
@@ -222,34 +262,35 @@ static esp_err_t panel_st7789v3_init(esp_lcd_panel_t *panel)
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
     esp_lcd_panel_io_handle_t io = st7789v3->io;
 
     // LCD goes into sleep mode and display will be turned off after power on reset, exit sleep mode first
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPOUT, NULL, 0);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
     vTaskDelay(pdMS_TO_TICKS(120));
 
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     // Set pixel format
     esp_lcd_panel_io_tx_param(io, LCD_CMD_COLMOD, (uint8_t[]){
                                                       st7789v3->colmod_cal,
                                                   },
                               1);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
 
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     // Set memory data access control
     esp_lcd_panel_io_tx_param(io, LCD_CMD_MADCTL, (uint8_t[]){
                                                       st7789v3->madctl_val,
                                                   },
                               1);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
 
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     // vendor specific initialization
     int cmd = 0;
     while (vendor_specific_init[cmd].data_bytes != 0xff)
@@ -258,7 +299,7 @@ static esp_err_t panel_st7789v3_init(esp_lcd_panel_t *panel)
         cmd++;
     }
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
     // Set display window
     uint8_t col_data[4] = {
         0x00, 0x00,
@@ -268,11 +309,11 @@ static esp_err_t panel_st7789v3_init(esp_lcd_panel_t *panel)
         0x00, 0x00,
         (uint8_t)((st7789v3->height - 1) >> 8),
         (uint8_t)(st7789v3->height - 1)};
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, col_data, 4);
     esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, row_data, 4);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
 
     return ESP_OK;
 }
@@ -289,31 +330,139 @@ static esp_err_t panel_st7789v3_draw_bitmap(esp_lcd_panel_t *panel, int x_start,
     y_start += st7789v3->y_gap;
     y_end += st7789v3->y_gap;
 
-    // define an area of frame memory where MCU can access
-    uint8_t col_data[4] = {
-        (uint8_t)(x_start >> 8),
-        (uint8_t)(x_start & 0xff),
-        (uint8_t)((x_end - 1) >> 8),
-        (uint8_t)((x_end - 1) & 0xff)};
-    uint8_t row_data[4] = {
-        (uint8_t)(y_start >> 8),
-        (uint8_t)(y_start & 0xff),
-        (uint8_t)((y_end - 1) >> 8),
-        (uint8_t)((y_end - 1) & 0xff)};
+    size_t len = (x_end - x_start) * (y_end - y_start) * st7789v3->fb_bits_per_pixel / 8;
+    esp_err_t ret = ESP_OK;
 
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
-    esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, col_data, 4);
-    esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, row_data, 4);
-    
-    xSemaphoreGive(spi_mutex); // 解锁
+    // The whole command sequence is issued under a single bus lock, so the SD card can't slip
+    // in between the address window and the pixel data.
+    // tx_color only queues the DMA transaction and returns, the panel IO reports completion
+    // through its on_color_trans_done callback, which lets the caller render into another
+    // buffer while this one is still on the wire.
+    int64_t lock_start = esp_timer_get_time();
+    LCD_BUS_LOCK(); // 加锁
+    st7789v3->stats.lock_wait_us += esp_timer_get_time() - lock_start;
+    st7789v3->stats.draw_calls++;
+    st7789v3->stats.bytes_sent += len;
+    if (st7789v3->window.valid && st7789v3->window.x_start == x_start && st7789v3->window.x_end == x_end &&
+            st7789v3->window.next_y == y_start) {
+        // This strip starts right where the previous one ended: the controller's address
+        // pointer is already there, so skip CASET/RASET and continue the memory write
+        st7789v3->stats.continued_writes++;
+        ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWRC, color_data, len), out, TAG, "queue RAMWRC failed");
+    } else {
+        // Leave the row range open to the end of the frame memory, so following strips
+        // of the same area can be continued without a new address window
+        int row_limit = (st7789v3->madctl_val & LCD_CMD_MV_BIT) ? ST7789V3_GRAM_COLS : ST7789V3_GRAM_ROWS;
+        if (y_end > row_limit) {
+            row_limit = y_end;
+        }
+        // define an area of frame memory where MCU can access
+        uint8_t col_data[4] = {
+            (uint8_t)(x_start >> 8),
+            (uint8_t)(x_start & 0xff),
+            (uint8_t)((x_end - 1) >> 8),
+            (uint8_t)((x_end - 1) & 0xff)};
+        uint8_t row_data[4] = {
+            (uint8_t)(y_start >> 8),
+            (uint8_t)(y_start & 0xff),
+            (uint8_t)((row_limit - 1) >> 8),
+            (uint8_t)((row_limit - 1) & 0xff)};
+        st7789v3->stats.window_sets++;
+        st7789v3_window_invalidate(st7789v3);
+        ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, col_data, 4), out, TAG, "send CASET failed");
+        ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, row_data, 4), out, TAG, "send RASET failed");
+        // transfer frame buffer
+        ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, color_data, len), out, TAG, "queue RAMWR failed");
+        st7789v3->window.x_start = x_start;
+        st7789v3->window.x_end = x_end;
+        st7789v3->window.valid = (y_end < row_limit);
+    }
+    st7789v3->window.next_y = y_end;
+out:
+    if (ret != ESP_OK) {
+        st7789v3_window_invalidate(st7789v3);
+    }
+    LCD_BUS_UNLOCK(); // 解锁
 
-    // transfer frame buffer
-    size_t len = (x_end - x_start) * (y_end - y_start) * st7789v3->fb_bits_per_pixel / 8;
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
-    esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, color_data, len);
-    
-    xSemaphoreGive(spi_mutex); // 解锁
+    return ret;
+}
+
+esp_err_t esp_lcd_st7789v3_get_stats(esp_lcd_panel_handle_t panel, esp_lcd_st7789v3_stats_t *stats, bool reset)
+{
+    ESP_RETURN_ON_FALSE(panel && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+
+    LCD_BUS_LOCK();
+    *stats = st7789v3->stats;
+    if (reset) {
+        memset(&st7789v3->stats, 0, sizeof(st7789v3->stats));
+    }
+    LCD_BUS_UNLOCK();
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7789v3_set_scroll_area(esp_lcd_panel_handle_t panel, int top, int height)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    ESP_RETURN_ON_FALSE(!(st7789v3->madctl_val & LCD_CMD_MV_BIT), ESP_ERR_NOT_SUPPORTED, TAG,
+                        "vertical scroll is not supported with swapped axes");
+
+    // The scroll area is given in the same row coordinates as draw_bitmap
+    top += st7789v3->y_gap;
+    ESP_RETURN_ON_FALSE(top >= 0 && height > 0 && top + height <= ST7789V3_GRAM_ROWS, ESP_ERR_INVALID_ARG, TAG,
+                        "scroll area out of frame memory");
+
+    // VSCRDEF refers to frame memory rows in scan order. With MY set the MCU rows are
+    // written bottom-up, so the fixed areas swap places.
+    if (st7789v3->madctl_val & LCD_CMD_MY_BIT) {
+        top = ST7789V3_GRAM_ROWS - (top + height);
+    }
+    int bottom = ST7789V3_GRAM_ROWS - (top + height);
+
+    LCD_BUS_LOCK(); // 加锁
+    esp_err_t ret = esp_lcd_panel_io_tx_param(st7789v3->io, LCD_CMD_VSCRDEF, (uint8_t[]) {
+        (uint8_t)(top >> 8), (uint8_t)(top & 0xff),
+        (uint8_t)(height >> 8), (uint8_t)(height & 0xff),
+        (uint8_t)(bottom >> 8), (uint8_t)(bottom & 0xff),
+    }, 6);
+    if (ret == ESP_OK) {
+        st7789v3->scroll.top = top;
+        st7789v3->scroll.height = height;
+        ret = esp_lcd_panel_io_tx_param(st7789v3->io, LCD_CMD_VSCSAD, (uint8_t[]) {
+            (uint8_t)(top >> 8), (uint8_t)(top & 0xff),
+        }, 2);
+    }
+    LCD_BUS_UNLOCK(); // 解锁
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "send scroll area failed");
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7789v3_scroll_to(esp_lcd_panel_handle_t panel, int offset)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    int height = st7789v3->scroll.height;
+    ESP_RETURN_ON_FALSE(height > 0, ESP_ERR_INVALID_STATE, TAG, "scroll area not set");
+
+    offset %= height;
+    if (offset < 0) {
+        offset += height;
+    }
+    // With MY set the rows run the other way in frame memory, so does the scroll offset
+    if ((st7789v3->madctl_val & LCD_CMD_MY_BIT) && offset) {
+        offset = height - offset;
+    }
+    int start = st7789v3->scroll.top + offset;
+
+    LCD_BUS_LOCK(); // 加锁
+    esp_err_t ret = esp_lcd_panel_io_tx_param(st7789v3->io, LCD_CMD_VSCSAD, (uint8_t[]) {
+        (uint8_t)(start >> 8), (uint8_t)(start & 0xff),
+    }, 2);
+    LCD_BUS_UNLOCK(); // 解锁
 
+    ESP_RETURN_ON_ERROR(ret, TAG, "send VSCSAD failed");
     return ESP_OK;
 }
 
@@ -321,6 +470,7 @@ static esp_err_t panel_st7789v3_invert_color(esp_lcd_panel_t *panel, bool invert
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
     esp_lcd_panel_io_handle_t io = st7789v3->io;
     int command = 0;
     if (invert_color_data)
@@ -332,10 +482,10 @@ static esp_err_t panel_st7789v3_invert_color(esp_lcd_panel_t *panel, bool invert
         command = LCD_CMD_INVOFF;
     }
 
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     esp_lcd_panel_io_tx_param(io, command, NULL, 0);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
     return ESP_OK;
 }
 
@@ -343,6 +493,7 @@ static esp_err_t panel_st7789v3_mirror(esp_lcd_panel_t *panel, bool mirror_x, bo
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
     esp_lcd_panel_io_handle_t io = st7789v3->io;
     if (mirror_x)
     {
@@ -360,10 +511,10 @@ static esp_err_t panel_st7789v3_mirror(esp_lcd_panel_t *panel, bool mirror_x, bo
     {
         st7789v3->madctl_val &= ~LCD_CMD_MY_BIT;
     }
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     esp_lcd_panel_io_tx_param(io, LCD_CMD_MADCTL, (uint8_t[]){st7789v3->madctl_val}, 1);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
     return ESP_OK;
 }
 
@@ -371,6 +522,7 @@ static esp_err_t panel_st7789v3_swap_xy(esp_lcd_panel_t *panel, bool swap_axes)
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
     esp_lcd_panel_io_handle_t io = st7789v3->io;
     if (swap_axes)
     {
@@ -380,10 +532,10 @@ static esp_err_t panel_st7789v3_swap_xy(esp_lcd_panel_t *panel, bool swap_axes)
     {
         st7789v3->madctl_val &= ~LCD_CMD_MV_BIT;
     }
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     esp_lcd_panel_io_tx_param(io, LCD_CMD_MADCTL, (uint8_t[]){st7789v3->madctl_val}, 1);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
     return ESP_OK;
 }
 
@@ -391,6 +543,7 @@ static esp_err_t panel_st7789v3_set_gap(esp_lcd_panel_t *panel, int x_gap, int y
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
     st7789v3->x_gap = x_gap;
     st7789v3->y_gap = y_gap;
 
@@ -401,6 +554,7 @@ static esp_err_t panel_st7789v3_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
 {
 
     st7789v3_panel_t *st7789v3 = __containerof(panel, st7789v3_panel_t, base);
+    st7789v3_window_invalidate(st7789v3);
     esp_lcd_panel_io_handle_t io = st7789v3->io;
     int command = 0;
 
@@ -416,9 +570,9 @@ static esp_err_t panel_st7789v3_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
     {
         command = LCD_CMD_DISPOFF;
     }
-    xSemaphoreTake(spi_mutex, portMAX_DELAY); // 加锁
+    LCD_BUS_LOCK(); // 加锁
     esp_lcd_panel_io_tx_param(io, command, NULL, 0);
     
-    xSemaphoreGive(spi_mutex); // 解锁
+    LCD_BUS_UNLOCK(); // 解锁
     return ESP_OK;
 }
\ No newline at end of file
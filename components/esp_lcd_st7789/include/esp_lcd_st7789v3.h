@@ -24,6 +24,61 @@ extern "C" {
  */
 esp_err_t esp_lcd_new_panel_st7789v3(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel);
 
+/**
+ * @brief Transfer statistics of an ST7789V3 panel
+ */
+typedef struct {
+    uint32_t draw_calls;        /*!< Number of draw_bitmap calls */
+    uint32_t window_sets;       /*!< Draws that had to send CASET/RASET + RAMWR */
+    uint32_t continued_writes;  /*!< Draws merged into the previous window with RAMWRC */
+    uint32_t bytes_sent;        /*!< Pixel bytes queued for transfer */
+    uint64_t lock_wait_us;      /*!< Time draw_bitmap spent waiting for the shared SPI bus */
+} esp_lcd_st7789v3_stats_t;
+
+/**
+ * @brief Read (and optionally reset) the transfer statistics of an ST7789V3 panel
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7789v3
+ * @param[out] stats Returned statistics
+ * @param[in] reset Clear the counters after reading them
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7789v3_get_stats(esp_lcd_panel_handle_t panel, esp_lcd_st7789v3_stats_t *stats, bool reset);
+
+/**
+ * @brief Define the vertical scroll area of an ST7789V3 panel (VSCRDEF)
+ *
+ * Rows outside the area stay fixed. The scroll offset is reset to 0.
+ *
+ * @note Rows use the same coordinates as esp_lcd_panel_draw_bitmap(), the panel gap and
+ *       mirror_y are taken into account. Not available when the axes are swapped.
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7789v3
+ * @param[in] top First row of the scroll area
+ * @param[in] height Number of rows in the scroll area
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the area is outside the frame memory
+ *          - ESP_ERR_NOT_SUPPORTED if swap_xy is enabled
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7789v3_set_scroll_area(esp_lcd_panel_handle_t panel, int top, int height);
+
+/**
+ * @brief Scroll the content of the scroll area (VSCSAD)
+ *
+ * With offset N the row at (top + N) of the scroll area is shown at its first line, rows wrap
+ * around at the end of the area. Only the start address is changed, no pixel data is sent.
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7789v3
+ * @param[in] offset Scroll offset in rows, taken modulo the scroll area height
+ * @return
+ *          - ESP_ERR_INVALID_STATE if no scroll area has been set
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7789v3_scroll_to(esp_lcd_panel_handle_t panel, int offset);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef LV_PORT_ANIM_H
+#define LV_PORT_ANIM_H
+
+#include <stdint.h>
+#include "lvgl.h"
+
+/*
+ * .anim 动画播放控件 (基于 lv_img)，文件由 tools/LVGLImage.py --ofmt ANIM 生成。
+ * 后台任务从 TF 卡读取下一帧变化的图块 (双缓冲)，LVGL 任务只复制并重绘这些图块，
+ * 播放开销和画面中运动的面积成正比，和图片尺寸无关。
+ * 播放结束 (达到文件中的循环次数) 时发送 LV_EVENT_READY。
+ * 只能在 LVGL 任务中或持有 lv_port_lock 时调用。
+ */
+
+typedef struct {
+    uint32_t loops;             // 已经完整播放的次数
+    uint16_t frame_count;
+    uint16_t tile;              // 图块边长 (像素)
+    uint32_t declared_ms;       // 上一遍文件声明的总时长
+    uint32_t actual_ms;         // 上一遍实际播放的时长
+    uint32_t late;              // 上一遍晚于预定时间显示的帧数
+    uint32_t tiles;             // 上一遍复制的图块数
+    uint32_t bytes;             // 上一遍从文件读取的字节数
+    uint32_t blit_avg_us;       // 上一遍每帧复制图块的平均耗时
+} lv_port_anim_stats_t;
+
+extern const lv_obj_class_t lv_port_anim_class;
+
+lv_obj_t *lv_port_anim_create(lv_obj_t *parent);
+
+/* path 是 LVGL 的文件路径，例如 "A:/anim/walk.anim" */
+lv_res_t lv_port_anim_set_src(lv_obj_t *obj, const char *path);
+
+void lv_port_anim_get_stats(lv_obj_t *obj, lv_port_anim_stats_t *stats);
+
+#endif /*LV_PORT_ANIM_H*/
@@ -3,13 +3,29 @@
 
 
 #include "esp_err.h"
+#include "lvgl.h"
 
 
-extern lv_display_t *lvgl_disp;
+extern lv_disp_t *lvgl_disp;
 
 esp_err_t app_lcd_init(void);
 esp_err_t app_lvgl_init(void);
 esp_err_t app_lcd_deinit(void);
 esp_err_t app_lvgl_deinit(void);
 
+/* 挂载 TF 卡，由 app_lcd_init 在面板初始化之前调用，失败时返回错误，界面照常运行 */
+esp_err_t app_sd_mount(void);
+
+/* TF 卡已挂载时建立目录索引，未挂载时返回 ESP_ERR_INVALID_STATE；由 lv_port_storage 的后台任务调用 */
+esp_err_t app_sd_build_index(void);
+
+/*
+ * 硬件垂直滚动 (CONFIG_APP_LCD_HW_SCROLL)。obj 必须横跨整个屏幕宽度，并且没有边框、背景透明
+ * (两者都会随内容一起被移动)，否则返回 ESP_ERR_INVALID_ARG。
+ * 滚动时由屏幕控制器移动已有内容，LVGL 只重绘新露出的行。同一时间只能有一个对象。
+ * 对象删除时自动解除。
+ */
+esp_err_t lv_port_disp_hw_scroll_attach(lv_obj_t *obj);
+void lv_port_disp_hw_scroll_detach(void);
+
 #endif /*LV_PORT_DISP_H*/
\ No newline at end of file
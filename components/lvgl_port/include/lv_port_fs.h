@@ -25,12 +25,38 @@ extern "C" {
 /**********************
  *      TYPEDEFS
  **********************/
+/* 文件和目录句柄池的使用情况 */
+typedef struct {
+    uint32_t files_in_use;
+    uint32_t files_peak;        // 同时打开的文件数的最大值
+    uint32_t files_exhausted;   // 句柄用完导致打开失败的次数
+    uint32_t dirs_in_use;
+    uint32_t dirs_peak;
+    uint32_t dirs_exhausted;
+} lv_port_fs_handle_stats_t;
 
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 void lv_port_fs_init(void);
 
+/* 文件的修改时间戳和大小，文件不在本文件注册的盘 (TF 卡或 LittleFS) 上或不存在时返回 false */
+bool lv_port_fs_file_info(const char *path, uint32_t *stamp, uint32_t *size);
+
+/* "A:/x" 或 "/sdcard/x" 转换成 FatFs 路径 "0:/x"，可在任意任务中调用 */
+bool lv_port_fs_fatfs_path(const char *path, char *buf, size_t size);
+
+/* 文件内容已在图片缓存中时返回整个文件的内存地址 */
+const uint8_t *lv_port_fs_mem(lv_fs_file_t *file, uint32_t *size);
+
+/* 释放文件在图片缓存中的拷贝，改为从卡上读取，例如文件只是用来解压的时候；失败时文件仍可从缓存读取 */
+bool lv_port_fs_uncache(lv_fs_file_t *file, const char *path);
+
+void lv_port_fs_get_handle_stats(lv_port_fs_handle_stats_t *out_stats);
+
+/* 把句柄池的使用情况打印到日志，用来调整 APP_FS_FILE_HANDLES / APP_FS_DIR_HANDLES */
+void lv_port_fs_dump_stats(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,41 @@
+#ifndef LV_PORT_GIF_H
+#define LV_PORT_GIF_H
+
+#include <stdint.h>
+#include "lvgl.h"
+
+/*
+ * GIF 动画播放控件 (基于 lv_img)。
+ * 每一帧只解码到一块复用的画布上，只重绘这一帧改变的区域；
+ * 解码后的帧在预算内缓存，循环播放时不再重复 LZW 解码。
+ * 播放结束 (达到 GIF 中的循环次数，没有 NETSCAPE 循环扩展时播放一次) 时发送 LV_EVENT_READY。
+ * 只能在 LVGL 任务中或持有 lv_port_lock 时调用。
+ */
+
+typedef struct {
+    uint32_t loops;             // 已经完整播放的次数
+    uint16_t frame_count;       // 动画的帧数 (第一遍播放完之前是已解码的帧数)
+    uint16_t cached_frames;     // 已缓存的帧数
+    uint32_t cache_bytes;
+    uint32_t declared_ms;       // 上一遍 GIF 声明的总时长
+    uint32_t actual_ms;         // 上一遍实际播放的时长
+    uint32_t decoded;           // 上一遍 LZW 解码的帧数
+    uint32_t cache_hits;        // 上一遍从缓存恢复的帧数
+    uint32_t late;              // 上一遍晚于预定时间显示的帧数
+    uint32_t decode_avg_us;     // 上一遍每帧解码的平均耗时
+    uint32_t decode_max_us;
+} lv_port_gif_stats_t;
+
+extern const lv_obj_class_t lv_port_gif_class;
+
+lv_obj_t *lv_port_gif_create(lv_obj_t *parent);
+
+/* path 是 LVGL 的文件路径，例如 "A:/littlefs/miho.gif" */
+lv_res_t lv_port_gif_set_src(lv_obj_t *obj, const char *path);
+
+/* 从第一帧重新开始播放 */
+void lv_port_gif_restart(lv_obj_t *obj);
+
+void lv_port_gif_get_stats(lv_obj_t *obj, lv_port_gif_stats_t *stats);
+
+#endif /*LV_PORT_GIF_H*/
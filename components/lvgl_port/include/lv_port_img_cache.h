@@ -0,0 +1,41 @@
+#ifndef LV_PORT_IMG_CACHE_H
+#define LV_PORT_IMG_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 图片资源的内存缓存 (CONFIG_APP_IMG_CACHE)。
+ * 以路径和文件修改时间为键，按字节数而不是条目数限制总大小，超出预算时淘汰最久没有使用的条目。
+ * 条目内容可以是文件原始数据，也可以是解码后的像素，由调用者决定。
+ *
+ * 拿到的数据在 release 之前不会被淘汰或释放。
+ */
+
+typedef struct img_cache_entry img_cache_entry_t;
+
+void img_cache_init(void);
+
+/* 查找条目，stamp 不一致 (文件被修改过) 的旧条目会被丢弃。找到时返回条目并增加引用 */
+img_cache_entry_t *img_cache_get(const char *key, uint32_t stamp);
+
+/*
+ * 为新条目分配 size 字节的空间，必要时淘汰旧条目。条目在 img_cache_commit 之前对其他调用者不可见。
+ * 空间不够 (超过预算或堆内存不足) 时返回 NULL，调用者应直接读文件。
+ */
+img_cache_entry_t *img_cache_alloc(const char *key, uint32_t stamp, size_t size);
+void img_cache_commit(img_cache_entry_t *entry);
+void img_cache_abort(img_cache_entry_t *entry);
+
+void img_cache_release(img_cache_entry_t *entry);
+
+uint8_t *img_cache_data(img_cache_entry_t *entry);
+size_t img_cache_size(img_cache_entry_t *entry);
+
+/* 文件被写入、删除或改名时调用 */
+void img_cache_invalidate(const char *key);
+
+void img_cache_dump_stats(void);
+
+#endif /*LV_PORT_IMG_CACHE_H*/
@@ -0,0 +1,12 @@
+#ifndef LV_PORT_IMG_DEC_H
+#define LV_PORT_IMG_DEC_H
+
+/*
+ * 文件图片 (.bin) 的行范围解码器。
+ * 只读取与重绘区域相交的行，文件在多次绘制之间保持打开，图片头缓存在内存中。
+ * 4/8 位索引色图片按行通过调色板查找表展开成 RGB565。
+ * 在 lv_init 和 lv_port_fs_init 之后调用。
+ */
+void lv_port_img_dec_init(void);
+
+#endif /*LV_PORT_IMG_DEC_H*/
@@ -0,0 +1,34 @@
+#ifndef LV_PORT_PACK_H
+#define LV_PORT_PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+/*
+ * TF 卡上的资源包 (tools/mkassets.py --files 生成)。
+ * 启动时打开一次，索引和名字表读入 RAM，之后查找文件只需要二分查找，
+ * 读取只需要在一直打开的包文件中定位，不再遍历 FAT 目录。
+ * 只能在 LVGL 任务中使用。
+ */
+
+typedef struct {
+    uint32_t hash;
+    uint32_t name_off;          // 在 RAM 名字表中的偏移
+    uint32_t offset;            // 在包文件中的偏移
+    uint32_t size;
+} lv_port_pack_entry_t;
+
+/* fatfs_path 是包文件的 FatFs 路径，例如 "0:/assets.pak" */
+bool lv_port_pack_open(const char *fatfs_path);
+
+/* name 是相对于 TF 卡根目录的路径，例如 "img/bg.bin"，不在包中时返回 NULL */
+const lv_port_pack_entry_t *lv_port_pack_find(const char *name);
+
+/* 从包中文件的 pos 处读取 */
+FRESULT lv_port_pack_read(const lv_port_pack_entry_t *e, uint32_t pos, void *buf, UINT btr, UINT *br);
+
+/* 包文件的修改时间，作为包中文件在图片缓存中的版本 */
+uint32_t lv_port_pack_stamp(void);
+
+#endif /*LV_PORT_PACK_H*/
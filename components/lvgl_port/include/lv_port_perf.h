@@ -0,0 +1,69 @@
+#ifndef LV_PORT_PERF_H
+#define LV_PORT_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_lcd_panel_ops.h"
+#include "sdkconfig.h"
+
+/*
+ * 显示性能统计 (CONFIG_APP_LCD_PERF)。
+ * 记录每帧的渲染时间、SPI 发送时间、等待总线锁的时间、发送字节数，以及按可达帧率统计的直方图，
+ * 定期 (CONFIG_APP_LCD_PERF_PERIOD_S，0 表示不定期输出) 以文本或单行 key=value 格式输出到串口，
+ * 也可以随时用 lv_port_perf_get / lv_port_perf_dump 读取。不在屏幕上绘制任何东西，不影响被测的刷新路径。
+ */
+
+#define LV_PORT_PERF_FPS_BINS   (7) // <10, 10-19, 20-29, 30-39, 40-49, 50-59, >=60 fps
+
+typedef struct {
+    uint32_t frames;            // 统计周期内完成的帧数
+    uint32_t period_ms;         // 统计周期长度
+    uint64_t render_us;         // LVGL 渲染时间合计 (不含 flush 回调本身)
+    uint32_t render_max_us;
+    uint64_t spi_us;            // SPI 实际占用时间合计
+    uint64_t frame_us;          // 从开始渲染到最后一个传输完成的时间合计
+    uint32_t frame_max_us;
+    uint64_t lock_wait_us;      // draw_bitmap 等待总线的时间合计
+    uint64_t bytes;             // 发送的像素字节数合计
+    uint32_t fps_hist[LV_PORT_PERF_FPS_BINS];
+} lv_port_perf_stats_t;
+
+#if CONFIG_APP_LCD_PERF
+
+/* 在 lv_init 之后调用，启动定期输出 */
+void lv_port_perf_init(esp_lcd_panel_handle_t panel);
+
+/* 刷新路径中的埋点 */
+void lv_port_perf_render_start(void);
+void lv_port_perf_flush_begin(void);
+void lv_port_perf_flush_end(void);
+void lv_port_perf_trans_queued(void);
+void lv_port_perf_trans_cancel(void);
+void lv_port_perf_trans_done_isr(void);
+void lv_port_perf_frame_done(void);
+
+/*
+ * 按需读取上次清零以来的统计，reset 为 true 时开始新的统计周期。
+ * 在 LVGL 任务中或持有 lv_port_lock 时调用。
+ */
+void lv_port_perf_get(lv_port_perf_stats_t *out, bool reset);
+
+/* 输出并清零统计，machine 为 true 时输出单行 "PERF key=value ..."，调用条件同 lv_port_perf_get */
+void lv_port_perf_dump(bool machine);
+
+#else
+
+static inline void lv_port_perf_init(esp_lcd_panel_handle_t panel) {}
+static inline void lv_port_perf_render_start(void) {}
+static inline void lv_port_perf_flush_begin(void) {}
+static inline void lv_port_perf_flush_end(void) {}
+static inline void lv_port_perf_trans_queued(void) {}
+static inline void lv_port_perf_trans_cancel(void) {}
+static inline void lv_port_perf_trans_done_isr(void) {}
+static inline void lv_port_perf_frame_done(void) {}
+static inline void lv_port_perf_get(lv_port_perf_stats_t *out, bool reset) { *out = (lv_port_perf_stats_t){0}; }
+static inline void lv_port_perf_dump(bool machine) {}
+
+#endif /* CONFIG_APP_LCD_PERF */
+
+#endif /*LV_PORT_PERF_H*/
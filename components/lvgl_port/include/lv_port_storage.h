@@ -0,0 +1,40 @@
+#ifndef LV_PORT_STORAGE_H
+#define LV_PORT_STORAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * 分阶段启动：显示屏和 LVGL 先初始化并显示 assets 分区中的图片，
+ * TF 卡在 app_lcd_init 中、LCD 传输之前挂载；LittleFS 注册和 TF 卡目录索引依次在后台任务中完成，各自结束后发出信号。
+ * 需要 TF 卡或 LittleFS 上资源的界面等待对应的信号，而不是假设启动时已经挂载。
+ */
+
+typedef enum {
+    LV_PORT_STORAGE_FLASH = (1 << 0),   // 内部 flash 上的 LittleFS ("/littlefs")
+    LV_PORT_STORAGE_SD = (1 << 1),      // TF 卡 ("/sdcard"，FatFs "0:")
+} lv_port_storage_t;
+
+/* 挂载结束后在 LVGL 任务中调用，mounted 表示挂载是否成功 */
+typedef void (*lv_port_storage_cb_t)(bool mounted, void *user_data);
+
+/* 启动后台挂载任务，SPI 总线初始化 (app_lcd_init) 之后调用 */
+esp_err_t lv_port_storage_start(void);
+
+/* 挂载已经结束且成功时返回 true，不等待，可在任意任务中调用 */
+bool lv_port_storage_ready(lv_port_storage_t which);
+
+/*
+ * 等待挂载结束，成功时返回 true；挂载失败或超时返回 false。timeout_ms 为 0 表示一直等待。
+ * 会阻塞，不能在 LVGL 任务或持有 lv_port_lock 时调用，界面代码使用 lv_port_storage_when_ready。
+ */
+bool lv_port_storage_wait(lv_port_storage_t which, uint32_t timeout_ms);
+
+/*
+ * which 中的存储都挂载结束后在 LVGL 任务中调用 cb，mounted 表示全部挂载成功。
+ * 已经结束时在下一次 lv_timer_handler 中调用。必须在 LVGL 任务中或持有 lv_port_lock 时调用。
+ */
+esp_err_t lv_port_storage_when_ready(lv_port_storage_t which, lv_port_storage_cb_t cb, void *user_data);
+
+#endif /*LV_PORT_STORAGE_H*/
@@ -1,8 +1,19 @@
 #ifndef LV_PORT_TICK_H
 #define LV_PORT_TICK_H
 
+#include <stdbool.h>
+#include "esp_err.h"
+#include <stdint.h>
+
 void lvgl_task(void *pvParameters);
 
+/* lvgl_task 之外访问 LVGL 前加锁，timeout_ms 为 0 表示一直等待。可以嵌套调用 */
+bool lv_port_lock(uint32_t timeout_ms);
+void lv_port_unlock(void);
+
+/* 有输入或数据到来时提前唤醒 LVGL 任务，不能在中断中调用 */
+void lv_port_wake(void);
+
 void i2c_master_init(void);
 esp_err_t sht4x_read(float *temperature, float *humidity);
 
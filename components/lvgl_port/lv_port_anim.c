@@ -0,0 +1,615 @@
+// lv_port_anim.c
+//
+// tools/LVGLImage.py --ofmt ANIM 生成的图块差分动画：
+//   文件头 | 帧索引 (frame_count + 1 项) | 每帧数据 (变化的图块列表 + 图块像素)
+// 第 0 项是第一帧的完整画面，之后每一项只有相对上一帧变化的图块，
+// 最后一项是从最后一帧回到第一帧的差分，循环播放时代替第 0 项。
+//
+// GIF 的调色板和 LZW 在 C3 上解码很慢，这个格式用 TF 卡带宽换 CPU：
+//   - 后台任务按播放顺序读取下一帧，两块缓冲轮流使用，读卡和界面刷新并行；
+//   - LVGL 任务到时间后只把变化的图块复制进画布，按行合并相邻图块后局部重绘；
+//   - 动画循环时不需要重新读取第一帧的完整画面。
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "safe_fatfs.h"
+#include "lv_port_fs.h"
+#include "lv_port_tick.h"
+#include "lv_port_anim.h"
+
+static const char *TAG = "anim";
+
+#define ANIM_MAGIC              (0x4D494E41)    // "ANIM"
+#define ANIM_VERSION            (1)
+#define ANIM_HEADER_SIZE        (32)
+#define ANIM_INDEX_ENTRY_SIZE   (12)
+#define ANIM_FLAG_SWAP16        (0x0001)
+#define ANIM_CF_RGB565          (0x12)
+#define ANIM_TILE_MAX           (64)
+
+#define ANIM_CHUNKS             (2)
+#define ANIM_CHUNK_BYTES        (CONFIG_APP_ANIM_BUF_KB * 1024)
+#define ANIM_CHUNK_TILES        (64)
+#define ANIM_READER_STACK       (3072)
+#define ANIM_READER_PRIO        (5)             // 低于 LVGL 任务
+#define ANIM_INV_RUNS_MAX       (8)             // 超过这么多段就重绘所有变化图块的外接矩形
+#define ANIM_WAIT_POLL_MS       (2)
+#define ANIM_LATE_TOLERANCE_MS  (10)
+#define ANIM_NAME_LEN           (24)
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+    uint16_t delay_ms;
+    uint16_t flags;
+} anim_entry_t;
+
+/* 读取任务交给 LVGL 任务的一块数据：同一帧中连续的若干个图块 */
+typedef struct {
+    uint8_t *buf;
+    uint16_t entry;
+    uint16_t count;
+    uint16_t idx[ANIM_CHUNK_TILES];
+    bool last;                  // 这一帧的最后一块
+    bool error;
+} anim_chunk_t;
+
+typedef struct {
+    lv_img_t img;
+    lv_img_dsc_t dsc;
+    lv_timer_t *timer;
+    char name[ANIM_NAME_LEN];
+    uint8_t *canvas;
+    uint16_t tile;
+    uint16_t cols;
+    uint16_t rows;
+    uint16_t frame_count;
+    uint16_t loop_limit;        // 0 表示无限循环
+    bool swap;                  // 文件中的字节序和 LV_COLOR_16_SWAP 不一致
+    anim_entry_t *index;
+    /* 读取任务 */
+    FIL *fil;                   // 内含 4 KB 扇区缓冲，放在堆上，不占 LVGL 内存池
+    bool file_open;
+    TaskHandle_t reader;
+    SemaphoreHandle_t reader_done;
+    QueueHandle_t free_q;
+    QueueHandle_t full_q;
+    anim_chunk_t chunks[ANIM_CHUNKS];
+    uint16_t *rd_idx;
+    volatile bool stop;
+    volatile uint32_t bytes_read;
+    /* 播放 */
+    bool started;
+    bool in_frame;              // 已经开始复制一帧的图块
+    uint16_t entry;
+    lv_area_t runs[ANIM_INV_RUNS_MAX];
+    uint8_t run_count;
+    bool runs_overflow;
+    lv_area_t bbox;
+    uint32_t next_due;
+    uint32_t loop_start;
+    uint32_t loop_declared;
+    uint32_t loop_frames;
+    uint32_t loop_late;
+    uint32_t loop_tiles;
+    uint32_t loop_bytes_start;
+    uint64_t loop_blit_us;
+    lv_port_anim_stats_t stats;
+} lv_port_anim_t;
+
+static void lv_port_anim_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void lv_port_anim_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+
+const lv_obj_class_t lv_port_anim_class = {
+    .constructor_cb = lv_port_anim_constructor,
+    .destructor_cb = lv_port_anim_destructor,
+    .instance_size = sizeof(lv_port_anim_t),
+    .base_class = &lv_img_class,
+};
+
+static uint32_t le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void anim_tile_area(const lv_port_anim_t *a, uint16_t idx, lv_area_t *r)
+{
+    r->x1 = (idx % a->cols) * a->tile;
+    r->y1 = (idx / a->cols) * a->tile;
+    r->x2 = LV_MIN(r->x1 + a->tile, (int32_t)a->dsc.header.w) - 1;
+    r->y2 = LV_MIN(r->y1 + a->tile, (int32_t)a->dsc.header.h) - 1;
+}
+
+static uint32_t anim_tile_bytes(const lv_port_anim_t *a, uint16_t idx)
+{
+    lv_area_t r;
+    anim_tile_area(a, idx, &r);
+    return lv_area_get_size(&r) * sizeof(lv_color_t);
+}
+
+/* 播放顺序：0, 1, ..., n-1, n (回到第一帧), 1, ..., n-1, n, ... */
+static uint16_t anim_next_entry(const lv_port_anim_t *a, uint16_t entry)
+{
+    if (entry < a->frame_count) {
+        return entry + 1;
+    }
+    return (a->frame_count > 1) ? 1 : entry;
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 读取任务
+ * ---------------------------------------------------------------------------
+ */
+
+static bool anim_read(lv_port_anim_t *a, void *buf, uint32_t n)
+{
+    UINT br = 0;
+    if (n == 0) {
+        return true;
+    }
+    if (safe_f_read(a->fil, buf, n, &br) != FR_OK || br != n) {
+        return false;
+    }
+    a->bytes_read += n;
+    return true;
+}
+
+/* 读取一帧的图块列表，文件位置停在第一个图块的像素上 */
+static bool anim_read_tile_list(lv_port_anim_t *a, const anim_entry_t *e, uint16_t *count)
+{
+    uint8_t hdr[4];
+    if (safe_f_lseek(a->fil, e->offset) != FR_OK || !anim_read(a, hdr, sizeof(hdr))) {
+        return false;
+    }
+    uint16_t n = le16(hdr);
+    if (n > a->cols * a->rows || !anim_read(a, a->rd_idx, n * sizeof(uint16_t))) {
+        return false;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (a->rd_idx[i] >= a->cols * a->rows) {
+            return false;
+        }
+    }
+    uint32_t list_bytes = (sizeof(hdr) + n * sizeof(uint16_t) + 3) & ~3u;
+    if (list_bytes != sizeof(hdr) + n * sizeof(uint16_t) &&
+            safe_f_lseek(a->fil, e->offset + list_bytes) != FR_OK) {
+        return false;
+    }
+    *count = n;
+    return true;
+}
+
+static void anim_reader_task(void *arg)
+{
+    lv_port_anim_t *a = arg;
+    uint16_t entry = 0;
+    bool ok = true;
+
+    while (ok && !a->stop) {
+        uint16_t n = 0;
+        uint16_t t = 0;
+        ok = anim_read_tile_list(a, &a->index[entry], &n);
+
+        while (!a->stop) {
+            anim_chunk_t *c;
+            if (xQueueReceive(a->free_q, &c, pdMS_TO_TICKS(50)) != pdTRUE) {
+                continue;
+            }
+            // 一块缓冲中放尽量多的完整图块，像素在文件中是连续的，一次读完
+            uint32_t bytes = 0;
+            c->count = 0;
+            while (ok && t < n && c->count < ANIM_CHUNK_TILES) {
+                uint32_t tb = anim_tile_bytes(a, a->rd_idx[t]);
+                if (bytes + tb > ANIM_CHUNK_BYTES) {
+                    break;
+                }
+                c->idx[c->count++] = a->rd_idx[t++];
+                bytes += tb;
+            }
+            ok = ok && anim_read(a, c->buf, bytes);
+            c->entry = entry;
+            c->error = !ok;
+            c->last = !ok || t >= n;
+            xQueueSend(a->full_q, &c, portMAX_DELAY);
+            lv_port_wake();
+            if (c->last) {
+                break;
+            }
+        }
+        entry = anim_next_entry(a, entry);
+    }
+
+    // 出错时等播放器关闭
+    while (!a->stop) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    xSemaphoreGive(a->reader_done);
+    vTaskDelete(NULL);
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 播放 (LVGL 任务)
+ * ---------------------------------------------------------------------------
+ */
+
+static void anim_invalidate(lv_obj_t *obj, const lv_area_t *a)
+{
+    lv_img_t *img = (lv_img_t *)obj;
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+
+    // 缩放、旋转或平铺时图块和屏幕区域不是简单的平移关系，重绘整个控件
+    if (img->zoom != LV_IMG_ZOOM_NONE || img->angle != 0 || img->offset.x || img->offset.y ||
+            lv_area_get_width(&content) != img->w || lv_area_get_height(&content) != img->h) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+    lv_area_t abs = *a;
+    lv_area_move(&abs, content.x1, content.y1);
+    lv_obj_invalidate_area(obj, &abs);
+}
+
+/* 记录变化的图块，同一行中相邻的图块合并成一段 */
+static void anim_mark(lv_port_anim_t *a, const lv_area_t *r)
+{
+    if (a->run_count == 0 && !a->runs_overflow) {
+        a->bbox = *r;
+    } else {
+        _lv_area_join(&a->bbox, &a->bbox, r);
+    }
+
+    lv_area_t *last = a->run_count ? &a->runs[a->run_count - 1] : NULL;
+    if (last && last->y1 == r->y1 && last->y2 == r->y2 && last->x2 + 1 == r->x1) {
+        last->x2 = r->x2;
+    } else if (a->run_count < ANIM_INV_RUNS_MAX) {
+        a->runs[a->run_count++] = *r;
+    } else {
+        a->runs_overflow = true;
+    }
+}
+
+static void anim_blit(lv_port_anim_t *a, const anim_chunk_t *c)
+{
+    const uint32_t stride = a->dsc.header.w * sizeof(lv_color_t);
+    const uint8_t *src = c->buf;
+
+    for (uint16_t i = 0; i < c->count; i++) {
+        lv_area_t r;
+        anim_tile_area(a, c->idx[i], &r);
+        const uint32_t row_bytes = lv_area_get_width(&r) * sizeof(lv_color_t);
+        uint8_t *dst = a->canvas + r.y1 * stride + r.x1 * sizeof(lv_color_t);
+
+        for (lv_coord_t y = r.y1; y <= r.y2; y++) {
+            if (a->swap) {
+                for (uint32_t k = 0; k < row_bytes; k += 2) {
+                    dst[k] = src[k + 1];
+                    dst[k + 1] = src[k];
+                }
+            } else {
+                memcpy(dst, src, row_bytes);
+            }
+            dst += stride;
+            src += row_bytes;
+        }
+        anim_mark(a, &r);
+    }
+    a->loop_tiles += c->count;
+}
+
+static void anim_loop_done(lv_port_anim_t *a)
+{
+    lv_port_anim_stats_t *st = &a->stats;
+    uint32_t bytes = a->bytes_read;
+
+    st->loops++;
+    st->declared_ms = a->loop_declared;
+    st->actual_ms = lv_tick_elaps(a->loop_start);
+    st->late = a->loop_late;
+    st->tiles = a->loop_tiles;
+    st->bytes = bytes - a->loop_bytes_start;
+    st->blit_avg_us = a->loop_frames ? (uint32_t)(a->loop_blit_us / a->loop_frames) : 0;
+
+#if CONFIG_APP_ANIM_STATS
+    uint32_t fps10 = st->actual_ms ? a->loop_frames * 10000 / st->actual_ms : 0;
+    uint32_t want10 = st->declared_ms ? a->loop_frames * 10000 / st->declared_ms : 0;
+    ESP_LOGI(TAG, "%s loop %" PRIu32 ": %" PRIu32 " frames in %" PRIu32 " ms (declared %" PRIu32 " ms), "
+             "%" PRIu32 ".%" PRIu32 " fps vs %" PRIu32 ".%" PRIu32 " fps, late %" PRIu32 ", "
+             "%" PRIu32 " tiles, %" PRIu32 " KB read, blit avg %" PRIu32 " us",
+             a->name, st->loops, a->loop_frames, st->actual_ms, st->declared_ms,
+             fps10 / 10, fps10 % 10, want10 / 10, want10 % 10, st->late,
+             st->tiles, st->bytes / 1024, st->blit_avg_us);
+#endif
+
+    a->loop_declared = 0;
+    a->loop_frames = 0;
+    a->loop_late = 0;
+    a->loop_tiles = 0;
+    a->loop_blit_us = 0;
+    a->loop_bytes_start = bytes;
+}
+
+/* 开始复制一帧。返回 false 表示已经播放了文件要求的次数 */
+static bool anim_frame_begin(lv_port_anim_t *a, uint16_t entry)
+{
+    if (entry == 0 || entry == a->frame_count) {
+        if (a->started) {
+            anim_loop_done(a);
+            if (a->loop_limit && a->stats.loops >= a->loop_limit) {
+                return false;
+            }
+        }
+        a->loop_start = lv_tick_get();
+    }
+    a->in_frame = true;
+    a->entry = entry;
+    a->run_count = 0;
+    a->runs_overflow = false;
+    return true;
+}
+
+static void anim_frame_end(lv_port_anim_t *a, uint32_t now)
+{
+    lv_obj_t *obj = (lv_obj_t *)a;
+
+    if (a->runs_overflow) {
+        anim_invalidate(obj, &a->bbox);
+    } else {
+        for (uint8_t i = 0; i < a->run_count; i++) {
+            anim_invalidate(obj, &a->runs[i]);
+        }
+    }
+    a->in_frame = false;
+
+    // 按声明的延时排定下一帧；已经晚了就从现在重新计时
+    const anim_entry_t *e = &a->index[a->entry];
+    if (!a->started) {
+        a->started = true;
+        a->next_due = now;
+    } else if ((int32_t)(now - a->next_due) > ANIM_LATE_TOLERANCE_MS) {
+        a->loop_late++;
+        a->next_due = now;
+    }
+    a->next_due += e->delay_ms;
+    a->loop_declared += e->delay_ms;
+    a->loop_frames++;
+    int32_t period = (int32_t)(a->next_due - now);
+    lv_timer_set_period(a->timer, LV_MAX(period, 1));
+}
+
+static void anim_timer_cb(lv_timer_t *t)
+{
+    lv_obj_t *obj = t->user_data;
+    lv_port_anim_t *a = (lv_port_anim_t *)obj;
+    uint32_t now = lv_tick_get();
+    anim_chunk_t *c;
+
+    while (xQueueReceive(a->full_q, &c, 0) == pdTRUE) {
+        if (!a->in_frame && !anim_frame_begin(a, c->entry)) {
+            xQueueSend(a->free_q, &c, 0);
+            a->stop = true;
+            lv_timer_pause(t);
+            lv_event_send(obj, LV_EVENT_READY, NULL);
+            return;
+        }
+
+        bool last = c->last;
+        bool error = c->error;
+        if (!error) {
+            int64_t t0 = esp_timer_get_time();
+            anim_blit(a, c);
+            a->loop_blit_us += esp_timer_get_time() - t0;
+        }
+        xQueueSend(a->free_q, &c, 0);
+
+        if (error) {
+            ESP_LOGE(TAG, "%s: read failed at frame %u", a->name, a->entry);
+            a->in_frame = false;
+            lv_timer_pause(t);
+            return;
+        }
+        if (last) {
+            anim_frame_end(a, now);
+            return;
+        }
+    }
+
+    // 这一帧还没有读完，读取任务放入数据后会唤醒 LVGL 任务
+    lv_timer_set_period(t, ANIM_WAIT_POLL_MS);
+}
+
+static void anim_close(lv_port_anim_t *a)
+{
+    if (a->timer) {
+        lv_timer_pause(a->timer);
+    }
+    if (a->reader) {
+        a->stop = true;
+        xSemaphoreTake(a->reader_done, portMAX_DELAY);
+        a->reader = NULL;
+    }
+    if (a->file_open) {
+        safe_f_close(a->fil);
+        a->file_open = false;
+    }
+    if (a->free_q) {
+        vQueueDelete(a->free_q);
+        a->free_q = NULL;
+    }
+    if (a->full_q) {
+        vQueueDelete(a->full_q);
+        a->full_q = NULL;
+    }
+    if (a->reader_done) {
+        vSemaphoreDelete(a->reader_done);
+        a->reader_done = NULL;
+    }
+    for (int i = 0; i < ANIM_CHUNKS; i++) {
+        free(a->chunks[i].buf);
+        a->chunks[i].buf = NULL;
+    }
+    free(a->rd_idx);
+    a->rd_idx = NULL;
+    free(a->index);
+    a->index = NULL;
+    lv_img_cache_invalidate_src(&a->dsc);
+    free(a->canvas);
+    a->canvas = NULL;
+    a->dsc.data = NULL;
+    memset(&a->stats, 0, sizeof(a->stats));
+}
+
+/* 读取文件头和帧索引 */
+static lv_res_t anim_load_header(lv_port_anim_t *a, const char *path)
+{
+    uint8_t h[ANIM_HEADER_SIZE];
+    UINT br = 0;
+
+    if (safe_f_read(a->fil, h, sizeof(h), &br) != FR_OK || br != sizeof(h) ||
+            le32(h) != ANIM_MAGIC || h[4] != ANIM_VERSION || h[5] != ANIM_CF_RGB565) {
+        ESP_LOGE(TAG, "%s is not an RGB565 .anim v%d file", path, ANIM_VERSION);
+        return LV_RES_INV;
+    }
+    uint16_t w = le16(h + 8);
+    uint16_t hh = le16(h + 10);
+    a->tile = le16(h + 12);
+    a->frame_count = le16(h + 14);
+    a->loop_limit = le16(h + 16);
+    a->swap = ((le16(h + 6) & ANIM_FLAG_SWAP16) != 0) != LV_COLOR_16_SWAP;
+    if (w == 0 || hh == 0 || a->frame_count == 0 || a->tile == 0 || a->tile > ANIM_TILE_MAX ||
+            a->tile * a->tile * sizeof(lv_color_t) > ANIM_CHUNK_BYTES) {
+        ESP_LOGE(TAG, "%s: unsupported %ux%u, tile %u, %u frames", path, w, hh, a->tile, a->frame_count);
+        return LV_RES_INV;
+    }
+    a->cols = (w + a->tile - 1) / a->tile;
+    a->rows = (hh + a->tile - 1) / a->tile;
+    a->dsc.header.always_zero = 0;
+    a->dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+    a->dsc.header.w = w;
+    a->dsc.header.h = hh;
+    a->dsc.data_size = (uint32_t)w * hh * sizeof(lv_color_t);
+
+    uint32_t entries = a->frame_count + 1;
+    uint8_t *raw = malloc(entries * ANIM_INDEX_ENTRY_SIZE);
+    a->index = malloc(entries * sizeof(anim_entry_t));
+    bool ok = raw && a->index && safe_f_lseek(a->fil, le32(h + 20)) == FR_OK &&
+              safe_f_read(a->fil, raw, entries * ANIM_INDEX_ENTRY_SIZE, &br) == FR_OK &&
+              br == entries * ANIM_INDEX_ENTRY_SIZE;
+    for (uint32_t i = 0; ok && i < entries; i++) {
+        const uint8_t *p = raw + i * ANIM_INDEX_ENTRY_SIZE;
+        a->index[i].offset = le32(p);
+        a->index[i].size = le32(p + 4);
+        a->index[i].delay_ms = LV_MAX(le16(p + 8), 1);
+        a->index[i].flags = le16(p + 10);
+    }
+    free(raw);
+    return ok ? LV_RES_OK : LV_RES_INV;
+}
+
+lv_obj_t *lv_port_anim_create(lv_obj_t *parent)
+{
+    lv_obj_t *obj = lv_obj_class_create_obj(&lv_port_anim_class, parent);
+    lv_obj_class_init_obj(obj);
+    return obj;
+}
+
+lv_res_t lv_port_anim_set_src(lv_obj_t *obj, const char *path)
+{
+    lv_port_anim_t *a = (lv_port_anim_t *)obj;
+    char fatfs_path[LV_FS_MAX_PATH_LENGTH + 8];
+
+    anim_close(a);
+    strlcpy(a->name, lv_fs_get_last(path), sizeof(a->name));
+    lv_port_fs_fatfs_path(path, fatfs_path, sizeof(fatfs_path));
+    if (a->fil == NULL || safe_f_open(a->fil, fatfs_path, FA_READ) != FR_OK) {
+        ESP_LOGE(TAG, "open %s failed", path);
+        return LV_RES_INV;
+    }
+    a->file_open = true;
+    if (anim_load_header(a, path) != LV_RES_OK) {
+        anim_close(a);
+        return LV_RES_INV;
+    }
+
+    a->canvas = calloc(1, a->dsc.data_size);
+    a->rd_idx = malloc(a->cols * a->rows * sizeof(uint16_t));
+    a->free_q = xQueueCreate(ANIM_CHUNKS, sizeof(anim_chunk_t *));
+    a->full_q = xQueueCreate(ANIM_CHUNKS, sizeof(anim_chunk_t *));
+    a->reader_done = xSemaphoreCreateBinary();
+    bool ok = a->canvas && a->rd_idx && a->free_q && a->full_q && a->reader_done;
+    for (int i = 0; ok && i < ANIM_CHUNKS; i++) {
+        anim_chunk_t *c = &a->chunks[i];
+        c->buf = malloc(ANIM_CHUNK_BYTES);
+        ok = c->buf != NULL;
+        if (ok) {
+            xQueueSend(a->free_q, &c, 0);
+        }
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "%s: no mem for %ux%u canvas", path, a->dsc.header.w, a->dsc.header.h);
+        anim_close(a);
+        return LV_RES_INV;
+    }
+    a->dsc.data = a->canvas;
+    lv_img_set_src(obj, &a->dsc);
+
+    a->stop = false;
+    a->bytes_read = 0;
+    a->started = false;
+    a->in_frame = false;
+    a->loop_declared = 0;
+    a->loop_frames = 0;
+    a->loop_late = 0;
+    a->loop_tiles = 0;
+    a->loop_blit_us = 0;
+    a->loop_bytes_start = 0;
+    a->stats.frame_count = a->frame_count;
+    a->stats.tile = a->tile;
+
+    if (xTaskCreate(anim_reader_task, "anim_rd", ANIM_READER_STACK, a, ANIM_READER_PRIO, &a->reader) != pdPASS) {
+        a->reader = NULL;
+        anim_close(a);
+        return LV_RES_INV;
+    }
+    lv_timer_set_period(a->timer, 1);
+    lv_timer_reset(a->timer);
+    lv_timer_resume(a->timer);
+    return LV_RES_OK;
+}
+
+void lv_port_anim_get_stats(lv_obj_t *obj, lv_port_anim_stats_t *stats)
+{
+    *stats = ((lv_port_anim_t *)obj)->stats;
+}
+
+static void lv_port_anim_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+    lv_port_anim_t *a = (lv_port_anim_t *)obj;
+    a->fil = malloc(sizeof(FIL)); // 失败时 set_src 报错
+    a->timer = lv_timer_create(anim_timer_cb, 1, obj);
+    lv_timer_pause(a->timer);
+}
+
+static void lv_port_anim_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+    lv_port_anim_t *a = (lv_port_anim_t *)obj;
+    anim_close(a);
+    lv_timer_del(a->timer);
+    a->timer = NULL;
+    free(a->fil);
+    a->fil = NULL;
+}
@@ -1,6 +1,8 @@
 #include <string.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
 #include "esp_err.h"
@@ -10,13 +12,21 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "driver/ledc.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "spi_bus_sched.h"
+#include "safe_fatfs.h"
+#include <inttypes.h>
+#include <stdatomic.h>
 
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
-#include "esp_lvgl_port.h"
 #include "esp_lcd_st7789v3.h"
 #include "lv_port_disp.h"
+#include "lv_port_perf.h"
 
 /* LCD size */
 #define EXAMPLE_LCD_H_RES   (240)
@@ -29,8 +39,9 @@
 #define EXAMPLE_LCD_PARAM_BITS      (8)
 #define EXAMPLE_LCD_COLOR_SPACE     (ESP_LCD_COLOR_SPACE_RGB)
 #define EXAMPLE_LCD_BITS_PER_PIXEL  (16)
-#define EXAMPLE_LCD_DRAW_BUFF_DOUBLE (1)
-#define EXAMPLE_LCD_DRAW_BUFF_HEIGHT (5)
+#define EXAMPLE_LCD_DRAW_BUFF_COUNT  (CONFIG_APP_LCD_DRAW_BUFF_COUNT)
+#define EXAMPLE_LCD_DRAW_BUFF_HEIGHT (CONFIG_APP_LCD_DRAW_BUFF_HEIGHT)
+#define EXAMPLE_LCD_DRAW_BUFF_MIN_HEIGHT (5)
 
 /* LCD pins */
 #define EXAMPLE_LCD_GPIO_SCLK       (GPIO_NUM_7)
@@ -63,15 +74,703 @@ static char *TAG = "lv_port_disp";
 static esp_lcd_panel_io_handle_t lcd_io = NULL;
 static esp_lcd_panel_handle_t lcd_panel = NULL;
 
+/* TF 卡 */
+static bool sd_mounted = false;
+
 /* LVGL display and touch */
-lv_display_t *lvgl_disp = NULL;
+lv_disp_t *lvgl_disp = NULL;
+
+/* LVGL 显示驱动和双 DMA 绘制缓冲 */
+static lv_disp_drv_t disp_drv;
+static lv_disp_draw_buf_t disp_draw_buf;
+static lv_color_t *disp_buf1 = NULL;
+static lv_color_t *disp_buf2 = NULL;
+static size_t disp_buf_lines = EXAMPLE_LCD_DRAW_BUFF_HEIGHT; // 实际使用的绘制缓冲高度 (行)
+
+/*
+ * 确定绘制缓冲高度。自动模式下按当前最大可用 DMA 内存块的一定比例计算，
+ * 以 Kconfig 中的高度为上限。SPI 总线的 max_transfer_sz 也由这个值决定，
+ * 所以必须在 spi_bus_initialize 之前调用。
+ */
+static size_t lcd_draw_buf_lines(void)
+{
+#if CONFIG_APP_LCD_RENDER_DIRECT
+    // 直接模式下单次传输最多是一行块 (16 行)
+    return 16;
+#elif CONFIG_APP_LCD_DRAW_BUFF_AUTO
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+    size_t budget = largest / 100 * CONFIG_APP_LCD_DRAW_BUFF_HEAP_PERCENT;
+    size_t lines = budget / (EXAMPLE_LCD_DRAW_BUFF_COUNT * EXAMPLE_LCD_H_RES * sizeof(lv_color_t));
+    if (lines > EXAMPLE_LCD_DRAW_BUFF_HEIGHT) {
+        lines = EXAMPLE_LCD_DRAW_BUFF_HEIGHT;
+    }
+    if (lines < EXAMPLE_LCD_DRAW_BUFF_MIN_HEIGHT) {
+        lines = EXAMPLE_LCD_DRAW_BUFF_MIN_HEIGHT;
+    }
+    ESP_LOGI(TAG, "Draw buffer auto size: %u lines x %d (largest DMA block %u bytes)",
+             (unsigned)lines, EXAMPLE_LCD_DRAW_BUFF_COUNT, (unsigned)largest);
+    return lines;
+#else
+    return EXAMPLE_LCD_DRAW_BUFF_HEIGHT;
+#endif
+}
+
+#if CONFIG_APP_LCD_FLUSH_STATS
+#define LCD_FLUSH_STATS_FRAMES  (100)
+
+/* 统计每帧的命令开销：strip 数、需要重新设置地址窗口的次数、用 RAMWRC 合并的次数 */
+static void lcd_flush_stats_frame_done(esp_lcd_panel_handle_t panel)
+{
+    static uint32_t frames;
+    static esp_lcd_st7789v3_stats_t last;
+    esp_lcd_st7789v3_stats_t st;
+
+    if (++frames < LCD_FLUSH_STATS_FRAMES) {
+        return;
+    }
+    // 驱动计数器不清零 (性能统计也在读)，这里取两次输出之间的差值
+    esp_lcd_st7789v3_get_stats(panel, &st, false);
+    esp_lcd_st7789v3_stats_t acc = {
+        .draw_calls = st.draw_calls - last.draw_calls,
+        .window_sets = st.window_sets - last.window_sets,
+        .continued_writes = st.continued_writes - last.continued_writes,
+        .bytes_sent = st.bytes_sent - last.bytes_sent,
+    };
+    last = st;
+
+    // 每个新窗口: CASET(1+4) + RASET(1+4) + RAMWR(1) 共 3 个事务，合并的 strip 只需 RAMWRC 1 个事务
+    uint32_t cmd_trans = acc.window_sets * 3 + acc.continued_writes;
+    ESP_LOGI(TAG, "per frame: %.1f strips, %.1f windows, %.1f merged, %.1f cmd transactions, %.1f KB pixels (buf %u lines)",
+             (float)acc.draw_calls / frames, (float)acc.window_sets / frames,
+             (float)acc.continued_writes / frames, (float)cmd_trans / frames,
+             (float)acc.bytes_sent / frames / 1024, (unsigned)disp_buf_lines);
+    frames = 0;
+}
+#endif
+
+/* 刷新区域拆分后在显存中连续的一段行 */
+typedef struct {
+    int y1;     // 起始行 (LVGL 坐标)
+    int y2;     // 结束行 (不含)
+    int phys;   // 起始行在显存中的位置
+} lcd_row_seg_t;
+
+#define LCD_ROW_SEGS_MAX    (4)
+
+/* 当前 flush 还没有发送完成的段数 */
+static atomic_int flush_trans_pending;
+
+#if CONFIG_APP_LCD_HW_SCROLL
+/*
+ * ---------------------------------------------------------------------------
+ * 硬件垂直滚动：把一个横跨整屏宽度的可滚动对象 (列表、长文本容器) 所在的行设为
+ * ST7789 的滚动区。对象滚动时只修改 VSCSAD 滚动起始地址，屏幕上已有的内容由控制器
+ * 移动，LVGL 只需要渲染新露出来的几行。
+ *
+ * 滚动区内 LVGL 坐标的第 y 行，保存在显存的 top + ((y - top + offset) % height) 行，
+ * 刷新时按这个映射把 strip 拆开发送。
+ * ---------------------------------------------------------------------------
+ */
+static struct {
+    lv_obj_t *obj;
+    int top;                // 滚动区第一行 (LVGL 坐标)
+    int height;             // 滚动区行数
+    int offset;             // 当前滚动偏移，0..height-1
+    int applied_offset;     // 已经写入 VSCSAD 的偏移
+    int pending_dy;         // 本帧累计的滚动量，决定需要重绘的行数
+    bool clip_next;         // 下一次整区失效来自滚动，可以裁剪成新露出的行
+    lv_coord_t last_scroll_y;
+} hw_scroll;
+
+static void lcd_hw_scroll_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+
+    if (lv_event_get_code(e) == LV_EVENT_DELETE) {
+        lv_port_disp_hw_scroll_detach();
+        return;
+    }
+
+    lv_coord_t scroll_y = lv_obj_get_scroll_y(obj);
+    int dy = scroll_y - hw_scroll.last_scroll_y;
+    hw_scroll.last_scroll_y = scroll_y;
+    if (dy == 0) {
+        return;
+    }
+
+    // 内容上移 dy 行，显存中的内容保持不动，只把滚动起点后移 dy 行
+    hw_scroll.offset = ((hw_scroll.offset + dy) % hw_scroll.height + hw_scroll.height) % hw_scroll.height;
+    hw_scroll.pending_dy += dy;
+    // LVGL 发送 LV_EVENT_SCROLL 之后紧接着会使整个对象失效
+    hw_scroll.clip_next = true;
+}
+
+/* 把滚动引起的整区失效缩小到新露出的行 */
+static void lcd_hw_scroll_rounder_cb(lv_disp_drv_t *drv, lv_area_t *area)
+{
+    if (!hw_scroll.obj || !hw_scroll.clip_next) {
+        return;
+    }
+    int bottom = hw_scroll.top + hw_scroll.height - 1;
+    if (area->x1 > 0 || area->x2 < EXAMPLE_LCD_H_RES - 1 || area->y1 > hw_scroll.top || area->y2 < bottom) {
+        return;
+    }
+    hw_scroll.clip_next = false;
+
+    int exposed = LV_ABS(hw_scroll.pending_dy);
+    if (exposed == 0) {
+        return; // 本帧内来回滚动抵消，没有新露出的行，按原区域重绘
+    }
+    if (exposed >= hw_scroll.height) {
+        return; // 滚动超过一整屏，全部重绘
+    }
+    // 滚动区以外的部分 (如果有) 不能裁掉，只有刚好是滚动区时才缩小
+    if (area->y1 != hw_scroll.top || area->y2 != bottom) {
+        return;
+    }
+    if (hw_scroll.pending_dy > 0) {
+        area->y1 = bottom - exposed + 1;
+    } else {
+        area->y2 = hw_scroll.top + exposed - 1;
+    }
+}
+
+esp_err_t lv_port_disp_hw_scroll_attach(lv_obj_t *obj)
+{
+    ESP_RETURN_ON_FALSE(obj && lcd_panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(hw_scroll.obj == NULL, ESP_ERR_INVALID_STATE, TAG, "hw scroll already attached");
+
+    lv_obj_update_layout(obj);
+    lv_area_t coords;
+    lv_obj_get_coords(obj, &coords);
+    // 硬件只能整行滚动，对象必须横跨整个屏幕宽度
+    ESP_RETURN_ON_FALSE(coords.x1 <= 0 && coords.x2 >= EXAMPLE_LCD_H_RES - 1, ESP_ERR_INVALID_ARG, TAG,
+                        "hw scroll object must span the full width");
+    int top = LV_MAX(coords.y1, 0);
+    int height = LV_MIN(coords.y2, EXAMPLE_LCD_V_RES - 1) - top + 1;
+    ESP_RETURN_ON_FALSE(height > 1, ESP_ERR_INVALID_ARG, TAG, "hw scroll object is off screen");
+    // 对象自身的边框和背景也会被控制器随内容一起移动，只接受两者都没有的对象
+    bool border = lv_obj_get_style_border_width(obj, LV_PART_MAIN) > 0 &&
+                  lv_obj_get_style_border_opa(obj, LV_PART_MAIN) > LV_OPA_TRANSP &&
+                  lv_obj_get_style_border_side(obj, LV_PART_MAIN) != LV_BORDER_SIDE_NONE;
+    ESP_RETURN_ON_FALSE(!border, ESP_ERR_INVALID_ARG, TAG, "hw scroll object must not have a border");
+    ESP_RETURN_ON_FALSE(lv_obj_get_style_bg_opa(obj, LV_PART_MAIN) == LV_OPA_TRANSP, ESP_ERR_INVALID_ARG, TAG,
+                        "hw scroll object must have a transparent background");
+
+    ESP_RETURN_ON_ERROR(esp_lcd_st7789v3_set_scroll_area(lcd_panel, top, height), TAG, "set scroll area failed");
+
+    hw_scroll.obj = obj;
+    hw_scroll.top = top;
+    hw_scroll.height = height;
+    hw_scroll.offset = 0;
+    hw_scroll.applied_offset = 0;
+    hw_scroll.pending_dy = 0;
+    hw_scroll.clip_next = false;
+    hw_scroll.last_scroll_y = lv_obj_get_scroll_y(obj);
+
+    // 滚动条不随内容移动，硬件滚动时会被带走，所以关闭滚动条并且只允许垂直滚动
+    lv_obj_set_scrollbar_mode(obj, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_scroll_dir(obj, LV_DIR_VER);
+    lv_obj_add_event_cb(obj, lcd_hw_scroll_event_cb, LV_EVENT_SCROLL, NULL);
+    lv_obj_add_event_cb(obj, lcd_hw_scroll_event_cb, LV_EVENT_DELETE, NULL);
+    disp_drv.rounder_cb = lcd_hw_scroll_rounder_cb;
+    lv_obj_invalidate(obj);
+    return ESP_OK;
+}
+
+void lv_port_disp_hw_scroll_detach(void)
+{
+    if (!hw_scroll.obj) {
+        return;
+    }
+    lv_obj_t *obj = hw_scroll.obj;
+    hw_scroll.obj = NULL;
+    disp_drv.rounder_cb = NULL;
+    lv_obj_remove_event_cb(obj, lcd_hw_scroll_event_cb);
+
+    // 回到不滚动的状态，显存里的内容是错位的，整个滚动区需要重绘
+    hw_scroll.offset = 0;
+    hw_scroll.applied_offset = 0;
+    esp_lcd_st7789v3_scroll_to(lcd_panel, 0);
+    lv_area_t band = {
+        .x1 = 0,
+        .y1 = hw_scroll.top,
+        .x2 = EXAMPLE_LCD_H_RES - 1,
+        .y2 = hw_scroll.top + hw_scroll.height - 1,
+    };
+    _lv_inv_area(lvgl_disp, &band);
+}
+
+/*
+ * 按滚动映射把一个 strip 拆成显存中连续的几段：滚动区之前、滚动区内回绕点前后、滚动区之后，
+ * 最多 4 段。
+ */
+static int lcd_hw_scroll_split(const lv_area_t *area, lcd_row_seg_t segs[LCD_ROW_SEGS_MAX])
+{
+    int band_end = hw_scroll.top + hw_scroll.height;
+    int y = area->y1;
+    int y_end = area->y2 + 1;
+    int n = 0;
+
+    while (y < y_end) {
+        lcd_row_seg_t *seg = &segs[n++];
+        seg->y1 = y;
+        if (!hw_scroll.obj || y >= band_end) {
+            seg->y2 = y_end;
+            seg->phys = y;
+        } else if (y < hw_scroll.top) {
+            seg->y2 = LV_MIN(y_end, hw_scroll.top);
+            seg->phys = y;
+        } else {
+            int rel = (y - hw_scroll.top + hw_scroll.offset) % hw_scroll.height;
+            seg->y2 = LV_MIN(LV_MIN(y_end, band_end), y + (hw_scroll.height - rel));
+            seg->phys = hw_scroll.top + rel;
+        }
+        y = seg->y2;
+    }
+    return n;
+}
+#endif /* CONFIG_APP_LCD_HW_SCROLL */
+
+#if CONFIG_APP_LCD_PERF
+static void lvgl_render_start_cb(lv_disp_drv_t *drv)
+{
+    lv_port_perf_render_start();
+}
+#endif
+
+/*
+ * SPI 颜色数据传输完成回调 (在 SPI 中断上下文中执行)
+ * 一个缓冲区的所有段都发送完毕后才通知 LVGL 可以复用它，这样 LVGL 可以在当前缓冲区还在
+ * DMA 发送时渲染到另一个缓冲区。
+ */
+static bool notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    lv_disp_drv_t *drv = (lv_disp_drv_t *)user_ctx;
+    lv_port_perf_trans_done_isr();
+    if (atomic_fetch_sub(&flush_trans_pending, 1) == 1) {
+        lv_disp_flush_ready(drv);
+    }
+    return false;
+}
+
+/* LVGL 刷新回调：只把 CASET/RASET/RAMWR 排入 SPI 队列，不等待传输完成 */
+static void lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    esp_lcd_panel_handle_t panel = (esp_lcd_panel_handle_t)drv->user_data;
+    lcd_row_seg_t segs[LCD_ROW_SEGS_MAX];
+    int n;
+
+    lv_port_perf_flush_begin();
+
+#if CONFIG_APP_LCD_HW_SCROLL
+    if (hw_scroll.obj && hw_scroll.offset != hw_scroll.applied_offset) {
+        // 在本帧第一个 strip 之前移动滚动起点，新露出的行紧接着就会写入
+        esp_lcd_st7789v3_scroll_to(panel, hw_scroll.offset);
+        hw_scroll.applied_offset = hw_scroll.offset;
+    }
+    n = lcd_hw_scroll_split(area, segs);
+#else
+    segs[0] = (lcd_row_seg_t) {
+        .y1 = area->y1, .y2 = area->y2 + 1, .phys = area->y1,
+    };
+    n = 1;
+#endif
+
+    int w = area->x2 - area->x1 + 1;
+    atomic_store(&flush_trans_pending, n);
+    for (int i = 0; i < n; i++) {
+        const lv_color_t *src = color_map + (segs[i].y1 - area->y1) * w;
+        lv_port_perf_trans_queued();
+        if (esp_lcd_panel_draw_bitmap(panel, area->x1, segs[i].phys, area->x2 + 1,
+                                      segs[i].phys + segs[i].y2 - segs[i].y1, src) != ESP_OK) {
+            // 这一段没有排入队列，完成回调不会到来，这里直接计数避免 LVGL 卡死
+            lv_port_perf_trans_cancel();
+            if (atomic_fetch_sub(&flush_trans_pending, 1) == 1) {
+                lv_disp_flush_ready(drv);
+            }
+        }
+    }
+
+    if (lv_disp_flush_is_last(drv)) {
+#if CONFIG_APP_LCD_HW_SCROLL
+        hw_scroll.pending_dy = 0;
+#endif
+#if CONFIG_APP_LCD_FLUSH_STATS
+        lcd_flush_stats_frame_done(panel);
+#endif
+        lv_port_perf_frame_done();
+    } else {
+        lv_port_perf_flush_end();
+    }
+}
+
+
+#if CONFIG_APP_LCD_RENDER_DIRECT
+/*
+ * ---------------------------------------------------------------------------
+ * 直接模式：LVGL 渲染到常驻的整屏帧缓冲，刷新时把刷新区域按 16x16 分块计算哈希，
+ * 只把内容真正变化的块发送到屏幕。小范围动画 (例如状态文字) 只产生几个块的 SPI 流量。
+ *
+ * 帧缓冲在普通内部 RAM 中，变化的块先拷贝到两个 DMA 暂存缓冲再发送；暂存缓冲在
+ * SPI 传输完成回调里归还，所以拷贝下一段的同时上一段仍在 DMA 发送。
+ * ---------------------------------------------------------------------------
+ */
+#define LCD_TILE_SIZE           (16)
+#define LCD_TILES_X             ((EXAMPLE_LCD_H_RES + LCD_TILE_SIZE - 1) / LCD_TILE_SIZE)
+#define LCD_TILES_Y             ((EXAMPLE_LCD_V_RES + LCD_TILE_SIZE - 1) / LCD_TILE_SIZE)
+#define LCD_STAGE_BUF_COUNT     (2)
+#define LCD_STAGE_BUF_PIXELS    (EXAMPLE_LCD_H_RES * LCD_TILE_SIZE)
+
+static lv_color_t *disp_fb = NULL;
+static lv_color_t *stage_buf[LCD_STAGE_BUF_COUNT];
+static int stage_next = 0;
+static SemaphoreHandle_t stage_free = NULL;
+static uint32_t tile_hash[LCD_TILES_Y][LCD_TILES_X];
+static bool tile_hash_valid = false; // 第一帧之前所有块都视为已变化
+
+static bool notify_stage_buf_free(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t need_yield = pdFALSE;
+    lv_port_perf_trans_done_isr();
+    xSemaphoreGiveFromISR(stage_free, &need_yield);
+    return need_yield == pdTRUE;
+}
+
+/* FNV-1a，按 32 位字处理一个块 */
+static uint32_t lcd_tile_hash(const lv_color_t *fb, int x0, int y0, int w, int h)
+{
+    uint32_t hash = 2166136261u;
+    for (int y = y0; y < y0 + h; y++) {
+        const lv_color_t *row = fb + y * EXAMPLE_LCD_H_RES + x0;
+        const uint32_t *words = (const uint32_t *)row;
+        int n = (w * sizeof(lv_color_t)) / sizeof(uint32_t);
+        for (int i = 0; i < n; i++) {
+            hash ^= words[i];
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+/* 把帧缓冲中的一个矩形拷贝到暂存缓冲并排入 SPI 队列 */
+static void lcd_send_rect(esp_lcd_panel_handle_t panel, int x0, int y0, int x1, int y1)
+{
+    xSemaphoreTake(stage_free, portMAX_DELAY);
+    lv_color_t *dst = stage_buf[stage_next];
+    stage_next = (stage_next + 1) % LCD_STAGE_BUF_COUNT;
+
+    int w = x1 - x0;
+    for (int y = y0; y < y1; y++) {
+        memcpy(dst + (y - y0) * w, disp_fb + y * EXAMPLE_LCD_H_RES + x0, w * sizeof(lv_color_t));
+    }
+    lv_port_perf_trans_queued();
+    if (esp_lcd_panel_draw_bitmap(panel, x0, y0, x1, y1, dst) != ESP_OK) {
+        lv_port_perf_trans_cancel();
+        xSemaphoreGive(stage_free);
+    }
+}
+
+static void lvgl_flush_direct_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    esp_lcd_panel_handle_t panel = (esp_lcd_panel_handle_t)drv->user_data;
+
+    int tx0 = area->x1 / LCD_TILE_SIZE;
+    int tx1 = area->x2 / LCD_TILE_SIZE;
+    int ty0 = area->y1 / LCD_TILE_SIZE;
+    int ty1 = area->y2 / LCD_TILE_SIZE;
+
+    lv_port_perf_flush_begin();
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        int y0 = ty * LCD_TILE_SIZE;
+        int y1 = LV_MIN(y0 + LCD_TILE_SIZE, EXAMPLE_LCD_V_RES);
+        int run_start = -1;
+
+        // 同一行中连续变化的块合并成一个矩形发送
+        for (int tx = tx0; tx <= tx1 + 1; tx++) {
+            bool changed = false;
+            if (tx <= tx1) {
+                int x0 = tx * LCD_TILE_SIZE;
+                int w = LV_MIN(LCD_TILE_SIZE, EXAMPLE_LCD_H_RES - x0);
+                uint32_t hash = lcd_tile_hash(disp_fb, x0, y0, w, y1 - y0);
+                changed = !tile_hash_valid || hash != tile_hash[ty][tx];
+                tile_hash[ty][tx] = hash;
+            }
+            if (changed && run_start < 0) {
+                run_start = tx;
+            } else if (!changed && run_start >= 0) {
+                lcd_send_rect(panel, run_start * LCD_TILE_SIZE, y0,
+                              LV_MIN(tx * LCD_TILE_SIZE, EXAMPLE_LCD_H_RES), y1);
+                run_start = -1;
+            }
+        }
+    }
+
+    if (lv_disp_flush_is_last(drv)) {
+        tile_hash_valid = true;
+#if CONFIG_APP_LCD_FLUSH_STATS
+        lcd_flush_stats_frame_done(panel);
+#endif
+        lv_port_perf_frame_done();
+    } else {
+        lv_port_perf_flush_end();
+    }
+
+    // 变化的内容已经拷贝到暂存缓冲，LVGL 可以立即继续修改帧缓冲
+    lv_disp_flush_ready(drv);
+}
+
+static esp_err_t lcd_direct_buffers_init(void)
+{
+    // 整屏 RGB565 帧缓冲约 112KB，不需要 DMA 能力
+    disp_fb = heap_caps_malloc(EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * sizeof(lv_color_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(disp_fb, ESP_ERR_NO_MEM, TAG, "No memory for LVGL frame buffer");
+    for (int i = 0; i < LCD_STAGE_BUF_COUNT; i++) {
+        stage_buf[i] = heap_caps_malloc(LCD_STAGE_BUF_PIXELS * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        ESP_RETURN_ON_FALSE(stage_buf[i], ESP_ERR_NO_MEM, TAG, "No memory for LCD staging buffer");
+    }
+    stage_free = xSemaphoreCreateCounting(LCD_STAGE_BUF_COUNT, LCD_STAGE_BUF_COUNT);
+    ESP_RETURN_ON_FALSE(stage_free, ESP_ERR_NO_MEM, TAG, "No memory for staging semaphore");
+    memset(disp_fb, 0, EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * sizeof(lv_color_t));
+    tile_hash_valid = false;
+    return ESP_OK;
+}
+
+static void lcd_direct_buffers_free(void)
+{
+    heap_caps_free(disp_fb);
+    disp_fb = NULL;
+    for (int i = 0; i < LCD_STAGE_BUF_COUNT; i++) {
+        heap_caps_free(stage_buf[i]);
+        stage_buf[i] = NULL;
+    }
+    if (stage_free) {
+        vSemaphoreDelete(stage_free);
+        stage_free = NULL;
+    }
+}
+#endif /* CONFIG_APP_LCD_RENDER_DIRECT */
+
+/*
+ * ---------------------------------------------------------------------------
+ * 启动时的 SPI 像素时钟训练
+ *
+ * 从最低的候选时钟开始逐级提高：在候选时钟下向 GRAM 写入测试图案，再用安全的
+ * 读时钟 (ST7789V3 读周期最小约 150ns) 通过 MISO 用 RAMRD 读回校验。
+ * 读写必须用两个不同时钟，而 esp_lcd 的 panel IO 创建后时钟就固定了，所以每一步都
+ * 重新创建 IO。最快的稳定时钟保存到 NVS，之后启动直接使用，不再训练。
+ * TF 卡是总线上的另一个 SPI 设备，有自己的时钟 (host.max_freq_khz)，不受影响。
+ * ---------------------------------------------------------------------------
+ */
+static uint32_t lcd_pclk_hz = EXAMPLE_LCD_PIXEL_CLK_HZ; // 实际使用的 LCD 像素时钟
+
+static esp_err_t lcd_new_panel_io(uint32_t pclk_hz, bool notify_lvgl, esp_lcd_panel_io_handle_t *ret_io)
+{
+    esp_lcd_panel_io_spi_config_t io_config = {
+        .dc_gpio_num = EXAMPLE_LCD_GPIO_DC,
+        .cs_gpio_num = EXAMPLE_LCD_GPIO_CS,
+        .pclk_hz = pclk_hz,
+        .lcd_cmd_bits = EXAMPLE_LCD_CMD_BITS,
+        .lcd_param_bits = EXAMPLE_LCD_PARAM_BITS,
+        .spi_mode = 0,
+        .trans_queue_depth = 10,
+    };
+    if (notify_lvgl) {
+#if CONFIG_APP_LCD_RENDER_DIRECT
+        io_config.on_color_trans_done = notify_stage_buf_free;
+#else
+        io_config.on_color_trans_done = notify_lvgl_flush_ready;
+#endif
+        io_config.user_ctx = &disp_drv;
+    }
+    return esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)EXAMPLE_LCD_SPI_NUM, &io_config, ret_io);
+}
+
+#if CONFIG_APP_LCD_PCLK_TRAINING
+#define LCD_PCLK_NVS_NAMESPACE  "lcd"
+#define LCD_PCLK_NVS_KEY        "pclk_hz"
+
+#define LCD_TRAIN_WIN_W         (16)
+#define LCD_TRAIN_WIN_H         (4)
+#define LCD_TRAIN_PIXELS        (LCD_TRAIN_WIN_W * LCD_TRAIN_WIN_H)
+/* RAMRD 在 16bit 模式下每个像素读回 3 字节 (RGB666)，多读 2 字节容纳 dummy 时钟 */
+#define LCD_TRAIN_RX_LEN        (LCD_TRAIN_PIXELS * 3 + 2)
+
+/* SPI 时钟由 80MHz APB 整数分频得到，只尝试能精确得到的频率 */
+static const uint32_t lcd_pclk_candidates[] = {
+    10 * 1000 * 1000,
+    20 * 1000 * 1000,
+    26666666,
+    40 * 1000 * 1000,
+    80 * 1000 * 1000,
+};
+
+static esp_err_t lcd_train_set_window(esp_lcd_panel_io_handle_t io)
+{
+    const uint8_t col_data[4] = {0, 0, 0, LCD_TRAIN_WIN_W - 1};
+    const uint8_t row_data[4] = {0, 0, 0, LCD_TRAIN_WIN_H - 1};
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, col_data, 4), TAG, "CASET failed");
+    return esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, row_data, 4);
+}
+
+/* 取 buf 中从第 bit 位开始的 8 位 */
+static inline uint8_t lcd_train_byte_at(const uint8_t *buf, size_t bit)
+{
+    size_t i = bit / 8;
+    unsigned shift = bit % 8;
+    if (shift == 0) {
+        return buf[i];
+    }
+    return (uint8_t)((buf[i] << shift) | (buf[i + 1] >> (8 - shift)));
+}
+
+/*
+ * 比较读回的 RGB666 数据和写入的 RGB565 图案。
+ * 串行读命令和数据之间的 dummy 时钟数因面板而异，这里在 0~15 位的偏移内寻找对齐位置。
+ */
+static bool lcd_train_compare(const uint16_t *pattern, const uint8_t *rx)
+{
+    for (size_t offset = 0; offset < 16; offset++) {
+        bool match = true;
+        for (size_t i = 0; i < LCD_TRAIN_PIXELS && match; i++) {
+            uint16_t px = pattern[i];
+            size_t bit = offset + i * 24;
+            match = ((lcd_train_byte_at(rx, bit) & 0xF8) == (((px >> 11) & 0x1F) << 3)) &&
+                    ((lcd_train_byte_at(rx, bit + 8) & 0xFC) == (((px >> 5) & 0x3F) << 2)) &&
+                    ((lcd_train_byte_at(rx, bit + 16) & 0xF8) == ((px & 0x1F) << 3));
+        }
+        if (match) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 在 pclk_hz 下写入测试图案，再用读时钟读回校验 */
+static bool lcd_train_try(uint32_t pclk_hz, uint8_t *tx, uint8_t *rx, uint16_t *pattern, uint32_t seed)
+{
+    esp_lcd_panel_io_handle_t io = NULL;
+    bool ok = false;
+
+    // 交替位图案 + 每轮不同的伪随机分量，覆盖 0->1/1->0 跳变
+    for (size_t i = 0; i < LCD_TRAIN_PIXELS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        pattern[i] = ((i & 1) ? 0xAAAA : 0x5555) ^ (uint16_t)(seed >> 16);
+        tx[2 * i] = pattern[i] >> 8;
+        tx[2 * i + 1] = pattern[i] & 0xFF;
+    }
+
+    spi_bus_sched_acquire(SPI_BUS_CLIENT_LCD, portMAX_DELAY);
+    if (lcd_new_panel_io(pclk_hz, false, &io) != ESP_OK) {
+        goto out;
+    }
+    // 16bit/pixel；睡眠模式下 GRAM 仍可读写，不需要先 SLPOUT
+    esp_lcd_panel_io_tx_param(io, LCD_CMD_COLMOD, (uint8_t[]) {0x55}, 1);
+    esp_lcd_panel_io_tx_param(io, LCD_CMD_MADCTL, (uint8_t[]) {0x00}, 1);
+    if (lcd_train_set_window(io) != ESP_OK ||
+            esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, tx, LCD_TRAIN_PIXELS * 2) != ESP_OK) {
+        goto out;
+    }
+    // 删除 IO 前会等待排队中的颜色数据发送完成
+    esp_lcd_panel_io_del(io);
+    io = NULL;
+
+    if (lcd_new_panel_io(CONFIG_APP_LCD_PCLK_READ_HZ, false, &io) != ESP_OK) {
+        goto out;
+    }
+    memset(rx, 0, LCD_TRAIN_RX_LEN);
+    if (lcd_train_set_window(io) != ESP_OK ||
+            esp_lcd_panel_io_rx_param(io, LCD_CMD_RAMRD, rx, LCD_TRAIN_RX_LEN) != ESP_OK) {
+        goto out;
+    }
+    ok = lcd_train_compare(pattern, rx);
+
+out:
+    if (io) {
+        esp_lcd_panel_io_del(io);
+    }
+    spi_bus_sched_release(SPI_BUS_CLIENT_LCD);
+    return ok;
+}
+
+static uint32_t lcd_pclk_train(void)
+{
+    uint32_t best = 0;
+    uint8_t *tx = heap_caps_malloc(LCD_TRAIN_PIXELS * 2, MALLOC_CAP_DMA);
+    uint8_t *rx = heap_caps_malloc(LCD_TRAIN_RX_LEN + 1, MALLOC_CAP_DMA);
+    uint16_t *pattern = malloc(LCD_TRAIN_PIXELS * sizeof(uint16_t));
+    if (!tx || !rx || !pattern) {
+        ESP_LOGW(TAG, "No memory for LCD clock training");
+        goto out;
+    }
+
+    for (size_t i = 0; i < sizeof(lcd_pclk_candidates) / sizeof(lcd_pclk_candidates[0]); i++) {
+        uint32_t hz = lcd_pclk_candidates[i];
+        if (hz > CONFIG_APP_LCD_PCLK_MAX_HZ) {
+            break;
+        }
+        bool stable = true;
+        for (int rep = 0; rep < CONFIG_APP_LCD_PCLK_TRAIN_ROUNDS && stable; rep++) {
+            stable = lcd_train_try(hz, tx, rx, pattern, hz ^ (uint32_t)rep);
+        }
+        ESP_LOGI(TAG, "LCD pclk %" PRIu32 " Hz: %s", hz, stable ? "ok" : "failed");
+        if (!stable) {
+            break; // 更高的时钟只会更不稳定
+        }
+        best = hz;
+    }
+
+out:
+    heap_caps_free(tx);
+    heap_caps_free(rx);
+    free(pattern);
+    return best;
+}
+
+/* 读取 NVS 中保存的时钟；没有保存或要求重新训练时执行训练并保存结果 */
+static uint32_t lcd_pclk_select(void)
+{
+    nvs_handle_t nvs = 0;
+    uint32_t hz = 0;
+
+    // 只在 NVS 能正常初始化时读写，不在这里擦除 NVS (里面还有 Wi-Fi 配网信息)
+    bool nvs_ok = (nvs_flash_init() == ESP_OK) && (nvs_open(LCD_PCLK_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK);
 
+#if !CONFIG_APP_LCD_PCLK_RETRAIN
+    if (nvs_ok && nvs_get_u32(nvs, LCD_PCLK_NVS_KEY, &hz) == ESP_OK &&
+            hz >= EXAMPLE_LCD_PIXEL_CLK_HZ && hz <= CONFIG_APP_LCD_PCLK_MAX_HZ) {
+        ESP_LOGI(TAG, "LCD pclk %" PRIu32 " Hz (from NVS)", hz);
+        nvs_close(nvs);
+        return hz;
+    }
+#endif
+
+    hz = lcd_pclk_train();
+    if (hz == 0) {
+        // 连最低时钟都读不回来：面板的 SDO 可能没有接到 MISO，不保存结果，下次启动再试
+        ESP_LOGW(TAG, "LCD readback failed, keep default pclk %d Hz", EXAMPLE_LCD_PIXEL_CLK_HZ);
+        hz = EXAMPLE_LCD_PIXEL_CLK_HZ;
+    } else if (nvs_ok) {
+        nvs_set_u32(nvs, LCD_PCLK_NVS_KEY, hz);
+        nvs_commit(nvs);
+    }
+    if (nvs_ok) {
+        nvs_close(nvs);
+    }
+    ESP_LOGI(TAG, "LCD pclk %" PRIu32 " Hz (trained)", hz);
+    return hz;
+}
+#endif /* CONFIG_APP_LCD_PCLK_TRAINING */
 
 esp_err_t app_lcd_init(void)
 {
     esp_err_t ret = ESP_OK;
 
 
+    // 绘制缓冲高度决定了单次 SPI 传输的最大长度
+    disp_buf_lines = lcd_draw_buf_lines();
+
     //初始化spi总线
     ESP_LOGD(TAG, "Initialize SPI bus");
     const spi_bus_config_t buscfg = {
@@ -80,7 +779,7 @@ esp_err_t app_lcd_init(void)
         .miso_io_num = EXAMPLE_LCD_GPIO_MISO,
         .quadwp_io_num = GPIO_NUM_NC,
         .quadhd_io_num = GPIO_NUM_NC,
-        .max_transfer_sz = EXAMPLE_LCD_H_RES * EXAMPLE_LCD_DRAW_BUFF_HEIGHT * sizeof(uint16_t),
+        .max_transfer_sz = EXAMPLE_LCD_H_RES * disp_buf_lines * sizeof(uint16_t),
     };
     ESP_RETURN_ON_ERROR(spi_bus_initialize(EXAMPLE_LCD_SPI_NUM, &buscfg, SPI_DMA_CH_AUTO), TAG, "SPI init failed");
 
@@ -100,47 +799,16 @@ esp_err_t app_lcd_init(void)
     gpio_set_level(GPIO_OUTPUT_IO, 0);
 
 
-    //挂载tf卡
-    sdmmc_card_t *card;
-    const char mount_point[] = MOUNT_POINT;
-    ESP_LOGI(TAG, "Initializing SD card");
-    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
-    host.slot = EXAMPLE_LCD_SPI_NUM;   // 重要：告诉 SD 驱动用我们刚初始化好的总线
-
-    sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
-    slot_config.gpio_cs = EXAMPLE_TF_GPIO_CS;
-    slot_config.host_id = host.slot;
-
-    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = false,
-        .max_files = 5,
-        .allocation_unit_size = 16 * 1024
-    };
-
-    ret = esp_vfs_fat_sdspi_mount(mount_point, &host, &slot_config, &mount_config, &card);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "⚠️ SD 卡挂载失败，继续运行：%s", esp_err_to_name(ret));
-        ret = ESP_OK; // ★ 把错误码复位成 OK
-    } else {
-        ESP_LOGI(TAG, "SD 卡已就绪");
-        sdmmc_card_print_info(stdout, card);
-    }
-
-
-
+    // TF 卡必须在 LCD 的任何传输之前进入 SPI 模式，否则仍处于 SD 模式的卡可能误读 LCD 数据并驱动 MISO，
+    // 干扰像素时钟训练的 RAMRD 读回；目录索引在 lv_port_storage.c 的后台任务中建立
+    app_sd_mount();
 
+#if CONFIG_APP_LCD_PCLK_TRAINING
+    lcd_pclk_hz = lcd_pclk_select();
+#endif
 
     ESP_LOGD(TAG, "Install panel IO");
-    const esp_lcd_panel_io_spi_config_t io_config = {
-        .dc_gpio_num = EXAMPLE_LCD_GPIO_DC,
-        .cs_gpio_num = EXAMPLE_LCD_GPIO_CS,
-        .pclk_hz = EXAMPLE_LCD_PIXEL_CLK_HZ,
-        .lcd_cmd_bits = EXAMPLE_LCD_CMD_BITS,
-        .lcd_param_bits = EXAMPLE_LCD_PARAM_BITS,
-        .spi_mode = 0,
-        .trans_queue_depth = 10,
-    };
-    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)EXAMPLE_LCD_SPI_NUM, &io_config, &lcd_io), err, TAG, "New panel IO failed");
+    ESP_GOTO_ON_ERROR(lcd_new_panel_io(lcd_pclk_hz, true, &lcd_io), err, TAG, "New panel IO failed");
 
     ESP_LOGD(TAG, "Install LCD driver");
     const esp_lcd_panel_dev_config_t panel_config = {
@@ -197,6 +865,55 @@ err:
     return ret;
 }
 
+/*
+ * 挂载 TF 卡。TF 卡和显示屏共用 SPI 总线，由 app_lcd_init 在总线初始化之后、面板初始化之前调用；
+ * 卡初始化 (400 kHz 的 CMD0 等) 和 f_mount 期间持有总线调度器的 SD 客户端。
+ */
+esp_err_t app_sd_mount(void)
+{
+    sdmmc_card_t *card;
+    const char mount_point[] = MOUNT_POINT;
+    ESP_LOGI(TAG, "Initializing SD card");
+    sdmmc_host_t host = SDSPI_HOST_DEFAULT();
+    host.slot = EXAMPLE_LCD_SPI_NUM;   // 重要：告诉 SD 驱动用 app_lcd_init 初始化好的总线
+    host.max_freq_khz = CONFIG_APP_SD_MAX_FREQ_KHZ; // TF 卡和 LCD 各用自己的 SPI 时钟
+
+    sdspi_device_config_t slot_config = SDSPI_DEVICE_CONFIG_DEFAULT();
+    slot_config.gpio_cs = EXAMPLE_TF_GPIO_CS;
+    slot_config.host_id = host.slot;
+
+    esp_vfs_fat_sdmmc_mount_config_t mount_config = {
+        .format_if_mount_failed = false,
+        .max_files = 5,
+        .allocation_unit_size = 16 * 1024
+    };
+
+    spi_bus_sched_acquire(SPI_BUS_CLIENT_SD, portMAX_DELAY);
+    esp_err_t ret = esp_vfs_fat_sdspi_mount(mount_point, &host, &slot_config, &mount_config, &card);
+    spi_bus_sched_release(SPI_BUS_CLIENT_SD);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ SD 卡挂载失败，继续运行：%s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "SD 卡已就绪");
+    sdmmc_card_print_info(stdout, card);
+    sd_mounted = true;
+    return ESP_OK;
+}
+
+/* 建立 TF 卡目录索引，之后查找图片不再逐个扫描目录扇区；失败时照常访问 TF 卡 */
+esp_err_t app_sd_build_index(void)
+{
+    if (!sd_mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (safe_fatfs_index_build(0) != ESP_OK) {
+        ESP_LOGW(TAG, "TF 卡目录索引未建立");
+    }
+    return ESP_OK;
+}
+
 esp_err_t app_lcd_deinit(void)
 {
     ESP_RETURN_ON_ERROR(esp_lcd_panel_del(lcd_panel), TAG, "LCD panel deinit failed");
@@ -207,40 +924,49 @@ esp_err_t app_lcd_deinit(void)
 
 esp_err_t app_lvgl_init(void)
 {
-    /* Initialize LVGL */
-    const lvgl_port_cfg_t lvgl_cfg = {
-        .task_priority = 4,         /* LVGL task priority */
-        .task_stack = 4096,         /* LVGL task stack size */
-        .task_affinity = -1,        /* LVGL task pinned to core (-1 is no affinity) */
-        .task_max_sleep_ms = 500,   /* Maximum sleep in LVGL task */
-        .timer_period_ms = 5        /* LVGL timer tick period in ms */
-    };
-    ESP_RETURN_ON_ERROR(lvgl_port_init(&lvgl_cfg), TAG, "LVGL port initialization failed");
+    /* Initialize LVGL，定时器和刷新由 lv_port_tick.c 中的 lvgl_task 驱动 */
+    lv_init();
 
     /* Add LCD screen */
     ESP_LOGD(TAG, "Add LCD screen");
-    const lvgl_port_display_cfg_t disp_cfg = {
-        .io_handle = lcd_io,
-        .panel_handle = lcd_panel,
-        .buffer_size = EXAMPLE_LCD_H_RES * EXAMPLE_LCD_DRAW_BUFF_HEIGHT * sizeof(uint16_t),
-        .double_buffer = EXAMPLE_LCD_DRAW_BUFF_DOUBLE,
-        .hres = EXAMPLE_LCD_H_RES,
-        .vres = EXAMPLE_LCD_V_RES,
-        .monochrome = false,
-        /* Rotation values must be same as used in esp_lcd for initial settings of the screen */
-        .rotation = {
-            .swap_xy = false,
-            .mirror_x = true,
-            .mirror_y = true,
-        },
-        .flags = {
-            .buff_dma = true,
-#if LVGL_VERSION_MAJOR >= 9
-            .swap_bytes = true,
+#if CONFIG_APP_LCD_RENDER_DIRECT
+    if (lcd_direct_buffers_init() != ESP_OK) {
+        lcd_direct_buffers_free();
+        return ESP_ERR_NO_MEM;
+    }
+    lv_disp_draw_buf_init(&disp_draw_buf, disp_fb, NULL, EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES);
+
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.direct_mode = 1;
+    disp_drv.flush_cb = lvgl_flush_direct_cb;
+#else
+    // 两块 DMA 缓冲：LVGL 渲染一块的同时，另一块由 SPI DMA 发送
+    size_t buf_pixels = EXAMPLE_LCD_H_RES * disp_buf_lines;
+    disp_buf1 = heap_caps_malloc(buf_pixels * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    ESP_RETURN_ON_FALSE(disp_buf1, ESP_ERR_NO_MEM, TAG, "No memory for LVGL draw buffer");
+#if EXAMPLE_LCD_DRAW_BUFF_COUNT > 1
+    disp_buf2 = heap_caps_malloc(buf_pixels * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    if (disp_buf2 == NULL) {
+        heap_caps_free(disp_buf1);
+        disp_buf1 = NULL;
+        ESP_LOGE(TAG, "No memory for second LVGL draw buffer");
+        return ESP_ERR_NO_MEM;
+    }
 #endif
-        }
-    };
-    lvgl_disp = lvgl_port_add_disp(&disp_cfg);
+    lv_disp_draw_buf_init(&disp_draw_buf, disp_buf1, disp_buf2, buf_pixels);
+
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.flush_cb = lvgl_flush_cb;
+#endif
+    disp_drv.hor_res = EXAMPLE_LCD_H_RES;
+    disp_drv.ver_res = EXAMPLE_LCD_V_RES;
+    disp_drv.draw_buf = &disp_draw_buf;
+    disp_drv.user_data = lcd_panel;
+#if CONFIG_APP_LCD_PERF
+    disp_drv.render_start_cb = lvgl_render_start_cb;
+#endif
+    lvgl_disp = lv_disp_drv_register(&disp_drv);
+    lv_port_perf_init(lcd_panel);
 
     esp_lcd_panel_set_gap(lcd_panel, 0, 80); 
 
@@ -250,8 +976,16 @@ esp_err_t app_lvgl_init(void)
 esp_err_t app_lvgl_deinit(void)
 {
 
-    ESP_RETURN_ON_ERROR(lvgl_port_remove_disp(lvgl_disp), TAG, "LVGL disp removing failed");
-    ESP_RETURN_ON_ERROR(lvgl_port_deinit(), TAG, "LVGL deinit failed");
+    lv_disp_remove(lvgl_disp);
+    lvgl_disp = NULL;
+#if CONFIG_APP_LCD_RENDER_DIRECT
+    lcd_direct_buffers_free();
+#else
+    heap_caps_free(disp_buf1);
+    heap_caps_free(disp_buf2);
+    disp_buf1 = NULL;
+    disp_buf2 = NULL;
+#endif
 
     return ESP_OK;
 }
@@ -276,8 +1010,8 @@ esp_err_t app_lvgl_deinit(void)
 //     lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, LV_PART_MAIN);
 
 
-//     lv_obj_t* img = lv_gif_create(lv_screen_active());
-//     lv_gif_set_src(img, "A:/littlefs/miho.gif");
+//     lv_obj_t* img = lv_port_gif_create(lv_scr_act());
+//     lv_port_gif_set_src(img, "A:/littlefs/miho.gif");
 
 //     /*Now create the actual image*/
 //     // lv_obj_t *img = lv_image_create(lv_screen_active());
@@ -15,25 +15,73 @@
 #include <string.h> // For string manipulation (e.g., strcpy, strlen)
 #include <dirent.h> // For directory operations (opendir, readdir, closedir)
 #include <errno.h>  // For error handling (errno)
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 #include "ff.h"
 #include "safe_fatfs.h" // 包含线程安全的 FatFs 封装头文件
+#include "lv_port_fs.h"
+#include "lv_port_img_cache.h"
+#include "lv_port_pack.h"
+#include "lv_port_storage.h"
 
 
 /*********************
  * DEFINES
  *********************/
 static const char *TAG = "LV_FS";
+
+// 预读块大小，等于簇大小时每次填充都是一段连续扇区，一次多块读取
+#define FS_RA_SIZE      (CONFIG_APP_FS_READAHEAD_KB * 1024)
+
+// 转换后的路径放在调用者栈上的缓冲区中，比 LVGL 路径多出根目录前缀 ("0:" 或 "/littlefs")
+#define FS_PATH_MAX     (LV_FS_MAX_PATH_LENGTH + 16)
+
+#if CONFIG_FATFS_USE_FASTSEEK && CONFIG_APP_FS_FASTSEEK_SLOTS > 0
+#define FS_FASTSEEK     1
+#define FS_CLMT_LEN     CONFIG_APP_FS_FASTSEEK_CLMT_LEN
+#define FS_CLMT_MIN     (CONFIG_APP_FS_FASTSEEK_MIN_KB * 1024)
+#else
+#define FS_FASTSEEK     0
+#endif
 /**********************
  * TYPEDEFS
  **********************/
+// 一个 LVGL 盘符对应的文件系统："A:/x"、VFS 路径 "<vfs_prefix>/x" 和回调收到的 "/x" 都转换成 "<root>/x"
+typedef struct {
+    char letter;
+    const char *vfs_prefix;
+    const char *root;
+} fs_volume_t;
+
+// 打开的文件：命中图片缓存时从内存读取，在资源包中时从包文件读取，否则直接读 FatFs 文件
+// 只读打开的文件自己记录读取位置，FatFs 文件的位置可能已经在预读的数据之后，只在需要时 f_lseek
+typedef struct {
+    FIL fil;
+    img_cache_entry_t *cached;
+    const lv_port_pack_entry_t *packed;
+    bool readonly;
+    uint32_t pos;               // 只读打开时的当前位置
+    uint8_t *ra_buf;            // 预读缓冲，第一次小块读取时从池中借用，关闭时归还
+    uint32_t ra_off;            // 预读缓冲中第一个字节在文件中的位置
+    uint32_t ra_len;            // 预读缓冲中的有效字节数
+} fs_file_t;
 
 /**********************
  * STATIC PROTOTYPES
  **********************/
 static void fs_init(void);
+#if CONFIG_APP_ASSET_PACK_ENABLE
+static void fs_pack_open_cb(bool mounted, void *user_data);
+#endif
+static uint32_t fs_file_stamp(const FILINFO *fno);
+static bool fs_path_translate(const fs_volume_t *vol, const char *lv_path, char *out, size_t size);
+static const lv_port_pack_entry_t *fs_pack_find(const char *fatfs_path);
 
 // 函数原型声明
 static void *fs_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
@@ -48,6 +96,18 @@ static lv_fs_res_t fs_dir_close(lv_fs_drv_t *drv, void *rddir_p);
 static lv_fs_res_t fs_remove(lv_fs_drv_t *drv, const char *path);
 static lv_fs_res_t fs_rename(lv_fs_drv_t *drv, const char *oldname, const char *newname);
 
+#if CONFIG_APP_FS_LITTLEFS_DRIVE
+static void *flash_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+static lv_fs_res_t flash_close(lv_fs_drv_t *drv, void *file_p);
+static lv_fs_res_t flash_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br);
+static lv_fs_res_t flash_write(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw);
+static lv_fs_res_t flash_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence);
+static lv_fs_res_t flash_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+static void *flash_dir_open(lv_fs_drv_t *drv, const char *path);
+static lv_fs_res_t flash_dir_read(lv_fs_drv_t *drv, void *rddir_p, char *fn);
+static lv_fs_res_t flash_dir_close(lv_fs_drv_t *drv, void *rddir_p);
+#endif
+
 
 /**********************
  * STATIC VARIABLES
@@ -55,6 +115,42 @@ static lv_fs_res_t fs_rename(lv_fs_drv_t *drv, const char *oldname, const char *
 // 文件系统操作的互斥锁
 // extern SemaphoreHandle_t spi_mutex;
 
+// TF 卡：FatFs 逻辑驱动器 "0:"
+static const fs_volume_t s_vol_sd = {'A', "/sdcard", "0:"};
+
+#if CONFIG_APP_FS_LITTLEFS_DRIVE
+// 内部 flash 的 LittleFS 分区，通过 VFS 访问，挂载点和 main.c 中 esp_vfs_littlefs_register 的 base_path 相同
+static const fs_volume_t s_vol_flash = {CONFIG_APP_FS_LITTLEFS_LETTER[0], "/littlefs", "/littlefs"};
+#endif
+
+// TF 卡目录句柄。索引建立后目录从 RAM 中列出，不打开 FF_DIR
+typedef struct {
+    FF_DIR dir;
+    safe_fatfs_index_dir_t idx;
+    bool indexed;
+} fs_dir_t;
+
+// 文件和目录句柄池，打开和关闭时不分配内存。FIL 中带一个扇区的缓存，按 Kconfig 固定数量
+static fs_file_t s_files[CONFIG_APP_FS_FILE_HANDLES];
+static fs_dir_t s_dirs[CONFIG_APP_FS_DIR_HANDLES];
+static uint32_t s_files_used;   // 按位记录已占用的句柄
+static uint32_t s_dirs_used;
+static lv_port_fs_handle_stats_t s_handle_stats;
+static portMUX_TYPE s_handle_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if FS_FASTSEEK
+// 快速定位用的簇链映射表，大文件打开时占用一个，关闭时归还
+static DWORD s_clmt[CONFIG_APP_FS_FASTSEEK_SLOTS][FS_CLMT_LEN];
+static uint32_t s_clmt_used;    // 按位记录已占用的表
+static portMUX_TYPE s_clmt_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+#if FS_RA_SIZE > 0
+// 预读缓冲池，和句柄一样静态分配，数量少于句柄时没借到缓冲的文件直接读卡
+static uint8_t s_ra_bufs[CONFIG_APP_FS_READAHEAD_BUFS][FS_RA_SIZE];
+static uint32_t s_ra_used;      // 按位记录已借出的缓冲
+#endif
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -70,6 +166,11 @@ static lv_fs_res_t fs_rename(lv_fs_drv_t *drv, const char *oldname, const char *
 void lv_port_fs_init(void)
 {
     fs_init();
+    img_cache_init();
+#if CONFIG_APP_ASSET_PACK_ENABLE
+    // TF 卡在后台挂载，挂载后再打开资源包
+    lv_port_storage_when_ready(LV_PORT_STORAGE_SD, fs_pack_open_cb, NULL);
+#endif
 
     static lv_fs_drv_t fs_drv;
     lv_fs_drv_init(&fs_drv);
@@ -87,9 +188,127 @@ void lv_port_fs_init(void)
     // fs_drv.rename_cb = fs_rename;
 
     fs_drv.dir_open_cb = fs_dir_open;
+    fs_drv.dir_read_cb = fs_dir_read;
     fs_drv.dir_close_cb = fs_dir_close;
 
     lv_fs_drv_register(&fs_drv);
+
+#if CONFIG_APP_FS_LITTLEFS_DRIVE
+    // 内部 flash 不经过共享的 SPI 总线，常用的小图标放在这里延迟更低
+    static lv_fs_drv_t flash_drv;
+    lv_fs_drv_init(&flash_drv);
+    flash_drv.letter = s_vol_flash.letter;
+    flash_drv.open_cb = flash_open;
+    flash_drv.close_cb = flash_close;
+    flash_drv.read_cb = flash_read;
+    flash_drv.write_cb = flash_write;
+    flash_drv.seek_cb = flash_seek;
+    flash_drv.tell_cb = flash_tell;
+    flash_drv.dir_open_cb = flash_dir_open;
+    flash_drv.dir_read_cb = flash_dir_read;
+    flash_drv.dir_close_cb = flash_dir_close;
+    lv_fs_drv_register(&flash_drv);
+#endif
+}
+
+/* 查询文件的大小和修改时间戳，给需要长期持有文件的解码器判断文件是否被改写 */
+bool lv_port_fs_file_info(const char *path, uint32_t *stamp, uint32_t *size)
+{
+    lv_fs_drv_t *drv = lv_fs_get_drv(path[0]);
+    if (drv == NULL) {
+        return false;
+    }
+#if CONFIG_APP_FS_LITTLEFS_DRIVE
+    if (drv->open_cb == flash_open) {
+        char vfs_path[FS_PATH_MAX];
+        struct stat st;
+        if (!fs_path_translate(&s_vol_flash, path, vfs_path, sizeof(vfs_path)) || stat(vfs_path, &st) != 0) {
+            return false;
+        }
+        *stamp = (uint32_t)st.st_mtime;
+        *size = (uint32_t)st.st_size;
+        return true;
+    }
+#endif
+    char fatfs_path[FS_PATH_MAX];
+    if (drv->open_cb != fs_open || !fs_path_translate(&s_vol_sd, path, fatfs_path, sizeof(fatfs_path))) {
+        return false;
+    }
+    const lv_port_pack_entry_t *pe = fs_pack_find(fatfs_path);
+    if (pe) {
+        *stamp = lv_port_pack_stamp();
+        *size = pe->size;
+        return true;
+    }
+    FILINFO fno;
+    if (safe_f_stat(fatfs_path, &fno) != FR_OK) {
+        return false;
+    }
+    *stamp = fs_file_stamp(&fno);
+    *size = fno.fsize;
+    return true;
+}
+
+/* 转换成 FatFs 路径写入 buf，不使用静态缓冲区，可以在 LVGL 任务之外调用 */
+bool lv_port_fs_fatfs_path(const char *path, char *buf, size_t size)
+{
+    return fs_path_translate(&s_vol_sd, path, buf, size);
+}
+
+/* 文件内容在图片缓存中时返回内存地址，否则返回 NULL */
+const uint8_t *lv_port_fs_mem(lv_fs_file_t *file, uint32_t *size)
+{
+    if (file->drv == NULL || file->drv->open_cb != fs_open) {
+        return NULL;
+    }
+    fs_file_t *f = (fs_file_t *)file->file_d;
+    if (f->cached == NULL) {
+        return NULL;
+    }
+    *size = img_cache_size(f->cached);
+    return img_cache_data(f->cached);
+}
+
+/* 放弃文件在图片缓存中的整份拷贝，之后从卡上或资源包读取，读取位置不变 */
+bool lv_port_fs_uncache(lv_fs_file_t *file, const char *path)
+{
+    if (file->drv == NULL || file->drv->open_cb != fs_open) {
+        return false;
+    }
+    fs_file_t *f = (fs_file_t *)file->file_d;
+    if (f->cached == NULL) {
+        return true;
+    }
+    char fatfs_path[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_sd, path, fatfs_path, sizeof(fatfs_path))) {
+        return false;
+    }
+    // 资源包文件一直打开，其他文件命中缓存时没有打开 FIL
+    if (!f->packed && safe_f_open(&f->fil, fatfs_path, FA_READ) != FR_OK) {
+        return false;
+    }
+    img_cache_release(f->cached);
+    img_cache_invalidate(fatfs_path);
+    f->cached = NULL;
+    f->ra_len = 0;
+    return true;
+}
+
+void lv_port_fs_get_handle_stats(lv_port_fs_handle_stats_t *out_stats)
+{
+    portENTER_CRITICAL(&s_handle_lock);
+    *out_stats = s_handle_stats;
+    portEXIT_CRITICAL(&s_handle_lock);
+}
+
+void lv_port_fs_dump_stats(void)
+{
+    lv_port_fs_handle_stats_t st;
+    lv_port_fs_get_handle_stats(&st);
+    ESP_LOGI(TAG, "file handles %" PRIu32 "/%d (peak %" PRIu32 ", exhausted %" PRIu32 "), "
+             "dir handles %" PRIu32 "/%d (peak %" PRIu32 ", exhausted %" PRIu32 ")",
+             st.files_in_use, CONFIG_APP_FS_FILE_HANDLES, st.files_peak, st.files_exhausted,
+             st.dirs_in_use, CONFIG_APP_FS_DIR_HANDLES, st.dirs_peak, st.dirs_exhausted);
 }
 
 /**********************
@@ -97,49 +316,317 @@ void lv_port_fs_init(void)
  **********************/
 
 /* 实际的SD卡和文件系统挂载应该在这里之前完成 */
+#if CONFIG_APP_ASSET_PACK_ENABLE
+/* TF 卡挂载结束后在 LVGL 任务中打开资源包，挂载失败时所有路径照常交给 FatFs */
+static void fs_pack_open_cb(bool mounted, void *user_data)
+{
+    char pack_path[FS_PATH_MAX];
+    if (mounted && fs_path_translate(&s_vol_sd, CONFIG_APP_ASSET_PACK_PATH, pack_path, sizeof(pack_path))) {
+        lv_port_pack_open(pack_path);
+    }
+}
+#endif
+
 static void fs_init(void)
 {
-    // 这个函数保持为空，因为文件系统的初始化（挂载SD卡）
-    // 通常在应用程序的早期阶段完成，而不是在LVGL端口初始化时。
-    // 确保在调用 lv_port_fs_init() 之前，您的 SD 卡已经挂载成功。
+    // TF 卡由 app_lcd_init 挂载，LittleFS 由 lv_port_storage.c 在后台挂载，这里不需要初始化
 }
 
-// 辅助函数：将 LVGL 路径 (例如 "A:/file.txt") 转换为 FatFs 路径 (例如 "0:/file.txt")
-static const char *lv_path_to_fatfs_path(lv_fs_drv_t *drv, const char *lv_path)
+/*
+ * 把路径转换成 vol 上的完整路径写入 out，只使用调用者的缓冲区，可以在任意任务中同时调用。
+ * 接受的写法：LVGL 路径 "A:/x"，应用中常用的 "A:/sdcard/x"，VFS 路径 "/sdcard/x"，
+ * 以及 LVGL 去掉盘符后传给回调的 "/x" 和 "/sdcard/x"，都转换成 "0:/x"。
+ * 带其他盘符的路径或者 out 放不下时返回 false。
+ */
+static bool fs_path_translate(const fs_volume_t *vol, const char *lv_path, char *out, size_t size)
 {
-    // 使用静态缓冲区来构建新路径
-    static char fatfs_path[256];
+    size_t prefix_len = strlen(vol->vfs_prefix);
+    const char *rest = lv_path;
 
-    // 定义我们期望剥离的 VFS 挂载点前缀
-    const char *vfs_prefix = "/sdcard";
-    size_t vfs_prefix_len = strlen(vfs_prefix);
+    if (lv_path[0] == vol->letter && lv_path[1] == ':') {
+        rest = lv_path + 2;
+    } else if (lv_path[0] != '\0' && lv_path[1] == ':') {
+        return false; // 其他盘符的路径
+    }
+    // 盘符后面还可能跟着 VFS 挂载点，例如 "A:/sdcard/x"
+    if (strncmp(rest, vol->vfs_prefix, prefix_len) == 0 && (rest[prefix_len] == '/' || rest[prefix_len] == '\0')) {
+        rest += prefix_len;
+    }
 
-    // printf("Input lv_path: %s\n", lv_path);
+    int n = snprintf(out, size, "%s%s%s", vol->root, rest[0] == '/' ? "" : "/", rest);
+    if (n < 0 || (size_t)n >= size) {
+        LV_LOG_WARN("path too long: %s", lv_path);
+        return false;
+    }
+    return true;
+}
 
-    // 情况一：路径是标准的 LVGL 格式 "A:..."
-    if (lv_path[0] == drv->letter && lv_path[1] == ':') {
-        // 转换 "A:/file.bin" 为 "0:/file.bin"
-        snprintf(fatfs_path, sizeof(fatfs_path), "0:%s", lv_path + 2);
+/* 从位图 used 中取一个空闲的句柄编号，没有时返回 -1 */
+static int fs_handle_take(uint32_t *used, int count, uint32_t *in_use, uint32_t *peak, uint32_t *exhausted)
+{
+    int idx = -1;
+    portENTER_CRITICAL(&s_handle_lock);
+    for (int i = 0; i < count; i++) {
+        if (!(*used & (1u << i))) {
+            *used |= 1u << i;
+            idx = i;
+            break;
+        }
+    }
+    if (idx >= 0) {
+        (*in_use)++;
+        if (*in_use > *peak) {
+            *peak = *in_use;
+        }
+    } else {
+        (*exhausted)++;
+    }
+    portEXIT_CRITICAL(&s_handle_lock);
+    return idx;
+}
+
+static void fs_handle_give(uint32_t *used, int idx, uint32_t *in_use)
+{
+    portENTER_CRITICAL(&s_handle_lock);
+    *used &= ~(1u << idx);
+    (*in_use)--;
+    portEXIT_CRITICAL(&s_handle_lock);
+}
+
+static fs_file_t *fs_file_alloc(void)
+{
+    int idx = fs_handle_take(&s_files_used, CONFIG_APP_FS_FILE_HANDLES, &s_handle_stats.files_in_use,
+                             &s_handle_stats.files_peak, &s_handle_stats.files_exhausted);
+    if (idx < 0) {
+        ESP_LOGE(TAG, "all %d file handles in use, raise APP_FS_FILE_HANDLES", CONFIG_APP_FS_FILE_HANDLES);
+        return NULL;
+    }
+    // FIL 由 f_open 初始化，这里只清除上一次打开留下的状态
+    fs_file_t *f = &s_files[idx];
+    f->cached = NULL;
+    f->packed = NULL;
+    f->readonly = false;
+    f->pos = 0;
+    f->ra_buf = NULL;
+    f->ra_off = 0;
+    f->ra_len = 0;
+    return f;
+}
+
+static void fs_file_free(fs_file_t *f)
+{
+#if FS_RA_SIZE > 0
+    if (f->ra_buf) {
+        uint32_t slot = (f->ra_buf - s_ra_bufs[0]) / FS_RA_SIZE;
+        f->ra_buf = NULL;
+        portENTER_CRITICAL(&s_handle_lock);
+        s_ra_used &= ~(1u << slot);
+        portEXIT_CRITICAL(&s_handle_lock);
+    }
+#endif
+    fs_handle_give(&s_files_used, f - s_files, &s_handle_stats.files_in_use);
+}
+
+static fs_dir_t *fs_dir_alloc(void)
+{
+    int idx = fs_handle_take(&s_dirs_used, CONFIG_APP_FS_DIR_HANDLES, &s_handle_stats.dirs_in_use,
+                             &s_handle_stats.dirs_peak, &s_handle_stats.dirs_exhausted);
+    if (idx < 0) {
+        ESP_LOGE(TAG, "all %d directory handles in use, raise APP_FS_DIR_HANDLES", CONFIG_APP_FS_DIR_HANDLES);
+        return NULL;
+    }
+    return &s_dirs[idx];
+}
+
+static void fs_dir_free(fs_dir_t *d)
+{
+    fs_handle_give(&s_dirs_used, d - s_dirs, &s_handle_stats.dirs_in_use);
+}
+
+/* 文件修改时间作为缓存条目的版本，文件被改写后旧条目自动作废 */
+static uint32_t fs_file_stamp(const FILINFO *fno)
+{
+    return ((uint32_t)fno->fdate << 16) | fno->ftime;
+}
+
+/* 资源包中的文件以 TF 卡根目录下的相对路径命名，"0:/img/a.bin" 查找 "img/a.bin" */
+static const lv_port_pack_entry_t *fs_pack_find(const char *fatfs_path)
+{
+    if (strncmp(fatfs_path, "0:/", 3) != 0) {
+        return NULL;
+    }
+    return lv_port_pack_find(fatfs_path + 3);
+}
+
+/* 从资源包或 FatFs 文件的 pos 处读取，不经过图片缓存和预读缓冲 */
+static FRESULT fs_read_at(fs_file_t *f, uint32_t pos, void *buf, UINT btr, UINT *br)
+{
+    if (f->packed) {
+        return lv_port_pack_read(f->packed, pos, buf, btr, br);
+    }
+    if (safe_f_tell(&f->fil) != pos) {
+        FRESULT res = safe_f_lseek(&f->fil, pos);
+        if (res != FR_OK) {
+            *br = 0;
+            return res;
+        }
+    }
+    return safe_f_read(&f->fil, buf, btr, br);
+}
+
+#if FS_FASTSEEK
+/*
+ * 大文件打开后从池中取一张簇链映射表，一次遍历 FAT 链建好，之后 f_lseek 和读取
+ * 直接查表找簇，定位耗时不再随位置增长。池用完或文件碎片太多放不下时按普通方式定位。
+ */
+static void fs_fastseek_attach(fs_file_t *f)
+{
+    if (safe_f_size(&f->fil) < FS_CLMT_MIN) {
+        return;
     }
-    // 情况二：路径是以 "/sdcard" 开头的 VFS 格式
-    else if (strncmp(lv_path, vfs_prefix, vfs_prefix_len) == 0) {
-        // 转换 "/sdcard/file.bin" 为 "0:/file.bin"
-        // lv_path + vfs_prefix_len 会指向 "/sdcard" 后面的部分，即 "/file.bin"
-        snprintf(fatfs_path, sizeof(fatfs_path), "0:%s", lv_path + vfs_prefix_len);
+
+    int slot = -1;
+    portENTER_CRITICAL(&s_clmt_lock);
+    for (int i = 0; i < CONFIG_APP_FS_FASTSEEK_SLOTS; i++) {
+        if (!(s_clmt_used & (1u << i))) {
+            s_clmt_used |= 1u << i;
+            slot = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_clmt_lock);
+    if (slot < 0) {
+        ESP_LOGD(TAG, "fast seek: no free cluster map");
+        return;
     }
-    // 情况三：其他意外的格式 (例如相对路径 "file.bin")
-    else {
 
+    f->fil.cltbl = s_clmt[slot];
+    s_clmt[slot][0] = FS_CLMT_LEN;
+    FRESULT res = safe_f_lseek(&f->fil, CREATE_LINKMAP);
+    if (res != FR_OK) {
+        // FR_NOT_ENOUGH_CORE: 碎片太多，s_clmt[slot][0] 是需要的表长
+        ESP_LOGD(TAG, "fast seek: cluster map not built, error %d, needs %u", res, (unsigned)s_clmt[slot][0]);
+        f->fil.cltbl = NULL;
+        portENTER_CRITICAL(&s_clmt_lock);
+        s_clmt_used &= ~(1u << slot);
+        portEXIT_CRITICAL(&s_clmt_lock);
     }
+}
 
-    // printf("Output fatfs_path: %s\n", fatfs_path);
+static void fs_fastseek_release(fs_file_t *f)
+{
+    if (f->fil.cltbl == NULL) {
+        return;
+    }
+    uint32_t slot = (f->fil.cltbl - s_clmt[0]) / FS_CLMT_LEN;
+    f->fil.cltbl = NULL;
+    portENTER_CRITICAL(&s_clmt_lock);
+    s_clmt_used &= ~(1u << slot);
+    portEXIT_CRITICAL(&s_clmt_lock);
+}
+#endif
 
-    return fatfs_path;
+#if FS_RA_SIZE > 0
+/* 从池中借一个预读缓冲，池用完时返回 false，这个文件之后直接读卡 */
+static bool fs_ra_take(fs_file_t *f)
+{
+    portENTER_CRITICAL(&s_handle_lock);
+    for (int i = 0; i < CONFIG_APP_FS_READAHEAD_BUFS; i++) {
+        if (!(s_ra_used & (1u << i))) {
+            s_ra_used |= 1u << i;
+            f->ra_buf = s_ra_bufs[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_handle_lock);
+    return f->ra_buf != NULL;
+}
+
+/*
+ * 只读文件从 f->pos 处读取：预读缓冲中有的部分直接复制；
+ * 剩下的部分不小于一个预读块时直接读入 buf (FatFs 对整扇区做多块读取)，
+ * 否则从对齐到预读块的位置重新填充缓冲。文件从簇边界开始存放，块大小等于簇大小时一次填充就是一个簇。
+ */
+static FRESULT fs_read_ahead(fs_file_t *f, uint8_t *buf, UINT btr, UINT *br)
+{
+    *br = 0;
+    while (btr > 0) {
+        if (f->ra_len > 0 && f->pos >= f->ra_off && f->pos < f->ra_off + f->ra_len) {
+            uint32_t n = LV_MIN(btr, f->ra_off + f->ra_len - f->pos);
+            memcpy(buf, f->ra_buf + (f->pos - f->ra_off), n);
+            buf += n;
+            btr -= n;
+            *br += n;
+            f->pos += n;
+            continue;
+        }
+
+        if (btr >= FS_RA_SIZE || (f->ra_buf == NULL && !fs_ra_take(f))) {
+            UINT n = 0;
+            FRESULT res = fs_read_at(f, f->pos, buf, btr, &n);
+            f->pos += n;
+            *br += n;
+            return res;
+        }
+
+        uint32_t off = f->pos - f->pos % FS_RA_SIZE;
+        UINT n = 0;
+        FRESULT res = fs_read_at(f, off, f->ra_buf, FS_RA_SIZE, &n);
+        f->ra_off = off;
+        f->ra_len = (res == FR_OK) ? n : 0;
+        if (res != FR_OK) {
+            return res;
+        }
+        if (f->pos >= off + n) {
+            break; // 到达文件末尾
+        }
+    }
+    return FR_OK;
+}
+#endif
+
+/* 把整个文件读入新的缓存条目，成功后关闭文件，之后从内存读取 */
+static void fs_try_cache(fs_file_t *f, const char *fatfs_path, uint32_t stamp, uint32_t size)
+{
+    img_cache_entry_t *e = img_cache_alloc(fatfs_path, stamp, size);
+    if (e == NULL) {
+        return;
+    }
+    UINT br = 0;
+    FRESULT res = fs_read_at(f, 0, img_cache_data(e), size, &br);
+    if (res != FR_OK || br != size) {
+        img_cache_abort(e);
+        return;
+    }
+    img_cache_commit(e);
+    if (!f->packed) {
+        safe_f_close(&f->fil);
+    }
+    f->cached = e;
+    f->pos = 0;
+}
+
+/* 查找缓存中 stamp 和 size 都一致的条目，过期的条目直接作废 */
+static bool fs_cache_lookup(fs_file_t *f, const char *fatfs_path, uint32_t stamp, uint32_t size)
+{
+    f->cached = img_cache_get(fatfs_path, stamp);
+    if (f->cached && img_cache_size(f->cached) == size) {
+        return true;
+    }
+    if (f->cached) {
+        img_cache_release(f->cached);
+        img_cache_invalidate(fatfs_path);
+        f->cached = NULL;
+    }
+    return false;
 }
 
 static void *fs_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
 {
-    const char *fatfs_path = lv_path_to_fatfs_path(drv, path);
+    char fatfs_path[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_sd, path, fatfs_path, sizeof(fatfs_path))) {
+        return NULL;
+    }
 
     BYTE flags = 0;
     if (mode == LV_FS_MODE_WR) {
@@ -150,47 +637,100 @@ static void *fs_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
         flags = FA_READ | FA_WRITE | FA_OPEN_ALWAYS;
     }
 
-    // FatFs 使用 FIL 结构体，我们需要在堆上为其分配内存
-    FIL *f = malloc(sizeof(FIL));
+    // FatFs 使用 FIL 结构体，从句柄池中取一个
+    fs_file_t *f = fs_file_alloc();
     if (f == NULL) {
-        LV_LOG_WARN("fs_open: Failed to allocate memory for FIL");
         return NULL;
     }
+
+    FILINFO fno;
+    bool have_info = false;
+    f->readonly = (mode == LV_FS_MODE_RD);
+    if (mode == LV_FS_MODE_RD) {
+        // 资源包中的文件不需要 f_stat 和 f_open，包文件在启动时已经打开
+        f->packed = fs_pack_find(fatfs_path);
+        if (f->packed) {
+            if (!fs_cache_lookup(f, fatfs_path, lv_port_pack_stamp(), f->packed->size)) {
+                fs_try_cache(f, fatfs_path, lv_port_pack_stamp(), f->packed->size);
+            }
+            return f;
+        }
+        // 只读打开先查缓存，命中时不需要打开文件
+        have_info = (safe_f_stat(fatfs_path, &fno) == FR_OK);
+        if (have_info && fs_cache_lookup(f, fatfs_path, fs_file_stamp(&fno), fno.fsize)) {
+            return f;
+        }
+    } else {
+        img_cache_invalidate(fatfs_path);
+    }
     
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    FRESULT res = safe_f_open(f, fatfs_path, flags);
+    FRESULT res = safe_f_open(&f->fil, fatfs_path, flags);
     // xSemaphoreGive(spi_mutex);
 
     if (res != FR_OK) {
-        free(f);
+        fs_file_free(f);
         LV_LOG_WARN("fs_open: f_open failed for %s, error %d", fatfs_path, res);
         return NULL;
     }
 
+    if (have_info) {
+        fs_try_cache(f, fatfs_path, fs_file_stamp(&fno), fno.fsize);
+    }
+#if FS_FASTSEEK
+    if (f->readonly && f->cached == NULL) {
+        fs_fastseek_attach(f);
+    }
+#endif
     return f;
 }
 
 static lv_fs_res_t fs_close(lv_fs_drv_t *drv, void *file_p)
 {
-    FIL *f = (FIL *)file_p;
-
-    // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    FRESULT res = safe_f_close(f);
-    // xSemaphoreGive(spi_mutex);
+    fs_file_t *f = (fs_file_t *)file_p;
+    FRESULT res = FR_OK;
+
+    if (f->cached) {
+        img_cache_release(f->cached);
+    } else if (!f->packed) {
+        // xSemaphoreTake(spi_mutex, portMAX_DELAY);
+        res = safe_f_close(&f->fil);
+        // xSemaphoreGive(spi_mutex);
+#if FS_FASTSEEK
+        fs_fastseek_release(f);
+#endif
+    }
 
-    free(f); // 释放之前分配的内存
+    fs_file_free(f);
 
     return (res == FR_OK) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
 }
 
 static lv_fs_res_t fs_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br)
 {
-    FIL *f = (FIL *)file_p;
+    fs_file_t *f = (fs_file_t *)file_p;
     *br = 0;
 
-    // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    FRESULT res = safe_f_read(f, buf, btr, (UINT *)br);
-    // xSemaphoreGive(spi_mutex);
+    if (f->cached) {
+        uint32_t size = img_cache_size(f->cached);
+        uint32_t n = (f->pos < size) ? LV_MIN(btr, size - f->pos) : 0;
+        memcpy(buf, img_cache_data(f->cached) + f->pos, n);
+        f->pos += n;
+        *br = n;
+        return LV_FS_RES_OK;
+    }
+
+    FRESULT res;
+    if (!f->readonly) {
+        res = safe_f_read(&f->fil, buf, btr, (UINT *)br);
+    } else {
+#if FS_RA_SIZE > 0
+        res = fs_read_ahead(f, buf, btr, (UINT *)br);
+#else
+        res = fs_read_at(f, f->pos, buf, btr, (UINT *)br);
+        f->pos += *br;
+#endif
+    }
 
     if (res != FR_OK) {
         LV_LOG_WARN("fs_read: f_read failed, error %d", res);
@@ -202,11 +742,15 @@ static lv_fs_res_t fs_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t b
 
 static lv_fs_res_t fs_write(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw)
 {
-    FIL *f = (FIL *)file_p;
+    fs_file_t *f = (fs_file_t *)file_p;
     *bw = 0;
 
+    if (f->cached || f->packed) {
+        return LV_FS_RES_DENIED; // 缓存和资源包中的文件是只读打开的
+    }
+
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    FRESULT res = safe_f_write(f, buf, btw, (UINT *)bw);
+    FRESULT res = safe_f_write(&f->fil, buf, btw, (UINT *)bw);
     // xSemaphoreGive(spi_mutex);
 
     if (res != FR_OK || *bw < btw) {
@@ -219,23 +763,36 @@ static lv_fs_res_t fs_write(lv_fs_drv_t *drv, void *file_p, const void *buf, uin
 
 static lv_fs_res_t fs_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence)
 {
-    FIL *f = (FIL *)file_p;
+    fs_file_t *f = (fs_file_t *)file_p;
     FRESULT res;
 
+    if (f->readonly) {
+        // 只记录位置，下一次读取不在预读缓冲中时才 f_lseek
+        if (whence == LV_FS_SEEK_CUR) {
+            pos += f->pos;
+        } else if (whence == LV_FS_SEEK_END) {
+            pos += f->cached ? img_cache_size(f->cached) : f->packed ? f->packed->size : safe_f_size(&f->fil);
+        } else if (whence != LV_FS_SEEK_SET) {
+            return LV_FS_RES_INV_PARAM;
+        }
+        f->pos = pos;
+        return LV_FS_RES_OK;
+    }
+
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
     // f_lseek 的 whence 只有 SEEK_SET, SEEK_CUR, SEEK_END，但 FatFs f_lseek 只接受绝对偏移量
     // 因此需要根据 whence 计算出绝对位置
     FSIZE_t new_pos = pos;
     if (whence == LV_FS_SEEK_CUR) {
-        new_pos = safe_f_tell(f) + pos;
+        new_pos = safe_f_tell(&f->fil) + pos;
     } else if (whence == LV_FS_SEEK_END) {
-        new_pos = safe_f_size(f) + pos; // 注意：pos 通常为负数
+        new_pos = safe_f_size(&f->fil) + pos; // 注意：pos 通常为负数
     } else if (whence != LV_FS_SEEK_SET) {
         // xSemaphoreGive(spi_mutex);
         return LV_FS_RES_INV_PARAM;
     }
 
-    res = safe_f_lseek(f, new_pos);
+    res = safe_f_lseek(&f->fil, new_pos);
     // xSemaphoreGive(spi_mutex);
 
     if (res != FR_OK) {
@@ -248,10 +805,15 @@ static lv_fs_res_t fs_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_w
 
 static lv_fs_res_t fs_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p)
 {
-    FIL *f = (FIL *)file_p;
+    fs_file_t *f = (fs_file_t *)file_p;
+
+    if (f->readonly) {
+        *pos_p = f->pos;
+        return LV_FS_RES_OK;
+    }
     
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    *pos_p = safe_f_tell(f);
+    *pos_p = safe_f_tell(&f->fil);
     // xSemaphoreGive(spi_mutex);
     
     // f_tell 返回的是 FSIZE_t，这里我们假设它不会超过 uint32_t 的范围
@@ -260,21 +822,28 @@ static lv_fs_res_t fs_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p)
 
 static void *fs_dir_open(lv_fs_drv_t *drv, const char *path)
 {
-    const char *fatfs_path = lv_path_to_fatfs_path(drv, path);
+    char fatfs_path[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_sd, path, fatfs_path, sizeof(fatfs_path))) {
+        return NULL;
+    }
 
-    // 为目录句柄分配内存
-    FF_DIR *d = malloc(sizeof(FF_DIR));
+    // 从句柄池中取一个目录句柄
+    fs_dir_t *d = fs_dir_alloc();
     if (d == NULL) {
-        LV_LOG_WARN("fs_dir_open: Failed to allocate memory for FF_DIR");
         return NULL;
     }
 
+    d->indexed = safe_fatfs_index_opendir(&d->idx, fatfs_path);
+    if (d->indexed) {
+        return d;
+    }
+
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    FRESULT res = safe_f_opendir(d, fatfs_path);
+    FRESULT res = safe_f_opendir(&d->dir, fatfs_path);
     // xSemaphoreGive(spi_mutex);
 
     if (res != FR_OK) {
-        free(d);
+        fs_dir_free(d);
         LV_LOG_WARN("fs_dir_open: f_opendir failed for %s, error %d", fatfs_path, res);
         return NULL;
     }
@@ -284,7 +853,7 @@ static void *fs_dir_open(lv_fs_drv_t *drv, const char *path)
 
 static lv_fs_res_t fs_dir_read(lv_fs_drv_t *drv, void *rddir_p, char *fn)
 {
-    FF_DIR *d = (FF_DIR *)rddir_p;
+    fs_dir_t *d = (fs_dir_t *)rddir_p;
     FILINFO fno;
     FRESULT res;
 
@@ -292,7 +861,7 @@ static lv_fs_res_t fs_dir_read(lv_fs_drv_t *drv, void *rddir_p, char *fn)
 
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
     do {
-        res = safe_f_readdir(d, &fno);
+        res = d->indexed ? safe_fatfs_index_readdir(&d->idx, &fno) : safe_f_readdir(&d->dir, &fno);
         // 如果没有更多文件或发生错误，跳出循环
         if (res != FR_OK || fno.fname[0] == 0) {
             break; 
@@ -320,20 +889,24 @@ static lv_fs_res_t fs_dir_read(lv_fs_drv_t *drv, void *rddir_p, char *fn)
 
 static lv_fs_res_t fs_dir_close(lv_fs_drv_t *drv, void *rddir_p)
 {
-    FF_DIR *d = (FF_DIR *)rddir_p;
+    fs_dir_t *d = (fs_dir_t *)rddir_p;
 
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
-    FRESULT res = safe_f_closedir(d);
+    FRESULT res = d->indexed ? FR_OK : safe_f_closedir(&d->dir);
     // xSemaphoreGive(spi_mutex);
 
-    free(d); // 释放目录句柄内存
+    fs_dir_free(d); // 归还目录句柄
 
     return (res == FR_OK) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
 }
 
 static lv_fs_res_t fs_remove(lv_fs_drv_t *drv, const char *path)
 {
-    const char *fatfs_path = lv_path_to_fatfs_path(drv, path);
+    char fatfs_path[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_sd, path, fatfs_path, sizeof(fatfs_path))) {
+        return LV_FS_RES_INV_PARAM;
+    }
+    img_cache_invalidate(fatfs_path);
 
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
     FRESULT res = safe_f_unlink(fatfs_path);
@@ -349,8 +922,14 @@ static lv_fs_res_t fs_remove(lv_fs_drv_t *drv, const char *path)
 
 static lv_fs_res_t fs_rename(lv_fs_drv_t *drv, const char *oldname, const char *newname)
 {
-    const char *fatfs_old = lv_path_to_fatfs_path(drv, oldname);
-    const char *fatfs_new = lv_path_to_fatfs_path(drv, newname);
+    char fatfs_old[FS_PATH_MAX];
+    char fatfs_new[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_sd, oldname, fatfs_old, sizeof(fatfs_old)) ||
+            !fs_path_translate(&s_vol_sd, newname, fatfs_new, sizeof(fatfs_new))) {
+        return LV_FS_RES_INV_PARAM;
+    }
+    img_cache_invalidate(fatfs_old);
+    img_cache_invalidate(fatfs_new);
 
     // xSemaphoreTake(spi_mutex, portMAX_DELAY);
     FRESULT res = safe_f_rename(fatfs_old, fatfs_new);
@@ -364,6 +943,129 @@ static lv_fs_res_t fs_rename(lv_fs_drv_t *drv, const char *oldname, const char *
     return LV_FS_RES_OK;
 }
 
+#if CONFIG_APP_FS_LITTLEFS_DRIVE
+/*
+ * LittleFS 盘：通过 VFS 的 open/read/lseek 访问，不经过 stdio 缓冲 (LittleFS 自己有缓存)。
+ * 文件句柄直接保存 fd + 1，fd 为 0 时也不会被 LVGL 当作打开失败的 NULL。
+ */
+#define FLASH_FD(file_p)    ((int)(intptr_t)(file_p) - 1)
+
+static void *flash_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
+{
+    char vfs_path[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_flash, path, vfs_path, sizeof(vfs_path))) {
+        return NULL;
+    }
+
+    int flags = O_RDONLY;
+    if (mode == LV_FS_MODE_WR) {
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+    } else if (mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) {
+        flags = O_RDWR | O_CREAT;
+    }
+
+    int fd = open(vfs_path, flags, 0666);
+    if (fd < 0) {
+        LV_LOG_WARN("flash_open: open failed for %s, errno %d", vfs_path, errno);
+        return NULL;
+    }
+    return (void *)(intptr_t)(fd + 1);
+}
+
+static lv_fs_res_t flash_close(lv_fs_drv_t *drv, void *file_p)
+{
+    return (close(FLASH_FD(file_p)) == 0) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+static lv_fs_res_t flash_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br)
+{
+    ssize_t n = read(FLASH_FD(file_p), buf, btr);
+    if (n < 0) {
+        *br = 0;
+        LV_LOG_WARN("flash_read: read failed, errno %d", errno);
+        return LV_FS_RES_FS_ERR;
+    }
+    *br = (uint32_t)n;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t flash_write(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw)
+{
+    ssize_t n = write(FLASH_FD(file_p), buf, btw);
+    *bw = (n > 0) ? (uint32_t)n : 0;
+    if (n < 0 || *bw < btw) {
+        LV_LOG_WARN("flash_write: write failed, errno %d", errno);
+        return LV_FS_RES_FS_ERR;
+    }
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t flash_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    int w;
+    if (whence == LV_FS_SEEK_SET) {
+        w = SEEK_SET;
+    } else if (whence == LV_FS_SEEK_CUR) {
+        w = SEEK_CUR;
+    } else if (whence == LV_FS_SEEK_END) {
+        w = SEEK_END;
+    } else {
+        return LV_FS_RES_INV_PARAM;
+    }
+    // SEEK_CUR/SEEK_END 的 pos 可能是负数，按有符号偏移传给 lseek
+    off_t ofs = (whence == LV_FS_SEEK_SET) ? (off_t)pos : (off_t)(int32_t)pos;
+    return (lseek(FLASH_FD(file_p), ofs, w) >= 0) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+static lv_fs_res_t flash_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p)
+{
+    off_t pos = lseek(FLASH_FD(file_p), 0, SEEK_CUR);
+    if (pos < 0) {
+        return LV_FS_RES_FS_ERR;
+    }
+    *pos_p = (uint32_t)pos;
+    return LV_FS_RES_OK;
+}
+
+static void *flash_dir_open(lv_fs_drv_t *drv, const char *path)
+{
+    char vfs_path[FS_PATH_MAX];
+    if (!fs_path_translate(&s_vol_flash, path, vfs_path, sizeof(vfs_path))) {
+        return NULL;
+    }
+    DIR *d = opendir(vfs_path);
+    if (d == NULL) {
+        LV_LOG_WARN("flash_dir_open: opendir failed for %s", vfs_path);
+    }
+    return d;
+}
+
+static lv_fs_res_t flash_dir_read(lv_fs_drv_t *drv, void *rddir_p, char *fn)
+{
+    struct dirent *entry;
+
+    fn[0] = '\0';
+    do {
+        entry = readdir((DIR *)rddir_p);
+    } while (entry && (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0));
+
+    if (entry) {
+        // 和 FatFs 盘一样，目录名前加 '/'
+        size_t off = 0;
+        if (entry->d_type == DT_DIR) {
+            fn[off++] = '/';
+        }
+        strlcpy(fn + off, entry->d_name, LV_FS_MAX_FN_LENGTH - off);
+    }
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t flash_dir_close(lv_fs_drv_t *drv, void *rddir_p)
+{
+    return (closedir((DIR *)rddir_p) == 0) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+#endif
+
 #else /*Enable this file at the top*/
 /*This dummy typedef exists purely to silence -Wpedantic.*/
 typedef int keep_pedantic_happy;
@@ -0,0 +1,882 @@
+// lv_port_gif.c
+//
+// LVGL 8 自带的 lv_gif (gifdec) 每一帧都把整张画布重新转换一遍并重绘整个控件，
+// 160 MHz 的 C3 上放 150x150 的动画已经跟不上 GIF 声明的帧间隔。这里自己解码：
+//   - 画布 (LV_IMG_CF_TRUE_COLOR_ALPHA) 只分配一次，LZW 解码直接把调色板颜色写进画布；
+//   - 只重绘这一帧的区域和上一帧 disposal 涉及的区域；
+//   - 解码后的帧区域按播放顺序缓存，预算用完就不再缓存 (循环播放时 LRU 会全部失效)，
+//     循环播放时命中缓存的帧只需要复制像素，不再读文件和解码 LZW；
+//   - 按 GIF 声明的延时排定下一帧，统计实际帧率和解码耗时。
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "lv_port_gif.h"
+
+static const char *TAG = "gif";
+
+#define GIF_IN_BUF_SIZE         (512)
+#define GIF_LZW_MAX_CODES       (4096)
+#define GIF_PX_SIZE             (LV_IMG_PX_SIZE_ALPHA_BYTE)
+#define GIF_CACHE_BYTES         (CONFIG_APP_GIF_CACHE_KB * 1024)
+#define GIF_CACHE_MIN_FREE      (32 * 1024)     // 缓存一帧之后系统堆至少还剩这么多
+#define GIF_MIN_DELAY_MS        (20)            // 更短的延时和浏览器一样按 100ms 处理
+#define GIF_DEFAULT_DELAY_MS    (100)
+#define GIF_LATE_TOLERANCE_MS   (10)
+#define GIF_NAME_LEN            (24)
+
+typedef enum {
+    GIF_DISPOSE_NONE = 0,
+    GIF_DISPOSE_KEEP = 1,
+    GIF_DISPOSE_BACKGROUND = 2,
+    GIF_DISPOSE_PREVIOUS = 3,
+} gif_disposal_t;
+
+typedef struct {
+    uint32_t next_off;          // 这一帧数据之后的文件位置
+    uint16_t delay_ms;
+    uint8_t disposal;
+    lv_area_t rect;             // 裁剪到画布之后的帧区域，可能为空
+    uint8_t *pixels;            // 合成之后的帧区域像素，NULL 表示没有缓存
+} gif_frame_t;
+
+/* LZW 字典，所有播放器共用 (只在 LVGL 任务中解码) */
+typedef struct {
+    uint16_t prefix[GIF_LZW_MAX_CODES];
+    uint8_t suffix[GIF_LZW_MAX_CODES];
+    uint8_t stack[GIF_LZW_MAX_CODES + 1];
+} gif_lzw_t;
+
+/* 图像描述符和这一帧的图形控制扩展 */
+typedef struct {
+    uint16_t fx, fy, fw, fh;
+    bool interlace;
+    int16_t trans;              // 透明色索引，-1 表示没有
+    const lv_color_t *pal;
+} gif_img_t;
+
+/* LZW 输出位置 */
+typedef struct {
+    uint8_t *canvas;
+    int32_t cw, ch;
+    const gif_img_t *img;
+    int32_t x_max;              // 每行中落在画布内的像素数
+    int32_t x, y;
+    uint8_t pass;
+    uint8_t *row;               // 当前行第一个像素在画布中的位置，NULL 表示这一行在画布外
+    uint32_t left;              // 还需要输出的像素数
+} gif_out_t;
+
+typedef struct {
+    lv_img_t img;
+    lv_img_dsc_t dsc;
+    lv_timer_t *timer;
+    char name[GIF_NAME_LEN];
+    lv_fs_file_t file;
+    bool file_open;
+    uint8_t *canvas;
+    // 调色板和输入缓冲约 1.5 KB，放在堆上，不占 LVGL 内存池
+    lv_color_t *gpal;
+    lv_color_t *lpal;
+    /* 输入缓冲 */
+    uint8_t *in_buf;
+    uint32_t in_off;
+    uint32_t in_len;
+    uint32_t pos;
+    uint32_t anim_start;        // 第一帧之前的文件位置
+    /* 帧表，第一遍播放时建立 */
+    gif_frame_t *frames;
+    uint16_t frame_count;
+    uint16_t frame_cap;
+    bool frames_complete;
+    uint16_t cur;               // 下一帧
+    bool shown;                 // 画布上已经有一帧
+    uint32_t cache_bytes;
+    /* disposal 3 (恢复到上一帧) 保存的区域 */
+    uint8_t *prev;
+    uint32_t prev_cap;
+    lv_area_t prev_rect;
+    /* 播放 */
+    uint16_t loop_limit;        // 第一次播放之后再重复的次数，没有 NETSCAPE 扩展时只播放一次
+    bool loop_forever;          // NETSCAPE 扩展中的循环次数为 0
+    uint32_t next_due;
+    uint32_t loop_start;
+    uint32_t loop_declared;
+    uint32_t loop_decoded;
+    uint32_t loop_hits;
+    uint32_t loop_late;
+    uint64_t loop_decode_us;
+    uint32_t loop_decode_max;
+    lv_port_gif_stats_t stats;
+} lv_port_gif_t;
+
+static void lv_port_gif_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+static void lv_port_gif_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj);
+
+const lv_obj_class_t lv_port_gif_class = {
+    .constructor_cb = lv_port_gif_constructor,
+    .destructor_cb = lv_port_gif_destructor,
+    .instance_size = sizeof(lv_port_gif_t),
+    .base_class = &lv_img_class,
+};
+
+static gif_lzw_t *s_lzw;
+static uint32_t s_lzw_users;
+
+static uint32_t le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static bool area_empty(const lv_area_t *a)
+{
+    return a->x2 < a->x1 || a->y2 < a->y1;
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 文件读取
+ * ---------------------------------------------------------------------------
+ */
+
+static bool gif_read(lv_port_gif_t *gif, uint8_t *dst, uint32_t n)
+{
+    while (n > 0) {
+        if (gif->pos < gif->in_off || gif->pos >= gif->in_off + gif->in_len) {
+            uint32_t br = 0;
+            gif->in_len = 0;
+            if (lv_fs_seek(&gif->file, gif->pos, LV_FS_SEEK_SET) != LV_FS_RES_OK ||
+                    lv_fs_read(&gif->file, gif->in_buf, GIF_IN_BUF_SIZE, &br) != LV_FS_RES_OK || br == 0) {
+                return false;
+            }
+            gif->in_off = gif->pos;
+            gif->in_len = br;
+        }
+        uint32_t off = gif->pos - gif->in_off;
+        uint32_t m = LV_MIN(n, gif->in_len - off);
+        memcpy(dst, gif->in_buf + off, m);
+        dst += m;
+        gif->pos += m;
+        n -= m;
+    }
+    return true;
+}
+
+/* 返回下一个字节，出错时返回 -1 */
+static inline int gif_byte(lv_port_gif_t *gif)
+{
+    if (gif->pos >= gif->in_off && gif->pos < gif->in_off + gif->in_len) {
+        return gif->in_buf[gif->pos++ - gif->in_off];
+    }
+    uint8_t b;
+    return gif_read(gif, &b, 1) ? b : -1;
+}
+
+static bool gif_skip_sub_blocks(lv_port_gif_t *gif)
+{
+    while (true) {
+        int len = gif_byte(gif);
+        if (len <= 0) {
+            return len == 0;
+        }
+        gif->pos += len;
+    }
+}
+
+static bool gif_read_palette(lv_port_gif_t *gif, lv_color_t *pal, uint32_t count)
+{
+    uint8_t rgb[48];
+    for (uint32_t i = 0; i < count; i += 16) {
+        uint32_t n = LV_MIN(count - i, 16);
+        if (!gif_read(gif, rgb, n * 3)) {
+            return false;
+        }
+        for (uint32_t k = 0; k < n; k++) {
+            pal[i + k] = lv_color_make(rgb[k * 3], rgb[k * 3 + 1], rgb[k * 3 + 2]);
+        }
+    }
+    return true;
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 解码
+ * ---------------------------------------------------------------------------
+ */
+
+/* 读取扩展块和图像描述符，停在 LZW 数据之前。返回 1: 一帧，0: 文件结束，-1: 出错 */
+static int gif_parse_frame(lv_port_gif_t *gif, gif_frame_t *f, gif_img_t *img)
+{
+    uint8_t buf[11];
+    uint16_t delay = 0;
+
+    f->disposal = GIF_DISPOSE_NONE;
+    img->trans = -1;
+    while (true) {
+        int b = gif_byte(gif);
+        if (b == 0x3B) {
+            return 0;
+        }
+        if (b == 0x21) {
+            int label = gif_byte(gif);
+            int len = gif_byte(gif);
+            if (label < 0 || len < 0) {
+                return -1;
+            }
+            if (label == 0xF9 && len >= 4) {
+                // 图形控制扩展
+                if (!gif_read(gif, buf, 4)) {
+                    return -1;
+                }
+                f->disposal = (buf[0] >> 2) & 0x07;
+                delay = le16(buf + 1) * 10;
+                if (buf[0] & 0x01) {
+                    img->trans = buf[3];
+                }
+                gif->pos += len - 4;
+            } else if (label == 0xFF && len == 11) {
+                // NETSCAPE2.0 循环次数
+                if (!gif_read(gif, buf, 11)) {
+                    return -1;
+                }
+                if (memcmp(buf, "NETSCAPE2.0", 11) == 0) {
+                    int n = gif_byte(gif);
+                    if (n >= 3) {
+                        if (!gif_read(gif, buf, 3)) {
+                            return -1;
+                        }
+                        if (buf[0] == 1) {
+                            gif->loop_limit = le16(buf + 1);
+                            gif->loop_forever = (gif->loop_limit == 0);
+                        }
+                        n -= 3;
+                    }
+                    if (n < 0) {
+                        return -1;
+                    }
+                    gif->pos += n;
+                }
+            } else {
+                gif->pos += len;
+            }
+            if (!gif_skip_sub_blocks(gif)) {
+                return -1;
+            }
+            continue;
+        }
+        if (b != 0x2C) {
+            return -1;
+        }
+
+        uint8_t d[9];
+        if (!gif_read(gif, d, sizeof(d))) {
+            return -1;
+        }
+        img->fx = le16(d);
+        img->fy = le16(d + 2);
+        img->fw = le16(d + 4);
+        img->fh = le16(d + 6);
+        img->interlace = (d[8] & 0x40) != 0;
+        img->pal = gif->gpal;
+        if (d[8] & 0x80) {
+            if (!gif_read_palette(gif, gif->lpal, 2u << (d[8] & 0x07))) {
+                return -1;
+            }
+            img->pal = gif->lpal;
+        }
+
+        f->delay_ms = (delay < GIF_MIN_DELAY_MS) ? GIF_DEFAULT_DELAY_MS : delay;
+        f->rect.x1 = img->fx;
+        f->rect.y1 = img->fy;
+        f->rect.x2 = LV_MIN(img->fx + img->fw, gif->dsc.header.w) - 1;
+        f->rect.y2 = LV_MIN(img->fy + img->fh, gif->dsc.header.h) - 1;
+        return 1;
+    }
+}
+
+static void gif_out_row(gif_out_t *o)
+{
+    int32_t cy = o->img->fy + o->y;
+    o->row = (o->y < o->img->fh && cy < o->ch && o->x_max > 0) ?
+             o->canvas + (cy * o->cw + o->img->fx) * GIF_PX_SIZE : NULL;
+}
+
+static inline void gif_emit(gif_out_t *o, uint8_t idx)
+{
+    if (o->row && o->x < o->x_max && idx != o->img->trans) {
+        uint8_t *p = o->row + o->x * GIF_PX_SIZE;
+        lv_color_t c = o->img->pal[idx];
+        memcpy(p, &c, sizeof(c));
+        p[GIF_PX_SIZE - 1] = LV_OPA_COVER;
+    }
+    o->left--;
+    if (++o->x < o->img->fw) {
+        return;
+    }
+    o->x = 0;
+    if (o->img->interlace) {
+        static const uint8_t start[4] = {0, 4, 2, 1};
+        static const uint8_t step[4] = {8, 8, 4, 2};
+        o->y += step[o->pass];
+        while (o->y >= o->img->fh && o->pass < 3) {
+            o->pass++;
+            o->y = start[o->pass];
+        }
+    } else {
+        o->y++;
+    }
+    gif_out_row(o);
+}
+
+/* LZW 解码一帧并合成到画布上，停在这一帧数据之后 */
+static bool gif_lzw_decode(lv_port_gif_t *gif, const gif_img_t *img)
+{
+    gif_lzw_t *t = s_lzw;
+    gif_out_t o = {
+        .canvas = gif->canvas,
+        .cw = gif->dsc.header.w,
+        .ch = gif->dsc.header.h,
+        .img = img,
+        .x_max = LV_MIN((int32_t)img->fw, (int32_t)gif->dsc.header.w - img->fx),
+        .left = (uint32_t)img->fw * img->fh,
+    };
+    gif_out_row(&o);
+
+    int mcs = gif_byte(gif);
+    if (mcs < 1 || mcs > 8) {
+        return false;
+    }
+    const uint32_t clear = 1u << mcs;
+    const uint32_t eoi = clear + 1;
+    uint32_t code_size = mcs + 1;
+    uint32_t next = eoi + 1;
+    int32_t prev = -1;
+    uint8_t first = 0;
+    uint32_t acc = 0;
+    uint32_t nbits = 0;
+    int blk_left = 0;
+
+    while (o.left > 0) {
+        while (nbits < code_size) {
+            if (blk_left == 0) {
+                blk_left = gif_byte(gif);
+                if (blk_left <= 0) {
+                    // 数据提前结束，保留已经解码的部分
+                    return blk_left == 0;
+                }
+            }
+            int b = gif_byte(gif);
+            if (b < 0) {
+                return false;
+            }
+            acc |= (uint32_t)b << nbits;
+            nbits += 8;
+            blk_left--;
+        }
+        uint32_t code = acc & ((1u << code_size) - 1);
+        acc >>= code_size;
+        nbits -= code_size;
+
+        if (code == clear) {
+            code_size = mcs + 1;
+            next = eoi + 1;
+            prev = -1;
+            continue;
+        }
+        if (code == eoi) {
+            break;
+        }
+        if (prev < 0) {
+            if (code >= clear) {
+                return false;
+            }
+            first = code;
+            prev = code;
+            gif_emit(&o, code);
+            continue;
+        }
+
+        uint8_t *sp = t->stack;
+        uint32_t in = code;
+        if (code >= next) {
+            if (code > next) {
+                return false;
+            }
+            *sp++ = first;
+            in = prev;
+        }
+        while (in >= clear) {
+            *sp++ = t->suffix[in];
+            in = t->prefix[in];
+        }
+        first = in;
+        *sp++ = first;
+        if (next < GIF_LZW_MAX_CODES) {
+            t->prefix[next] = prev;
+            t->suffix[next] = first;
+            next++;
+            if (next == (1u << code_size) && code_size < 12) {
+                code_size++;
+            }
+        }
+        prev = code;
+        while (sp > t->stack && o.left > 0) {
+            gif_emit(&o, *--sp);
+        }
+    }
+
+    gif->pos += blk_left;
+    return gif_skip_sub_blocks(gif);
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 画布
+ * ---------------------------------------------------------------------------
+ */
+
+static void gif_rect_copy(lv_port_gif_t *gif, const lv_area_t *r, uint8_t *buf, bool to_canvas)
+{
+    const uint32_t row_bytes = lv_area_get_width(r) * GIF_PX_SIZE;
+    const uint32_t stride = gif->dsc.header.w * GIF_PX_SIZE;
+    uint8_t *c = gif->canvas + (r->y1 * gif->dsc.header.w + r->x1) * GIF_PX_SIZE;
+
+    for (lv_coord_t y = r->y1; y <= r->y2; y++) {
+        if (to_canvas) {
+            memcpy(c, buf, row_bytes);
+        } else {
+            memcpy(buf, c, row_bytes);
+        }
+        c += stride;
+        buf += row_bytes;
+    }
+}
+
+static void gif_rect_clear(lv_port_gif_t *gif, const lv_area_t *r)
+{
+    const uint32_t row_bytes = lv_area_get_width(r) * GIF_PX_SIZE;
+    const uint32_t stride = gif->dsc.header.w * GIF_PX_SIZE;
+    uint8_t *c = gif->canvas + (r->y1 * gif->dsc.header.w + r->x1) * GIF_PX_SIZE;
+
+    for (lv_coord_t y = r->y1; y <= r->y2; y++) {
+        memset(c, 0, row_bytes);
+        c += stride;
+    }
+}
+
+static void gif_save_prev(lv_port_gif_t *gif, const lv_area_t *r)
+{
+    uint32_t size = lv_area_get_size(r) * GIF_PX_SIZE;
+    if (size > gif->prev_cap) {
+        uint8_t *buf = realloc(gif->prev, size);
+        if (buf == NULL) {
+            ESP_LOGW(TAG, "%s: no mem to keep previous frame", gif->name);
+            gif->prev_rect.x2 = gif->prev_rect.x1 - 1;
+            return;
+        }
+        gif->prev = buf;
+        gif->prev_cap = size;
+    }
+    gif_rect_copy(gif, r, gif->prev, false);
+    gif->prev_rect = *r;
+}
+
+static void gif_cache_frame(lv_port_gif_t *gif, gif_frame_t *f)
+{
+    if (f->pixels || area_empty(&f->rect)) {
+        return;
+    }
+    uint32_t size = lv_area_get_size(&f->rect) * GIF_PX_SIZE;
+    if (gif->cache_bytes + size > GIF_CACHE_BYTES ||
+            heap_caps_get_free_size(MALLOC_CAP_8BIT) < size + GIF_CACHE_MIN_FREE) {
+        return;
+    }
+    f->pixels = malloc(size);
+    if (f->pixels) {
+        gif_rect_copy(gif, &f->rect, f->pixels, false);
+        gif->cache_bytes += size;
+        gif->stats.cached_frames++;
+    }
+}
+
+static void area_join(lv_area_t *dirty, bool *valid, const lv_area_t *a)
+{
+    if (area_empty(a)) {
+        return;
+    }
+    if (*valid) {
+        _lv_area_join(dirty, dirty, a);
+    } else {
+        *dirty = *a;
+        *valid = true;
+    }
+}
+
+static void gif_invalidate(lv_obj_t *obj, const lv_area_t *a)
+{
+    lv_img_t *img = (lv_img_t *)obj;
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+
+    // 缩放、旋转或平铺时帧区域和屏幕区域不是简单的平移关系，重绘整个控件
+    if (img->zoom != LV_IMG_ZOOM_NONE || img->angle != 0 || img->offset.x || img->offset.y ||
+            lv_area_get_width(&content) != img->w || lv_area_get_height(&content) != img->h) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+    lv_area_t abs = *a;
+    lv_area_move(&abs, content.x1, content.y1);
+    lv_obj_invalidate_area(obj, &abs);
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 播放
+ * ---------------------------------------------------------------------------
+ */
+
+static void gif_loop_done(lv_port_gif_t *gif)
+{
+    lv_port_gif_stats_t *st = &gif->stats;
+    uint32_t frames = gif->loop_decoded + gif->loop_hits;
+
+    st->loops++;
+    st->declared_ms = gif->loop_declared;
+    st->actual_ms = lv_tick_elaps(gif->loop_start);
+    st->decoded = gif->loop_decoded;
+    st->cache_hits = gif->loop_hits;
+    st->late = gif->loop_late;
+    st->decode_avg_us = gif->loop_decoded ? (uint32_t)(gif->loop_decode_us / gif->loop_decoded) : 0;
+    st->decode_max_us = gif->loop_decode_max;
+
+#if CONFIG_APP_GIF_STATS
+    uint32_t fps10 = st->actual_ms ? frames * 10000 / st->actual_ms : 0;
+    uint32_t want10 = st->declared_ms ? frames * 10000 / st->declared_ms : 0;
+    ESP_LOGI(TAG, "%s loop %" PRIu32 ": %" PRIu32 " frames in %" PRIu32 " ms (declared %" PRIu32 " ms), "
+             "%" PRIu32 ".%" PRIu32 " fps vs %" PRIu32 ".%" PRIu32 " fps, late %" PRIu32 ", "
+             "decoded %" PRIu32 " cached %" PRIu32 ", decode avg %" PRIu32 " us max %" PRIu32 " us, "
+             "cache %" PRIu32 " KB",
+             gif->name, st->loops, frames, st->actual_ms, st->declared_ms,
+             fps10 / 10, fps10 % 10, want10 / 10, want10 % 10, st->late,
+             st->decoded, st->cache_hits, st->decode_avg_us, st->decode_max_us,
+             st->cache_bytes / 1024);
+#else
+    (void)frames;
+#endif
+
+    gif->loop_declared = 0;
+    gif->loop_decoded = 0;
+    gif->loop_hits = 0;
+    gif->loop_late = 0;
+    gif->loop_decode_us = 0;
+    gif->loop_decode_max = 0;
+}
+
+static gif_frame_t *gif_frame_slot(lv_port_gif_t *gif, uint16_t index)
+{
+    if (index < gif->frame_count) {
+        return &gif->frames[index];
+    }
+    if (gif->frame_count == gif->frame_cap) {
+        uint16_t cap = gif->frame_cap ? gif->frame_cap * 2 : 16;
+        gif_frame_t *frames = realloc(gif->frames, cap * sizeof(gif_frame_t));
+        if (frames == NULL) {
+            return NULL;
+        }
+        gif->frames = frames;
+        gif->frame_cap = cap;
+    }
+    gif_frame_t *f = &gif->frames[gif->frame_count++];
+    memset(f, 0, sizeof(*f));
+    gif->stats.frame_count = gif->frame_count;
+    return f;
+}
+
+/* 把下一帧画到画布上。返回 false 表示动画已经播放完 (或者一帧也解不出来) */
+static bool gif_show_next(lv_port_gif_t *gif)
+{
+    lv_obj_t *obj = (lv_obj_t *)gif;
+    lv_area_t dirty;
+    bool dirty_valid = false;
+
+    if (gif->frames_complete && gif->cur >= gif->frame_count) {
+        gif_loop_done(gif);
+        if (!gif->loop_forever && gif->stats.loops > gif->loop_limit) {
+            return false;
+        }
+        gif->cur = 0;
+    }
+
+    // 上一帧的 disposal
+    if (gif->cur == 0) {
+        if (gif->shown) {
+            memset(gif->canvas, 0, gif->dsc.data_size);
+            lv_area_t full = {0, 0, gif->dsc.header.w - 1, gif->dsc.header.h - 1};
+            area_join(&dirty, &dirty_valid, &full);
+        }
+        gif->loop_start = lv_tick_get();
+    } else {
+        const gif_frame_t *last = &gif->frames[gif->cur - 1];
+        if (last->disposal == GIF_DISPOSE_BACKGROUND && !area_empty(&last->rect)) {
+            gif_rect_clear(gif, &last->rect);
+            area_join(&dirty, &dirty_valid, &last->rect);
+        } else if (last->disposal == GIF_DISPOSE_PREVIOUS && !area_empty(&gif->prev_rect)) {
+            gif_rect_copy(gif, &gif->prev_rect, gif->prev, true);
+            area_join(&dirty, &dirty_valid, &gif->prev_rect);
+        }
+    }
+
+    gif_frame_t *f;
+    if (gif->cur < gif->frame_count && gif->frames[gif->cur].pixels) {
+        f = &gif->frames[gif->cur];
+        if (f->disposal == GIF_DISPOSE_PREVIOUS) {
+            gif_save_prev(gif, &f->rect);
+        }
+        gif_rect_copy(gif, &f->rect, f->pixels, true);
+        gif->loop_hits++;
+    } else {
+        int64_t t0 = esp_timer_get_time();
+        gif_frame_t parsed = {0};
+        gif_img_t img;
+
+        gif->pos = gif->cur ? gif->frames[gif->cur - 1].next_off : gif->anim_start;
+        int res = gif_parse_frame(gif, &parsed, &img);
+        if (res <= 0) {
+            if (res < 0) {
+                ESP_LOGW(TAG, "%s: bad data after %u frames", gif->name, gif->cur);
+            }
+            if (gif->cur == 0) {
+                return false;
+            }
+            // 第一遍播放到了文件末尾
+            gif->frames_complete = true;
+            gif->frame_count = gif->cur;
+            gif->stats.frame_count = gif->cur;
+            if (dirty_valid) {
+                gif_invalidate(obj, &dirty);
+            }
+            return gif_show_next(gif);
+        }
+
+        f = gif_frame_slot(gif, gif->cur);
+        if (f == NULL) {
+            return false;
+        }
+        f->delay_ms = parsed.delay_ms;
+        f->disposal = parsed.disposal;
+        f->rect = parsed.rect;
+        if (f->disposal == GIF_DISPOSE_PREVIOUS) {
+            gif_save_prev(gif, &f->rect);
+        }
+        if (!gif_lzw_decode(gif, &img)) {
+            // 这一帧解出多少显示多少，动画到这一帧为止
+            ESP_LOGW(TAG, "%s: corrupt frame %u", gif->name, gif->cur);
+            gif->frames_complete = true;
+            gif->frame_count = gif->cur + 1;
+            gif->stats.frame_count = gif->frame_count;
+        }
+        f->next_off = gif->pos;
+        gif_cache_frame(gif, f);
+
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        gif->loop_decoded++;
+        gif->loop_decode_us += us;
+        gif->loop_decode_max = LV_MAX(gif->loop_decode_max, us);
+    }
+    gif->stats.cache_bytes = gif->cache_bytes;
+
+    area_join(&dirty, &dirty_valid, &f->rect);
+    if (dirty_valid) {
+        gif_invalidate(obj, &dirty);
+    }
+    gif->loop_declared += f->delay_ms;
+    gif->shown = true;
+    gif->cur++;
+    return true;
+}
+
+static void gif_timer_cb(lv_timer_t *t)
+{
+    lv_obj_t *obj = t->user_data;
+    lv_port_gif_t *gif = (lv_port_gif_t *)obj;
+    uint32_t now = lv_tick_get();
+
+    if (!gif_show_next(gif)) {
+        lv_timer_pause(t);
+        lv_event_send(obj, LV_EVENT_READY, NULL);
+        return;
+    }
+
+    // 按声明的延时排定下一帧；已经晚了就从现在重新计时，不靠缩短后面的帧追赶
+    if ((int32_t)(now - gif->next_due) > GIF_LATE_TOLERANCE_MS) {
+        gif->loop_late++;
+        gif->next_due = now;
+    }
+    gif->next_due += gif->frames[gif->cur - 1].delay_ms;
+    int32_t period = (int32_t)(gif->next_due - now);
+    lv_timer_set_period(t, LV_MAX(period, 1));
+}
+
+static void gif_close(lv_port_gif_t *gif)
+{
+    if (gif->timer) {
+        lv_timer_pause(gif->timer);
+    }
+    if (gif->file_open) {
+        lv_fs_close(&gif->file);
+        gif->file_open = false;
+    }
+    for (uint16_t i = 0; i < gif->frame_count; i++) {
+        free(gif->frames[i].pixels);
+    }
+    free(gif->frames);
+    gif->frames = NULL;
+    gif->frame_count = 0;
+    gif->frame_cap = 0;
+    gif->frames_complete = false;
+    gif->cache_bytes = 0;
+    free(gif->prev);
+    gif->prev = NULL;
+    gif->prev_cap = 0;
+    lv_img_cache_invalidate_src(&gif->dsc);
+    free(gif->canvas);
+    gif->canvas = NULL;
+    gif->dsc.data = NULL;
+    memset(&gif->stats, 0, sizeof(gif->stats));
+}
+
+lv_obj_t *lv_port_gif_create(lv_obj_t *parent)
+{
+    lv_obj_t *obj = lv_obj_class_create_obj(&lv_port_gif_class, parent);
+    lv_obj_class_init_obj(obj);
+    return obj;
+}
+
+lv_res_t lv_port_gif_set_src(lv_obj_t *obj, const char *path)
+{
+    lv_port_gif_t *gif = (lv_port_gif_t *)obj;
+    uint8_t hdr[13];
+
+    gif_close(gif);
+    if (s_lzw == NULL || gif->gpal == NULL || gif->lpal == NULL || gif->in_buf == NULL) {
+        return LV_RES_INV;
+    }
+    strlcpy(gif->name, lv_fs_get_last(path), sizeof(gif->name));
+    if (lv_fs_open(&gif->file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        ESP_LOGE(TAG, "open %s failed", path);
+        return LV_RES_INV;
+    }
+    gif->file_open = true;
+    gif->in_len = 0;
+    gif->pos = 0;
+    gif->loop_limit = 0;
+    gif->loop_forever = false;
+
+    if (!gif_read(gif, hdr, sizeof(hdr)) || (memcmp(hdr, "GIF87a", 6) != 0 && memcmp(hdr, "GIF89a", 6) != 0)) {
+        ESP_LOGE(TAG, "%s is not a GIF", path);
+        gif_close(gif);
+        return LV_RES_INV;
+    }
+    uint16_t w = le16(hdr + 6);
+    uint16_t h = le16(hdr + 8);
+    memset(gif->gpal, 0, 256 * sizeof(lv_color_t));
+    if ((hdr[10] & 0x80) && !gif_read_palette(gif, gif->gpal, 2u << (hdr[10] & 0x07))) {
+        gif_close(gif);
+        return LV_RES_INV;
+    }
+    gif->anim_start = gif->pos;
+
+    gif->canvas = calloc((uint32_t)w * h, GIF_PX_SIZE);
+    if (w == 0 || h == 0 || gif->canvas == NULL) {
+        ESP_LOGE(TAG, "%s: no mem for %ux%u canvas", path, w, h);
+        gif_close(gif);
+        return LV_RES_INV;
+    }
+    gif->dsc.header.always_zero = 0;
+    gif->dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    gif->dsc.header.w = w;
+    gif->dsc.header.h = h;
+    gif->dsc.data_size = (uint32_t)w * h * GIF_PX_SIZE;
+    gif->dsc.data = gif->canvas;
+    lv_img_set_src(obj, &gif->dsc);
+
+    lv_port_gif_restart(obj);
+    return gif->shown ? LV_RES_OK : LV_RES_INV;
+}
+
+void lv_port_gif_restart(lv_obj_t *obj)
+{
+    lv_port_gif_t *gif = (lv_port_gif_t *)obj;
+    if (gif->canvas == NULL) {
+        return;
+    }
+
+    memset(gif->canvas, 0, gif->dsc.data_size);
+    gif->shown = false;
+    gif->cur = 0;
+    gif->stats.loops = 0;
+    gif->loop_declared = 0;
+    gif->loop_decoded = 0;
+    gif->loop_hits = 0;
+    gif->loop_late = 0;
+    gif->loop_decode_us = 0;
+    gif->loop_decode_max = 0;
+    lv_obj_invalidate(obj);
+
+    if (!gif_show_next(gif)) {
+        ESP_LOGE(TAG, "%s: no frame could be decoded", gif->name);
+        return;
+    }
+    gif->next_due = lv_tick_get() + gif->frames[0].delay_ms;
+    lv_timer_set_period(gif->timer, gif->frames[0].delay_ms);
+    lv_timer_reset(gif->timer);
+    lv_timer_resume(gif->timer);
+}
+
+void lv_port_gif_get_stats(lv_obj_t *obj, lv_port_gif_stats_t *stats)
+{
+    *stats = ((lv_port_gif_t *)obj)->stats;
+}
+
+static void lv_port_gif_constructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+    lv_port_gif_t *gif = (lv_port_gif_t *)obj;
+
+    if (s_lzw_users++ == 0) {
+        s_lzw = malloc(sizeof(gif_lzw_t));
+        if (s_lzw) {
+            for (int i = 0; i < 256; i++) {
+                s_lzw->suffix[i] = i;
+            }
+        }
+    }
+    // 失败时 set_src 报错
+    gif->gpal = malloc(256 * sizeof(lv_color_t));
+    gif->lpal = malloc(256 * sizeof(lv_color_t));
+    gif->in_buf = malloc(GIF_IN_BUF_SIZE);
+    gif->timer = lv_timer_create(gif_timer_cb, GIF_DEFAULT_DELAY_MS, obj);
+    lv_timer_pause(gif->timer);
+}
+
+static void lv_port_gif_destructor(const lv_obj_class_t *class_p, lv_obj_t *obj)
+{
+    lv_port_gif_t *gif = (lv_port_gif_t *)obj;
+
+    gif_close(gif);
+    lv_timer_del(gif->timer);
+    gif->timer = NULL;
+    free(gif->gpal);
+    free(gif->lpal);
+    free(gif->in_buf);
+    gif->gpal = NULL;
+    gif->lpal = NULL;
+    gif->in_buf = NULL;
+    if (--s_lzw_users == 0) {
+        free(s_lzw);
+        s_lzw = NULL;
+    }
+}
@@ -0,0 +1,315 @@
+// lv_port_img_cache.c
+//
+// 主界面背景这样的大图每次失效都要重新从 TF 卡读取。这里在文件系统驱动前面加一层
+// 按字节预算的 LRU 缓存，常用资源读一次之后直接从内存提供。
+// 条目用双向链表按最近使用排序，链表头是最近使用的。资源数量很少 (几个到十几个)，
+// 查找直接遍历链表。
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "lv_port_img_cache.h"
+
+#if CONFIG_APP_IMG_CACHE
+
+static const char *TAG = "img_cache";
+
+#define IMG_CACHE_BUDGET        (CONFIG_APP_IMG_CACHE_BUDGET_KB * 1024)
+#define IMG_CACHE_MIN_FREE      (CONFIG_APP_IMG_CACHE_MIN_FREE_KB * 1024)
+
+struct img_cache_entry {
+    struct img_cache_entry *prev;
+    struct img_cache_entry *next;
+    char *key;
+    uint32_t stamp;
+    size_t size;
+    uint32_t refs;
+    bool committed;
+    bool stale;                 // 已从缓存中移除，最后一个引用释放时再释放内存
+    bool invalidated;           // 填充期间文件被修改，提交时直接丢弃
+    uint8_t *data;
+};
+
+static struct {
+    img_cache_entry_t *head;    // 最近使用
+    img_cache_entry_t *tail;    // 最久未使用
+    size_t used;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t rejects;
+    uint32_t oversize;          // 比整个预算还大、不能缓存的打开次数
+    char last_oversize[64];     // 最近一次提示过的过大文件
+} cache;
+
+static SemaphoreHandle_t cache_mux = NULL;
+
+void img_cache_init(void)
+{
+    if (cache_mux == NULL) {
+        cache_mux = xSemaphoreCreateMutex();
+        assert(cache_mux);
+    }
+}
+
+static void cache_lock(void)
+{
+    xSemaphoreTake(cache_mux, portMAX_DELAY);
+}
+
+static void cache_unlock(void)
+{
+    xSemaphoreGive(cache_mux);
+}
+
+static void entry_unlink(img_cache_entry_t *e)
+{
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        cache.head = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        cache.tail = e->prev;
+    }
+    e->prev = e->next = NULL;
+}
+
+static void entry_push_front(img_cache_entry_t *e)
+{
+    e->prev = NULL;
+    e->next = cache.head;
+    if (cache.head) {
+        cache.head->prev = e;
+    }
+    cache.head = e;
+    if (cache.tail == NULL) {
+        cache.tail = e;
+    }
+}
+
+static void entry_free(img_cache_entry_t *e)
+{
+    heap_caps_free(e->data);
+    free(e->key);
+    free(e);
+}
+
+/* 从缓存中移除条目，还有人在使用时推迟释放 */
+static void entry_drop(img_cache_entry_t *e)
+{
+    entry_unlink(e);
+    cache.used -= e->size;
+    if (e->refs == 0) {
+        entry_free(e);
+    } else {
+        e->stale = true;
+    }
+}
+
+/* 淘汰没有被引用的最久未使用条目，直到腾出 need 字节 */
+static bool cache_make_room(size_t need)
+{
+    img_cache_entry_t *e = cache.tail;
+    while (cache.used + need > IMG_CACHE_BUDGET && e) {
+        img_cache_entry_t *prev = e->prev;
+        if (e->refs == 0 && e->committed) {
+            ESP_LOGD(TAG, "evict %s (%u bytes)", e->key, (unsigned)e->size);
+            entry_drop(e);
+            cache.evictions++;
+        }
+        e = prev;
+    }
+    return cache.used + need <= IMG_CACHE_BUDGET;
+}
+
+img_cache_entry_t *img_cache_get(const char *key, uint32_t stamp)
+{
+    cache_lock();
+    for (img_cache_entry_t *e = cache.head; e; e = e->next) {
+        if (!e->committed || strcmp(e->key, key) != 0) {
+            continue;
+        }
+        if (e->stamp != stamp) {
+            // 文件已经被修改，旧数据作废
+            entry_drop(e);
+            break;
+        }
+        entry_unlink(e);
+        entry_push_front(e);
+        e->refs++;
+        cache.hits++;
+        cache_unlock();
+        return e;
+    }
+    cache.misses++;
+    cache_unlock();
+    return NULL;
+}
+
+img_cache_entry_t *img_cache_alloc(const char *key, uint32_t stamp, size_t size)
+{
+    if (size == 0) {
+        return NULL;
+    }
+    if (size > IMG_CACHE_BUDGET) {
+        // 每次打开都会走到这里，同一个文件只提示一次
+        cache_lock();
+        bool first = strcmp(cache.last_oversize, key) != 0;
+        if (first) {
+            strlcpy(cache.last_oversize, key, sizeof(cache.last_oversize));
+        }
+        cache.oversize++;
+        cache_unlock();
+        if (first) {
+            ESP_LOGI(TAG, "%s: %u bytes exceeds APP_IMG_CACHE_BUDGET_KB, streamed from the card", key, (unsigned)size);
+        }
+        return NULL;
+    }
+
+    cache_lock();
+    img_cache_entry_t *e = NULL;
+    if (!cache_make_room(size)) {
+        goto reject;
+    }
+    // 给系统的其他部分留出余量，缓存只使用空闲的内存
+    if (heap_caps_get_free_size(MALLOC_CAP_8BIT) < size + IMG_CACHE_MIN_FREE) {
+        goto reject;
+    }
+    e = calloc(1, sizeof(*e));
+    if (e == NULL) {
+        goto reject;
+    }
+    e->key = strdup(key);
+    e->data = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    if (e->key == NULL || e->data == NULL) {
+        entry_free(e);
+        goto reject;
+    }
+    e->stamp = stamp;
+    e->size = size;
+    e->refs = 1;
+    entry_push_front(e);
+    cache.used += size;
+    cache_unlock();
+    return e;
+
+reject:
+    cache.rejects++;
+    cache_unlock();
+    return NULL;
+}
+
+void img_cache_commit(img_cache_entry_t *entry)
+{
+    cache_lock();
+    // 同一个键只保留最新的条目
+    for (img_cache_entry_t *e = cache.head; e; e = e->next) {
+        if (e != entry && e->committed && strcmp(e->key, entry->key) == 0) {
+            entry_drop(e);
+            break;
+        }
+    }
+    entry->committed = true;
+    if (entry->invalidated) {
+        entry_drop(entry); // 填充的是修改之前的内容，调用者这次仍可使用，释放后即回收
+    }
+    cache_unlock();
+}
+
+void img_cache_abort(img_cache_entry_t *entry)
+{
+    cache_lock();
+    entry->refs--;
+    if (entry->stale) {
+        // 已经从链表中移除 (提交时被丢弃)，只差释放内存
+        if (entry->refs == 0) {
+            entry_free(entry);
+        }
+    } else {
+        entry_drop(entry);
+    }
+    cache_unlock();
+}
+
+void img_cache_release(img_cache_entry_t *entry)
+{
+    cache_lock();
+    if (--entry->refs == 0 && entry->stale) {
+        entry_free(entry);
+    }
+    cache_unlock();
+}
+
+uint8_t *img_cache_data(img_cache_entry_t *entry)
+{
+    return entry->data;
+}
+
+size_t img_cache_size(img_cache_entry_t *entry)
+{
+    return entry->size;
+}
+
+void img_cache_invalidate(const char *key)
+{
+    cache_lock();
+    img_cache_entry_t *next;
+    for (img_cache_entry_t *e = cache.head; e; e = next) {
+        next = e->next;
+        if (strcmp(e->key, key) != 0) {
+            continue;
+        }
+        if (e->committed) {
+            entry_drop(e);
+        } else {
+            // 还在填充，留给填充者的 commit / abort 处理，这里不能从链表中移除
+            e->invalidated = true;
+        }
+    }
+    cache_unlock();
+}
+
+void img_cache_dump_stats(void)
+{
+    cache_lock();
+    uint32_t count = 0;
+    for (img_cache_entry_t *e = cache.head; e; e = e->next) {
+        count++;
+    }
+    ESP_LOGI(TAG, "%" PRIu32 " entries, %u/%u bytes, hit %" PRIu32 " miss %" PRIu32 " evict %" PRIu32 " reject %" PRIu32
+             " oversize %" PRIu32, count, (unsigned)cache.used, (unsigned)IMG_CACHE_BUDGET,
+             cache.hits, cache.misses, cache.evictions, cache.rejects, cache.oversize);
+    cache_unlock();
+}
+
+#else /* CONFIG_APP_IMG_CACHE */
+
+void img_cache_init(void) {}
+
+img_cache_entry_t *img_cache_get(const char *key, uint32_t stamp)
+{
+    return NULL;
+}
+
+img_cache_entry_t *img_cache_alloc(const char *key, uint32_t stamp, size_t size)
+{
+    return NULL;
+}
+
+void img_cache_commit(img_cache_entry_t *entry) {}
+void img_cache_abort(img_cache_entry_t *entry) {}
+void img_cache_release(img_cache_entry_t *entry) {}
+uint8_t *img_cache_data(img_cache_entry_t *entry) { return NULL; }
+size_t img_cache_size(img_cache_entry_t *entry) { return 0; }
+void img_cache_invalidate(const char *key) {}
+void img_cache_dump_stats(void) {}
+
+#endif /* CONFIG_APP_IMG_CACHE */
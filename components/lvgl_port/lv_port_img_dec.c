@@ -0,0 +1,893 @@
+// lv_port_img_dec.c
+//
+// LVGL 8 自带的解码器在图片缓存为 0 时，每次绘制都要：
+//   打开文件读 4 字节头 (info) -> 关闭 -> 再打开 -> 每行一次 seek + read -> 关闭
+// 5 行的 strip 也要重复整套打开/关闭。这里换成：
+//   - 图片头按路径缓存，info 不访问 TF 卡；
+//   - 文件在两次绘制之间保持打开 (少量槽位，按最近使用替换)，只在文件被改写时重新打开；
+//   - 按行带读取：一次 seek + 一次 read 取回从请求行开始的若干整行，后续行直接从带缓冲复制；
+//   - 文件整个在图片缓存 (lv_port_img_cache) 中时，直接把像素地址交给 LVGL，不再逐行复制。
+//
+// 除了 LVGL 8 的 4 字节头格式，还支持 tools/LVGLImage.py 生成的文件 (LVGL 9 的 12 字节头，
+// magic 0x19)，包括 --compress RLE / LZ4：
+//   - 先尝试把整张图解压并转换成 LVGL 8 的像素格式放进图片缓存，之后的绘制直接使用；
+//   - 内存不够时 RLE 按行流式解压，每隔 IMG_DEC_RLE_CKPT_ROWS 行记录一次解压状态，
+//     局部重绘从最近的记录点继续，不必从文件开头解压；
+//   - LZ4 需要整张图作为回溯窗口，只能整图解压。
+//
+// 索引色图片 (LVGL 8 的 INDEXED_4BIT/8BIT，LVGLImage.py 的 I4/I8，不压缩) 按真彩色交给 LVGL：
+// 打开文件时把调色板转换成 lv_color_t 查找表，读取行时直接查表展开到 LVGL 的行缓冲，
+// 文件和行带只有 RGB565 的 1/2 或 1/4，LVGL 自带的解码器则是每个像素读一次调色板再转换颜色。
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "lvgl.h"
+#include "lv_port_fs.h"
+#include "lv_port_img_cache.h"
+#include "lv_port_img_dec.h"
+
+static const char *TAG = "img_dec";
+
+#define IMG_DEC_HEADER_SLOTS    (8)
+#define IMG_DEC_FILE_SLOTS      (2)
+#define IMG_DEC_BAND_BYTES      (CONFIG_APP_IMG_DEC_BAND_KB * 1024)
+#define IMG_DEC_IN_BUF_SIZE     (1024)
+#define IMG_DEC_RLE_CKPT_ROWS   (8)
+#define IMG_DEC_PAL_CHUNK       (16)    // 每次读取的调色板颜色数
+#define IMG_HEADER_WH_MAX       (0x7FF) // lv_img_header_t 中 w/h 位域的最大值
+
+/* tools/LVGLImage.py (LVGL 9) 的文件格式 */
+#define IMG_V9_MAGIC            (0x19)
+#define IMG_V9_HEADER_SIZE      (12)
+#define IMG_V9_FLAG_PREMUL      (0x01)
+#define IMG_V9_FLAG_COMPRESSED  (0x08)
+#define IMG_V9_COMPRESS_HDR     (12)
+#define IMG_V9_CF_I4            (0x09)
+#define IMG_V9_CF_I8            (0x0A)
+#define IMG_V9_CF_A8            (0x0E)
+#define IMG_V9_CF_RGB565        (0x12)
+#define IMG_V9_CF_ARGB8565      (0x13)
+
+typedef enum {
+    IMG_COMPRESS_NONE = 0,
+    IMG_COMPRESS_RLE = 1,
+    IMG_COMPRESS_LZ4 = 2,
+} img_compress_t;
+
+/* 文件中像素数据的布局 */
+typedef struct {
+    lv_img_header_t header;     // 交给 LVGL 的头 (LVGL 8 颜色格式)
+    uint8_t v9;                 // LVGLImage.py 生成的文件
+    uint8_t method;             // img_compress_t
+    uint8_t px_size;            // 每像素字节数，也是 RLE 的块大小
+    uint8_t swap16;             // 文件中是小端 RGB565，需要转换成 LV_COLOR_16_SWAP 的字节序
+    uint8_t idx_bits;           // 索引色每像素的位数 (4 / 8)，0 表示不是索引色
+    uint32_t stride;            // 文件中每行的字节数
+    uint32_t data_off;          // 像素数据 (或压缩数据) 在文件中的位置
+    uint32_t raw_len;           // 解压后的字节数
+    uint32_t comp_len;          // 压缩数据的字节数
+} img_fmt_t;
+
+/* 索引色的调色板查找表 */
+typedef struct {
+    lv_color_t color[256];
+    lv_opa_t opa[256];
+} img_lut_t;
+
+/* RLE 解压状态，可以保存下来在之后恢复 */
+typedef struct {
+    uint32_t in_pos;            // 下一个输入字节在文件中的位置
+    uint32_t out_pos;           // 已经输出的字节数
+    uint32_t run_bytes;         // 当前段剩余的输出字节数
+    uint8_t literal;
+    uint8_t blk_idx;            // 重复段中下一个输出字节在 value 中的位置
+    uint8_t value[4];
+} rle_state_t;
+
+#define RLE_CKPT_INVALID        (UINT32_MAX)
+
+typedef struct {
+    char path[LV_FS_MAX_PATH_LENGTH];
+    img_fmt_t fmt;
+    uint32_t last_use;
+} img_header_slot_t;
+
+typedef struct {
+    char path[LV_FS_MAX_PATH_LENGTH];
+    bool open;
+    bool busy;                  // 正在被一个解码描述符使用
+    uint32_t stamp;
+    uint32_t size;
+    uint32_t last_use;
+    lv_fs_file_t file;
+    img_fmt_t fmt;
+    img_lut_t *lut;             // 索引色的调色板查找表，第一次打开索引色图片时分配
+    const uint8_t *mem;         // LVGL 8 格式或索引色的文件在图片缓存中时指向文件内容
+    img_cache_entry_t *decoded; // 本次绘制使用的整图解压结果
+    /* 输入缓冲，压缩数据按字节流读取 */
+    uint8_t *in_buf;
+    uint32_t in_buf_pos;
+    uint32_t in_buf_len;
+    /* 行带缓冲 (未压缩) 或当前行 (RLE 流式解压) */
+    uint8_t *band;
+    uint32_t band_cap;
+    int32_t band_y;
+    int32_t band_rows;
+    /* RLE 流式解压 */
+    rle_state_t rle;
+    rle_state_t *ckpt;
+    uint32_t ckpt_count;
+} img_file_slot_t;
+
+static img_header_slot_t header_slots[IMG_DEC_HEADER_SLOTS];
+static img_file_slot_t file_slots[IMG_DEC_FILE_SLOTS];
+static uint32_t use_counter;
+
+static bool img_dec_is_bin_file(const void *src)
+{
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_FILE) {
+        return false;
+    }
+    const char *ext = lv_fs_get_ext(src);
+    return strcmp(ext, "bin") == 0 || strcmp(ext, "BIN") == 0;
+}
+
+/* LVGL 8 格式只处理按行存放的真彩色和 4/8 位索引色，其他格式交给 LVGL 自带的解码器 */
+static bool img_dec_cf_supported(lv_img_cf_t cf)
+{
+    return cf == LV_IMG_CF_TRUE_COLOR || cf == LV_IMG_CF_TRUE_COLOR_ALPHA ||
+           cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED ||
+           cf == LV_IMG_CF_INDEXED_4BIT || cf == LV_IMG_CF_INDEXED_8BIT;
+}
+
+static uint32_t le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * 索引色：调色板 (每个颜色 B,G,R,A 4 字节) 从 pal_off 开始，紧接着是按行存放的索引。
+ * 调色板全部不透明时按 TRUE_COLOR 输出，否则按 TRUE_COLOR_ALPHA。
+ * lut 不为 NULL 时同时生成查找表。
+ */
+static lv_res_t img_fmt_indexed(lv_fs_file_t *f, img_fmt_t *fmt, uint8_t bits, uint32_t pal_off, img_lut_t *lut)
+{
+    const uint32_t n_colors = 1u << bits;
+    uint8_t buf[IMG_DEC_PAL_CHUNK * 4];
+    bool opaque = true;
+
+    if (lv_fs_seek(f, pal_off, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        return LV_RES_INV;
+    }
+    for (uint32_t i = 0; i < n_colors; i += IMG_DEC_PAL_CHUNK) {
+        uint32_t br = 0;
+        if (lv_fs_read(f, buf, sizeof(buf), &br) != LV_FS_RES_OK || br != sizeof(buf)) {
+            return LV_RES_INV;
+        }
+        for (uint32_t j = 0; j < IMG_DEC_PAL_CHUNK; j++) {
+            const uint8_t *c = buf + j * 4;
+            opaque = opaque && c[3] == LV_OPA_COVER;
+            if (lut) {
+                lut->color[i + j] = lv_color_make(c[2], c[1], c[0]);
+                lut->opa[i + j] = c[3];
+            }
+        }
+    }
+
+    fmt->idx_bits = bits;
+    fmt->header.cf = opaque ? LV_IMG_CF_TRUE_COLOR : LV_IMG_CF_TRUE_COLOR_ALPHA;
+    fmt->px_size = opaque ? sizeof(lv_color_t) : LV_IMG_PX_SIZE_ALPHA_BYTE;
+    fmt->data_off = pal_off + n_colors * 4;
+    fmt->raw_len = fmt->stride * fmt->header.h;
+    return LV_RES_OK;
+}
+
+/* 从文件开头解析图片头，lut 不为 NULL 时生成索引色的查找表，文件位置之后不确定 */
+static lv_res_t img_fmt_parse(lv_fs_file_t *f, img_fmt_t *fmt, img_lut_t *lut)
+{
+    uint8_t buf[IMG_V9_HEADER_SIZE + IMG_V9_COMPRESS_HDR];
+    uint32_t br = 0;
+
+    memset(fmt, 0, sizeof(*fmt));
+    if (lv_fs_seek(f, 0, LV_FS_SEEK_SET) != LV_FS_RES_OK ||
+            lv_fs_read(f, buf, sizeof(lv_img_header_t), &br) != LV_FS_RES_OK || br != sizeof(lv_img_header_t)) {
+        return LV_RES_INV;
+    }
+
+    if (buf[0] != IMG_V9_MAGIC) {
+        // LVGL 8 格式：4 字节位域头，紧接着是按行存放的像素
+        memcpy(&fmt->header, buf, sizeof(lv_img_header_t));
+        if (!img_dec_cf_supported(fmt->header.cf)) {
+            return LV_RES_INV;
+        }
+        if (fmt->header.cf == LV_IMG_CF_INDEXED_4BIT || fmt->header.cf == LV_IMG_CF_INDEXED_8BIT) {
+            uint8_t bits = lv_img_cf_get_px_size(fmt->header.cf);
+            fmt->stride = (fmt->header.w * bits + 7) / 8;
+            return img_fmt_indexed(f, fmt, bits, sizeof(lv_img_header_t), lut);
+        }
+        fmt->px_size = lv_img_cf_get_px_size(fmt->header.cf) / 8;
+        fmt->stride = fmt->header.w * fmt->px_size;
+        fmt->data_off = sizeof(lv_img_header_t);
+        fmt->raw_len = fmt->stride * fmt->header.h;
+        return LV_RES_OK;
+    }
+
+    if (lv_fs_read(f, buf + br, IMG_V9_HEADER_SIZE - br, &br) != LV_FS_RES_OK ||
+            br != IMG_V9_HEADER_SIZE - sizeof(lv_img_header_t)) {
+        return LV_RES_INV;
+    }
+    uint8_t cf9 = buf[1]; // 整个字节比较，不能掩码，否则更高编号的格式会被当成这里支持的格式
+    uint32_t flags = le16(buf + 2);
+
+    // lv_img_header_t 的 w/h 只有 11 位，放不下时拒绝，不能截断成错误的尺寸
+    uint32_t w = le16(buf + 4);
+    uint32_t h = le16(buf + 6);
+    if (w > IMG_HEADER_WH_MAX || h > IMG_HEADER_WH_MAX) {
+        ESP_LOGW(TAG, "%" PRIu32 "x%" PRIu32 " image exceeds the LVGL 8 limit of %d", w, h, IMG_HEADER_WH_MAX);
+        return LV_RES_INV;
+    }
+    fmt->v9 = 1;
+    fmt->header.w = w;
+    fmt->header.h = h;
+    fmt->stride = le16(buf + 8);
+    if (cf9 == IMG_V9_CF_I4 || cf9 == IMG_V9_CF_I8) {
+        uint8_t bits = (cf9 == IMG_V9_CF_I4) ? 4 : 8;
+        if (flags & IMG_V9_FLAG_COMPRESSED) {
+            // 调色板在压缩数据里，而且索引色本身已经比 RGB565 小很多
+            ESP_LOGW(TAG, "compressed indexed images are not supported, convert without --compress");
+            return LV_RES_INV;
+        }
+        if (fmt->stride < (fmt->header.w * bits + 7) / 8) {
+            return LV_RES_INV;
+        }
+        if (flags & IMG_V9_FLAG_PREMUL) {
+            ESP_LOGW(TAG, "premultiplied alpha is drawn as straight alpha");
+        }
+        return img_fmt_indexed(f, fmt, bits, IMG_V9_HEADER_SIZE, lut);
+    }
+    switch (cf9) {
+    case IMG_V9_CF_RGB565:
+        fmt->header.cf = LV_IMG_CF_TRUE_COLOR;
+        fmt->px_size = 2;
+        fmt->swap16 = LV_COLOR_16_SWAP;
+        break;
+    case IMG_V9_CF_ARGB8565:
+        fmt->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+        fmt->px_size = 3;
+        fmt->swap16 = LV_COLOR_16_SWAP;
+        break;
+    case IMG_V9_CF_A8:
+        fmt->header.cf = LV_IMG_CF_ALPHA_8BIT;
+        fmt->px_size = 1;
+        break;
+    default:
+        ESP_LOGW(TAG, "unsupported LVGL 9 color format 0x%02x", cf9);
+        return LV_RES_INV;
+    }
+    if (flags & IMG_V9_FLAG_PREMUL) {
+        ESP_LOGW(TAG, "premultiplied alpha is drawn as straight alpha");
+    }
+    if (fmt->stride < fmt->header.w * fmt->px_size) {
+        return LV_RES_INV;
+    }
+
+    fmt->data_off = IMG_V9_HEADER_SIZE;
+    fmt->raw_len = fmt->stride * fmt->header.h;
+    if (flags & IMG_V9_FLAG_COMPRESSED) {
+        uint8_t *c = buf + IMG_V9_HEADER_SIZE;
+        if (lv_fs_read(f, c, IMG_V9_COMPRESS_HDR, &br) != LV_FS_RES_OK || br != IMG_V9_COMPRESS_HDR) {
+            return LV_RES_INV;
+        }
+        fmt->method = le32(c);
+        fmt->comp_len = le32(c + 4);
+        // RLE 按像素压缩，最后一个像素不完整时会补齐
+        if (le32(c + 8) < fmt->raw_len || fmt->method > IMG_COMPRESS_LZ4) {
+            return LV_RES_INV;
+        }
+        fmt->data_off += IMG_V9_COMPRESS_HDR;
+    }
+    return LV_RES_OK;
+}
+
+/* 文件中的像素转换成 LVGL 8 的内存格式，可以原地转换 */
+static void img_px_convert(const img_fmt_t *fmt, uint8_t *dst, const uint8_t *src, uint32_t n_px)
+{
+    if (!fmt->swap16) {
+        if (dst != src) {
+            memmove(dst, src, n_px * fmt->px_size);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < n_px; i++) {
+        uint8_t lo = src[0];
+        dst[0] = src[1];
+        dst[1] = lo;
+        if (fmt->px_size == 3) {
+            dst[2] = src[2];
+        }
+        src += fmt->px_size;
+        dst += fmt->px_size;
+    }
+}
+
+/* 索引色的一行从第 x 个像素开始查表展开 len 个像素，4 位索引高半字节在前 */
+static void img_idx_expand(const img_fmt_t *fmt, const img_lut_t *lut, uint8_t *dst,
+                           const uint8_t *row, uint32_t x, uint32_t len)
+{
+    if (fmt->header.cf == LV_IMG_CF_TRUE_COLOR) {
+        lv_color_t *out = (lv_color_t *)dst;
+        if (fmt->idx_bits == 8) {
+            row += x;
+            for (uint32_t i = 0; i < len; i++) {
+                out[i] = lut->color[row[i]];
+            }
+            return;
+        }
+        row += x / 2;
+        uint32_t i = 0;
+        if ((x & 1) && len > 0) {
+            out[i++] = lut->color[*row++ & 0x0f];
+        }
+        for (; i + 1 < len; i += 2) {
+            uint8_t b = *row++;
+            out[i] = lut->color[b >> 4];
+            out[i + 1] = lut->color[b & 0x0f];
+        }
+        if (i < len) {
+            out[i] = lut->color[*row >> 4];
+        }
+        return;
+    }
+
+    // 带透明度：每个像素是 lv_color_t 加 1 字节 alpha
+    for (uint32_t i = 0; i < len; i++, x++) {
+        uint8_t idx = (fmt->idx_bits == 8) ? row[x] : (row[x / 2] >> ((x & 1) ? 0 : 4)) & 0x0f;
+        memcpy(dst, &lut->color[idx], sizeof(lv_color_t));
+        dst[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = lut->opa[idx];
+        dst += LV_IMG_PX_SIZE_ALPHA_BYTE;
+    }
+}
+
+static img_header_slot_t *header_lookup(const char *path)
+{
+    for (int i = 0; i < IMG_DEC_HEADER_SLOTS; i++) {
+        if (header_slots[i].path[0] && strcmp(header_slots[i].path, path) == 0) {
+            header_slots[i].last_use = ++use_counter;
+            return &header_slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void header_store(const char *path, const img_fmt_t *fmt)
+{
+    img_header_slot_t *slot = header_lookup(path);
+    if (slot == NULL) {
+        slot = &header_slots[0];
+        for (int i = 1; i < IMG_DEC_HEADER_SLOTS; i++) {
+            if (header_slots[i].last_use < slot->last_use) {
+                slot = &header_slots[i];
+            }
+        }
+        strlcpy(slot->path, path, sizeof(slot->path));
+    }
+    slot->fmt = *fmt;
+    slot->last_use = ++use_counter;
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 输入流和解压
+ * ---------------------------------------------------------------------------
+ */
+
+/* 从文件位置 *pos 读取 n 字节，dst 为 NULL 时只跳过 */
+static bool in_read(img_file_slot_t *slot, uint32_t *pos, uint8_t *dst, uint32_t n)
+{
+    if (dst == NULL) {
+        *pos += n;
+        return true;
+    }
+    while (n > 0) {
+        if (*pos < slot->in_buf_pos || *pos >= slot->in_buf_pos + slot->in_buf_len) {
+            uint32_t br = 0;
+            slot->in_buf_len = 0;
+            if (lv_fs_seek(&slot->file, *pos, LV_FS_SEEK_SET) != LV_FS_RES_OK ||
+                    lv_fs_read(&slot->file, slot->in_buf, IMG_DEC_IN_BUF_SIZE, &br) != LV_FS_RES_OK || br == 0) {
+                return false;
+            }
+            slot->in_buf_pos = *pos;
+            slot->in_buf_len = br;
+        }
+        uint32_t off = *pos - slot->in_buf_pos;
+        uint32_t m = LV_MIN(n, slot->in_buf_len - off);
+        memcpy(dst, slot->in_buf + off, m);
+        dst += m;
+        *pos += m;
+        n -= m;
+    }
+    return true;
+}
+
+static void rle_reset(img_file_slot_t *slot)
+{
+    memset(&slot->rle, 0, sizeof(slot->rle));
+    slot->rle.in_pos = slot->fmt.data_off;
+}
+
+/* 输出 n 字节解压数据到 dst，dst 为 NULL 时丢弃 (字面量段直接跳过，不读文件) */
+static bool rle_read(img_file_slot_t *slot, rle_state_t *st, uint8_t *dst, uint32_t n)
+{
+    const uint8_t blk = slot->fmt.px_size;
+
+    while (n > 0) {
+        if (st->run_bytes == 0) {
+            uint8_t ctrl;
+            if (!in_read(slot, &st->in_pos, &ctrl, 1) || (ctrl & 0x7f) == 0) {
+                return false;
+            }
+            st->literal = (ctrl & 0x80) != 0;
+            st->run_bytes = (ctrl & 0x7f) * blk;
+            if (!st->literal) {
+                if (!in_read(slot, &st->in_pos, st->value, blk)) {
+                    return false;
+                }
+                st->blk_idx = 0;
+            }
+        }
+
+        uint32_t m = LV_MIN(n, st->run_bytes);
+        if (st->literal) {
+            if (!in_read(slot, &st->in_pos, dst, m)) {
+                return false;
+            }
+        } else if (dst) {
+            for (uint32_t i = 0; i < m; i++) {
+                dst[i] = st->value[st->blk_idx];
+                st->blk_idx = (st->blk_idx + 1 == blk) ? 0 : st->blk_idx + 1;
+            }
+        } else {
+            st->blk_idx = (st->blk_idx + m) % blk;
+        }
+        if (dst) {
+            dst += m;
+        }
+        st->run_bytes -= m;
+        st->out_pos += m;
+        n -= m;
+    }
+    return true;
+}
+
+/* 让 RLE 流停在第 y 行的开头，尽量从记录点恢复 */
+static bool rle_seek_row(img_file_slot_t *slot, int32_t y)
+{
+    const uint32_t stride = slot->fmt.stride;
+    const uint32_t target = y * stride;
+    rle_state_t *st = &slot->rle;
+
+    if (st->out_pos != target) {
+        int32_t c = LV_MIN(y / IMG_DEC_RLE_CKPT_ROWS, (int32_t)slot->ckpt_count - 1);
+        while (c >= 0 && slot->ckpt[c].out_pos == RLE_CKPT_INVALID) {
+            c--;
+        }
+        if (c >= 0 && (st->out_pos > target || slot->ckpt[c].out_pos > st->out_pos)) {
+            *st = slot->ckpt[c];
+        } else if (st->out_pos > target) {
+            rle_reset(slot);
+        }
+    }
+
+    while (true) {
+        uint32_t row = st->out_pos / stride;
+        if (row % IMG_DEC_RLE_CKPT_ROWS == 0 && slot->ckpt[row / IMG_DEC_RLE_CKPT_ROWS].out_pos == RLE_CKPT_INVALID) {
+            slot->ckpt[row / IMG_DEC_RLE_CKPT_ROWS] = *st;
+        }
+        if (st->out_pos >= target) {
+            return true;
+        }
+        if (!rle_read(slot, st, NULL, stride)) {
+            return false;
+        }
+    }
+}
+
+/* LZ4 block 格式 (lz4.block.compress, store_size=False)，整块解压到 out */
+static bool lz4_unpack(img_file_slot_t *slot, uint8_t *out, uint32_t out_len)
+{
+    uint32_t pos = slot->fmt.data_off;
+    const uint32_t end = pos + slot->fmt.comp_len;
+    uint32_t o = 0;
+
+    while (pos < end) {
+        uint8_t token;
+        if (!in_read(slot, &pos, &token, 1)) {
+            return false;
+        }
+        uint32_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (!in_read(slot, &pos, &b, 1)) {
+                    return false;
+                }
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > out_len - o || !in_read(slot, &pos, out + o, lit)) {
+            return false;
+        }
+        o += lit;
+        if (pos >= end) {
+            break; // 最后一个序列只有字面量
+        }
+
+        uint8_t off_le[2];
+        if (!in_read(slot, &pos, off_le, 2)) {
+            return false;
+        }
+        uint32_t offset = le16(off_le);
+        uint32_t len = token & 0x0f;
+        if (len == 15) {
+            uint8_t b;
+            do {
+                if (!in_read(slot, &pos, &b, 1)) {
+                    return false;
+                }
+                len += b;
+            } while (b == 255);
+        }
+        len += 4;
+        if (offset == 0 || offset > o || len > out_len - o) {
+            return false;
+        }
+        // 匹配可能和输出重叠，逐字节复制
+        const uint8_t *src = out + o - offset;
+        for (uint32_t i = 0; i < len; i++) {
+            out[o + i] = src[i];
+        }
+        o += len;
+    }
+    return o >= slot->fmt.raw_len;
+}
+
+static bool band_reserve(img_file_slot_t *slot, uint32_t bytes)
+{
+    if (slot->band && slot->band_cap >= bytes) {
+        return true;
+    }
+    uint32_t cap = LV_MAX(bytes, IMG_DEC_BAND_BYTES);
+    uint8_t *band = realloc(slot->band, cap); // 放在系统堆上，LVGL 自己的内存池很小
+    if (band == NULL) {
+        return false;
+    }
+    slot->band = band;
+    slot->band_cap = cap;
+    slot->band_rows = 0;
+    return true;
+}
+
+/* 把整张图解压/转换成 LVGL 8 的紧凑格式，放进图片缓存 */
+static img_cache_entry_t *img_unpack_to_cache(img_file_slot_t *slot)
+{
+    const img_fmt_t *fmt = &slot->fmt;
+    const uint32_t row_bytes = fmt->header.w * fmt->px_size;
+    char key[LV_FS_MAX_PATH_LENGTH + 4];
+    snprintf(key, sizeof(key), "%s#px", slot->path);
+
+    img_cache_entry_t *e = img_cache_get(key, slot->stamp);
+    if (e) {
+        return e;
+    }
+    // LZ4 需要按原始布局 (带行填充) 解压，之后再原地压紧
+    uint32_t size = (fmt->method == IMG_COMPRESS_LZ4) ? fmt->raw_len : row_bytes * fmt->header.h;
+    e = img_cache_alloc(key, slot->stamp, size);
+    if (e == NULL) {
+        return NULL;
+    }
+    uint8_t *out = img_cache_data(e);
+    bool ok = true;
+
+    if (fmt->method == IMG_COMPRESS_LZ4) {
+        ok = lz4_unpack(slot, out, size);
+        for (int32_t y = 0; ok && y < fmt->header.h; y++) {
+            img_px_convert(fmt, out + y * row_bytes, out + y * fmt->stride, fmt->header.w);
+        }
+    } else if (fmt->method == IMG_COMPRESS_RLE) {
+        ok = band_reserve(slot, fmt->stride);
+        rle_reset(slot);
+        for (int32_t y = 0; ok && y < fmt->header.h; y++) {
+            ok = rle_read(slot, &slot->rle, slot->band, fmt->stride);
+            img_px_convert(fmt, out + y * row_bytes, slot->band, fmt->header.w);
+        }
+        slot->band_rows = 0;
+        rle_reset(slot);
+    } else {
+        for (int32_t y = 0; ok && y < fmt->header.h; y++) {
+            uint32_t pos = fmt->data_off + y * fmt->stride;
+            ok = in_read(slot, &pos, out + y * row_bytes, row_bytes);
+            img_px_convert(fmt, out + y * row_bytes, out + y * row_bytes, fmt->header.w);
+        }
+    }
+
+    if (!ok) {
+        ESP_LOGW(TAG, "%s: corrupt image data", slot->path);
+        img_cache_abort(e);
+        return NULL;
+    }
+    img_cache_commit(e);
+    return e;
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * 文件槽位
+ * ---------------------------------------------------------------------------
+ */
+
+static void file_slot_close(img_file_slot_t *slot)
+{
+    if (slot->open) {
+        lv_fs_close(&slot->file);
+    }
+    slot->open = false;
+    slot->mem = NULL;
+    slot->band_rows = 0;
+    slot->in_buf_len = 0;
+    slot->path[0] = '\0';
+    free(slot->ckpt);
+    slot->ckpt = NULL;
+    slot->ckpt_count = 0;
+}
+
+static lv_res_t file_slot_open(img_file_slot_t *slot, const char *path, uint32_t stamp, uint32_t size)
+{
+    file_slot_close(slot);
+    if (slot->in_buf == NULL) {
+        slot->in_buf = malloc(IMG_DEC_IN_BUF_SIZE);
+        if (slot->in_buf == NULL) {
+            return LV_RES_INV;
+        }
+    }
+    if (lv_fs_open(&slot->file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        return LV_RES_INV;
+    }
+    slot->open = true;
+
+    if (img_fmt_parse(&slot->file, &slot->fmt, slot->lut) != LV_RES_OK) {
+        file_slot_close(slot);
+        return LV_RES_INV;
+    }
+    if (slot->fmt.idx_bits && slot->lut == NULL) {
+        // 第一次遇到索引色图片，分配查找表后再读一次调色板
+        slot->lut = malloc(sizeof(img_lut_t));
+        if (slot->lut == NULL || img_fmt_parse(&slot->file, &slot->fmt, slot->lut) != LV_RES_OK) {
+            file_slot_close(slot);
+            return LV_RES_INV;
+        }
+    }
+    strlcpy(slot->path, path, sizeof(slot->path));
+    slot->stamp = stamp;
+    slot->size = size;
+
+    if (slot->fmt.method == IMG_COMPRESS_RLE) {
+        slot->ckpt_count = (slot->fmt.header.h + IMG_DEC_RLE_CKPT_ROWS - 1) / IMG_DEC_RLE_CKPT_ROWS + 1;
+        slot->ckpt = malloc(slot->ckpt_count * sizeof(rle_state_t));
+        if (slot->ckpt == NULL) {
+            file_slot_close(slot);
+            return LV_RES_INV;
+        }
+        for (uint32_t i = 0; i < slot->ckpt_count; i++) {
+            slot->ckpt[i].out_pos = RLE_CKPT_INVALID;
+        }
+        rle_reset(slot);
+    }
+
+    if (slot->fmt.v9 && slot->fmt.method != IMG_COMPRESS_NONE) {
+        // 压缩数据只在解压时顺序读一遍，不占用缓存预算，留给解压后的像素
+        lv_port_fs_uncache(&slot->file, path);
+    }
+
+    uint32_t mem_size = 0;
+    bool as_is = !slot->fmt.v9 || slot->fmt.idx_bits; // 文件中的数据不需要转换或解压
+    slot->mem = as_is ? lv_port_fs_mem(&slot->file, &mem_size) : NULL;
+    if (slot->mem && mem_size < slot->fmt.data_off + slot->fmt.raw_len) {
+        slot->mem = NULL; // 文件被截断，按普通文件处理并在读取时报错
+    }
+    header_store(path, &slot->fmt);
+    return LV_RES_OK;
+}
+
+/* 找到已经打开这个文件的槽位，或者替换最久没用的空闲槽位 */
+static img_file_slot_t *file_slot_get(const char *path)
+{
+    uint32_t stamp = 0;
+    uint32_t size = 0;
+    if (!lv_port_fs_file_info(path, &stamp, &size)) {
+        return NULL;
+    }
+
+    img_file_slot_t *victim = NULL;
+    for (int i = 0; i < IMG_DEC_FILE_SLOTS; i++) {
+        img_file_slot_t *slot = &file_slots[i];
+        if (slot->busy) {
+            continue;
+        }
+        if (slot->open && strcmp(slot->path, path) == 0) {
+            if (slot->stamp == stamp && slot->size == size) {
+                slot->last_use = ++use_counter;
+                return slot;
+            }
+            victim = slot; // 文件被改写过，重新打开
+            break;
+        }
+        if (victim == NULL || !slot->open || (victim->open && slot->last_use < victim->last_use)) {
+            victim = slot;
+        }
+    }
+    if (victim == NULL || file_slot_open(victim, path, stamp, size) != LV_RES_OK) {
+        return NULL;
+    }
+    victim->last_use = ++use_counter;
+    return victim;
+}
+
+/*
+ * ---------------------------------------------------------------------------
+ * LVGL 解码器回调
+ * ---------------------------------------------------------------------------
+ */
+
+static lv_res_t img_dec_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    if (!img_dec_is_bin_file(src)) {
+        return LV_RES_INV;
+    }
+
+    img_header_slot_t *cached = header_lookup(src);
+    if (cached) {
+        *header = cached->fmt.header;
+        return LV_RES_OK;
+    }
+
+    lv_fs_file_t f;
+    img_fmt_t fmt;
+    if (lv_fs_open(&f, src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        return LV_RES_INV;
+    }
+    lv_res_t res = img_fmt_parse(&f, &fmt, NULL);
+    lv_fs_close(&f);
+    if (res != LV_RES_OK) {
+        return LV_RES_INV;
+    }
+    header_store(src, &fmt);
+    *header = fmt.header;
+    return LV_RES_OK;
+}
+
+static lv_res_t img_dec_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    if (!img_dec_is_bin_file(dsc->src)) {
+        return LV_RES_INV;
+    }
+
+    img_file_slot_t *slot = file_slot_get(dsc->src);
+    if (slot == NULL) {
+        return LV_RES_INV;
+    }
+    if (memcmp(&slot->fmt.header, &dsc->header, sizeof(lv_img_header_t)) != 0) {
+        // 文件在 info 之后被替换成了另一张图，这次放弃，下一次绘制使用新的头
+        ESP_LOGW(TAG, "%s changed while drawing", (const char *)dsc->src);
+        return LV_RES_INV;
+    }
+
+    // 索引色总是由 read_line 查表展开，不交出 img_data
+    dsc->img_data = NULL;
+    if (slot->mem && !slot->fmt.idx_bits) {
+        dsc->img_data = slot->mem + slot->fmt.data_off;
+    } else if (slot->fmt.v9 && !slot->fmt.idx_bits) {
+        slot->decoded = img_unpack_to_cache(slot);
+        if (slot->decoded) {
+            dsc->img_data = img_cache_data(slot->decoded);
+        } else if (slot->fmt.method == IMG_COMPRESS_LZ4) {
+            ESP_LOGW(TAG, "%s: not enough memory to unpack LZ4 image", slot->path);
+            return LV_RES_INV;
+        }
+    }
+
+    slot->busy = true;
+    dsc->user_data = slot;
+    return LV_RES_OK;
+}
+
+/* 文件中第 y 行的数据 (未转换)，不在行带中时读取从 y 开始的新行带 */
+static const uint8_t *img_row_get(img_file_slot_t *slot, int32_t y)
+{
+    const img_fmt_t *fmt = &slot->fmt;
+    const uint32_t stride = fmt->stride;
+
+    if (slot->mem) {
+        return slot->mem + fmt->data_off + (uint32_t)y * stride;
+    }
+    if (y < slot->band_y || y >= slot->band_y + slot->band_rows) {
+        if (!band_reserve(slot, stride)) {
+            return NULL;
+        }
+        slot->band_rows = 0;
+
+        if (fmt->method == IMG_COMPRESS_RLE) {
+            // 流式解压一行
+            if (!rle_seek_row(slot, y) || !rle_read(slot, &slot->rle, slot->band, stride)) {
+                rle_reset(slot);
+                return NULL;
+            }
+            slot->band_y = y;
+            slot->band_rows = 1;
+        } else {
+            // 从请求的行开始读若干整行，整行在文件中是连续的，只需要一次 seek + read
+            int32_t rows = LV_MIN((int32_t)(slot->band_cap / stride), fmt->header.h - y);
+            uint32_t br = 0;
+            if (lv_fs_seek(&slot->file, fmt->data_off + (uint32_t)y * stride, LV_FS_SEEK_SET) != LV_FS_RES_OK ||
+                    lv_fs_read(&slot->file, slot->band, rows * stride, &br) != LV_FS_RES_OK) {
+                return NULL;
+            }
+            slot->band_y = y;
+            slot->band_rows = br / stride;
+            if (slot->band_rows == 0) {
+                return NULL;
+            }
+        }
+    }
+    return slot->band + (y - slot->band_y) * stride;
+}
+
+static lv_res_t img_dec_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t *buf)
+{
+    img_file_slot_t *slot = dsc->user_data;
+    const img_fmt_t *fmt = &slot->fmt;
+
+    const uint8_t *row = img_row_get(slot, y);
+    if (row == NULL) {
+        return LV_RES_INV;
+    }
+    if (fmt->idx_bits) {
+        img_idx_expand(fmt, slot->lut, buf, row, x, len);
+    } else {
+        img_px_convert(fmt, buf, row + x * fmt->px_size, len);
+    }
+    return LV_RES_OK;
+}
+
+static void img_dec_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    img_file_slot_t *slot = dsc->user_data;
+    if (slot) {
+        if (slot->decoded) {
+            // 解压结果留在图片缓存中，由 LRU 决定是否保留
+            img_cache_release(slot->decoded);
+            slot->decoded = NULL;
+        }
+        // 文件和行带保持打开，留给下一次绘制
+        slot->busy = false;
+    }
+    dsc->user_data = NULL;
+}
+
+void lv_port_img_dec_init(void)
+{
+    lv_img_decoder_t *dec = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(dec, img_dec_info);
+    lv_img_decoder_set_open_cb(dec, img_dec_open);
+    lv_img_decoder_set_read_line_cb(dec, img_dec_read_line);
+    lv_img_decoder_set_close_cb(dec, img_dec_close);
+}
@@ -2,8 +2,8 @@
 #include "esp_err.h"
 #include "esp_check.h"
 #include "esp_adc/adc_oneshot.h"
-#include "esp_lvgl_port.h"
 #include "lv_port_disp.h"
+#include "lv_port_tick.h"
 #include "lvgl.h"
 
 static const char *TAG = "LVGL_ADC_BTN";
@@ -26,7 +26,7 @@ typedef struct {
 
 static void lvgl_adc_btn_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *data);
 
-static lv_indev_t *lvgl_port_add_adc_buttons(lv_display_t *disp);
+static lv_indev_t *lvgl_port_add_adc_buttons(lv_disp_t *disp);
 
 esp_err_t lvgl_indev_init()
 {
@@ -48,7 +48,7 @@ esp_err_t lvgl_indev_init()
 }
 
 
-lv_indev_t *lvgl_port_add_adc_buttons(lv_display_t *disp)
+lv_indev_t *lvgl_port_add_adc_buttons(lv_disp_t *disp)
 {
     ESP_LOGI(TAG, "lvgl_port_add_adc_buttons");
 
@@ -114,4 +114,11 @@ static void lvgl_adc_btn_read_cb(lv_indev_drv_t *indev_drv, lv_indev_data_t *dat
     } else {
         data->key = ctx->last_key;
     }
+
+    // 按下或松开时让 LVGL 任务处理完这次输入后马上再运行一轮，按键引起的重绘不等到下一次超时
+    bool pressed = (data->state == LV_INDEV_STATE_PRESSED);
+    if (pressed != ctx->btn_pressed) {
+        ctx->btn_pressed = pressed;
+        lv_port_wake();
+    }
 }
@@ -0,0 +1,212 @@
+// lv_port_pack.c
+//
+// TF 卡上的资源包，格式和 assets 分区相同 (tools/mkassets.py)，
+// 文件头带 FILES 标志，每一项是原样保存的整个文件，数据按扇区对齐：
+//   文件头 | 索引 (按名字哈希排序) | 名字表 | 文件数据
+// 每次 lv_img_set_src("A:/...") 原本要转换路径、f_open 遍历 FAT 目录并分配 FIL；
+// 文件在包中时改为 RAM 中二分查找，再在一直打开的包文件中定位读取。
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "safe_fatfs.h"
+#include "lv_port_pack.h"
+
+static const char *TAG = "pack";
+
+#define PACK_MAGIC              (0x5041564C)    // "LVAP"
+#define PACK_VERSION            (1)
+#define PACK_FLAG_FILES         (0x0002)
+#define PACK_HEADER_SIZE        (32)
+#define PACK_ENTRY_SIZE         (24)
+#define PACK_NAMES_MAX          (64 * 1024)
+
+static FIL s_fil;
+static bool s_open;
+static uint32_t s_pos;                  // 包文件的当前位置，相同时不再 f_lseek
+static uint32_t s_stamp;
+static uint32_t s_count;
+static lv_port_pack_entry_t *s_index;
+static char *s_names;
+#if CONFIG_FATFS_USE_FASTSEEK
+static DWORD s_clmt[CONFIG_APP_FS_FASTSEEK_CLMT_LEN];   // 包文件一直打开，簇链映射表单独保留一张
+#endif
+
+static uint32_t le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t pack_hash(const char *name)
+{
+    uint32_t h = 0x811C9DC5;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+static bool pack_read_at(uint32_t pos, void *buf, UINT btr, UINT *br)
+{
+    *br = 0;
+    if (pos != s_pos && safe_f_lseek(&s_fil, pos) != FR_OK) {
+        s_pos = UINT32_MAX;
+        return false;
+    }
+    FRESULT res = safe_f_read(&s_fil, buf, btr, br);
+    s_pos = (res == FR_OK) ? pos + *br : UINT32_MAX;
+    return res == FR_OK;
+}
+
+static void pack_close(void)
+{
+    if (s_open) {
+        safe_f_close(&s_fil);
+        s_open = false;
+    }
+#if CONFIG_FATFS_USE_FASTSEEK
+    s_fil.cltbl = NULL;
+#endif
+    free(s_index);
+    s_index = NULL;
+    free(s_names);
+    s_names = NULL;
+    s_count = 0;
+}
+
+/* 读取索引和名字表，检查每一项都在包文件的范围内 */
+static bool pack_load_index(const uint8_t *hdr, uint32_t file_size)
+{
+    uint32_t count = le32(hdr + 8);
+    uint32_t index_off = le32(hdr + 12);
+    uint32_t names_off = le32(hdr + 16);
+    uint32_t data_off = le32(hdr + 20);
+    uint32_t names_size = data_off - names_off;
+
+    if (count > file_size / PACK_ENTRY_SIZE ||
+            names_off < index_off + count * PACK_ENTRY_SIZE || data_off < names_off ||
+            data_off > file_size || names_size > PACK_NAMES_MAX) {
+        return false;
+    }
+
+    uint8_t *raw = malloc(count * PACK_ENTRY_SIZE);
+    s_index = malloc(count * sizeof(lv_port_pack_entry_t));
+    s_names = malloc(names_size + 1);
+    UINT br;
+    bool ok = raw && s_index && s_names &&
+              pack_read_at(index_off, raw, count * PACK_ENTRY_SIZE, &br) && br == count * PACK_ENTRY_SIZE &&
+              pack_read_at(names_off, s_names, names_size, &br) && br == names_size;
+    if (ok) {
+        s_names[names_size] = '\0';
+    }
+    for (uint32_t i = 0; ok && i < count; i++) {
+        const uint8_t *p = raw + i * PACK_ENTRY_SIZE;
+        lv_port_pack_entry_t *e = &s_index[i];
+        e->hash = le32(p);
+        e->name_off = le32(p + 4) - names_off;
+        e->offset = le32(p + 8);
+        e->size = le32(p + 12);
+        ok = le32(p + 4) >= names_off && e->name_off < names_size &&
+             e->offset >= data_off && e->size <= file_size - e->offset;
+    }
+    free(raw);
+    s_count = count;
+    return ok;
+}
+
+bool lv_port_pack_open(const char *fatfs_path)
+{
+    pack_close();
+
+    FILINFO fno;
+    if (safe_f_stat(fatfs_path, &fno) != FR_OK) {
+        ESP_LOGI(TAG, "no asset pack at %s", fatfs_path);
+        return false;
+    }
+    if (safe_f_open(&s_fil, fatfs_path, FA_READ) != FR_OK) {
+        ESP_LOGW(TAG, "open %s failed", fatfs_path);
+        return false;
+    }
+    s_open = true;
+    s_pos = 0;
+    s_stamp = ((uint32_t)fno.fdate << 16) | fno.ftime;
+#if CONFIG_FATFS_USE_FASTSEEK
+    // 定位到各个文件时查表找簇，不再每次从包文件开头沿 FAT 链走到目标位置
+    s_fil.cltbl = s_clmt;
+    s_clmt[0] = CONFIG_APP_FS_FASTSEEK_CLMT_LEN;
+    FRESULT res = safe_f_lseek(&s_fil, CREATE_LINKMAP);
+    if (res != FR_OK) {
+        ESP_LOGW(TAG, "%s: no fast seek, error %d (map needs %" PRIu32 " entries)", fatfs_path, res, (uint32_t)s_clmt[0]);
+        s_fil.cltbl = NULL;
+    }
+#endif
+
+    uint8_t hdr[PACK_HEADER_SIZE];
+    UINT br;
+    if (!pack_read_at(0, hdr, sizeof(hdr), &br) || br != sizeof(hdr) ||
+            le32(hdr) != PACK_MAGIC || le16(hdr + 4) != PACK_VERSION || !(le16(hdr + 6) & PACK_FLAG_FILES)) {
+        ESP_LOGW(TAG, "%s is not a file pack made by mkassets.py --files", fatfs_path);
+        pack_close();
+        return false;
+    }
+    if (!pack_load_index(hdr, fno.fsize)) {
+        ESP_LOGW(TAG, "%s: corrupted index", fatfs_path);
+        pack_close();
+        return false;
+    }
+
+    ESP_LOGI(TAG, "%s: %" PRIu32 " files, index %" PRIu32 " bytes in RAM", fatfs_path, s_count,
+             (uint32_t)(s_count * sizeof(lv_port_pack_entry_t) + le32(hdr + 20) - le32(hdr + 16)));
+    return true;
+}
+
+const lv_port_pack_entry_t *lv_port_pack_find(const char *name)
+{
+    if (!s_open) {
+        return NULL;
+    }
+
+    // 二分查找第一个哈希相同的条目，再逐个比较名字
+    uint32_t hash = pack_hash(name);
+    uint32_t lo = 0;
+    uint32_t hi = s_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (s_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < s_count && s_index[lo].hash == hash; lo++) {
+        if (strcmp(s_names + s_index[lo].name_off, name) == 0) {
+            return &s_index[lo];
+        }
+    }
+    return NULL;
+}
+
+FRESULT lv_port_pack_read(const lv_port_pack_entry_t *e, uint32_t pos, void *buf, UINT btr, UINT *br)
+{
+    *br = 0;
+    if (pos >= e->size) {
+        return FR_OK;
+    }
+    if (btr > e->size - pos) {
+        btr = e->size - pos;
+    }
+    return pack_read_at(e->offset + pos, buf, btr, br) ? FR_OK : FR_DISK_ERR;
+}
+
+uint32_t lv_port_pack_stamp(void)
+{
+    return s_stamp;
+}
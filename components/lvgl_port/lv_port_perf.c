@@ -0,0 +1,223 @@
+// lv_port_perf.c
+//
+// 显示刷新路径的性能统计。时间点都在 lv_port_disp.c 的刷新回调和 SPI 完成中断里记录：
+//   render_start (LVGL 开始渲染一帧)
+//     -> flush_begin / flush_end (每个 strip 的 flush 回调，回调内的时间不算渲染时间)
+//     -> trans_queued / trans_done_isr (每次 draw_bitmap 的 SPI 传输)
+//     -> frame_done (最后一个 strip)，等排队的传输全部完成后结算这一帧
+// 总线等待时间和发送字节数来自 ST7789 驱动的 draw_bitmap 统计。
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "lvgl.h"
+#include "esp_lcd_st7789v3.h"
+#include "lv_port_perf.h"
+
+#if CONFIG_APP_LCD_PERF
+
+static const char *TAG = "lv_port_perf";
+
+#define PERF_TRANS_FIFO_LEN     (8)
+
+static portMUX_TYPE perf_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_lcd_panel_handle_t perf_panel = NULL;
+static esp_lcd_st7789v3_stats_t panel_last; // 上次输出时的驱动统计，用于计算差值
+static int64_t period_start_us;
+
+/* 当前帧 */
+static int64_t frame_start_us;
+static int64_t render_mark_us;      // 上一次回到渲染的时间点
+static uint32_t frame_render_us;
+static bool frame_closing;          // 最后一个 strip 已经提交，等传输完成
+
+/* 排队中的 SPI 传输，按提交顺序完成 */
+static int64_t trans_fifo[PERF_TRANS_FIFO_LEN];
+static int trans_head;
+static int trans_count;
+static int64_t trans_last_done_us;
+
+static lv_port_perf_stats_t acc;
+
+static const uint8_t fps_bin_edges[LV_PORT_PERF_FPS_BINS - 1] = {10, 20, 30, 40, 50, 60};
+
+/* 结算一帧，调用时持有 perf_lock */
+static void IRAM_ATTR perf_frame_close(int64_t end_us)
+{
+    uint32_t frame_us = (uint32_t)(end_us - frame_start_us);
+    acc.frames++;
+    acc.frame_us += frame_us;
+    if (frame_us > acc.frame_max_us) {
+        acc.frame_max_us = frame_us;
+    }
+    acc.render_us += frame_render_us;
+    if (frame_render_us > acc.render_max_us) {
+        acc.render_max_us = frame_render_us;
+    }
+
+    uint32_t fps = frame_us ? 1000000 / frame_us : UINT32_MAX;
+    int bin = 0;
+    while (bin < LV_PORT_PERF_FPS_BINS - 1 && fps >= fps_bin_edges[bin]) {
+        bin++;
+    }
+    acc.fps_hist[bin]++;
+    frame_closing = false;
+}
+
+void lv_port_perf_render_start(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&perf_lock);
+    if (frame_closing) {
+        // 上一帧的传输还没有全部完成就开始了下一帧，按现在结算
+        perf_frame_close(now);
+    }
+    frame_start_us = now;
+    frame_render_us = 0;
+    portEXIT_CRITICAL(&perf_lock);
+    render_mark_us = now;
+}
+
+void lv_port_perf_flush_begin(void)
+{
+    frame_render_us += (uint32_t)(esp_timer_get_time() - render_mark_us);
+}
+
+void lv_port_perf_flush_end(void)
+{
+    render_mark_us = esp_timer_get_time();
+}
+
+void lv_port_perf_trans_queued(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&perf_lock);
+    if (trans_count < PERF_TRANS_FIFO_LEN) {
+        trans_fifo[(trans_head + trans_count) % PERF_TRANS_FIFO_LEN] = now;
+        trans_count++;
+    }
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+void lv_port_perf_trans_cancel(void)
+{
+    portENTER_CRITICAL(&perf_lock);
+    if (trans_count > 0) {
+        trans_count--;
+    }
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+void IRAM_ATTR lv_port_perf_trans_done_isr(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&perf_lock);
+    if (trans_count > 0) {
+        // 传输依次进行：从提交时刻或前一个传输完成时刻中较晚的一个开始计算总线占用
+        int64_t start = trans_fifo[trans_head];
+        if (start < trans_last_done_us) {
+            start = trans_last_done_us;
+        }
+        acc.spi_us += now - start;
+        trans_head = (trans_head + 1) % PERF_TRANS_FIFO_LEN;
+        trans_count--;
+    }
+    trans_last_done_us = now;
+    if (frame_closing && trans_count == 0) {
+        perf_frame_close(now);
+    }
+    portEXIT_CRITICAL_ISR(&perf_lock);
+}
+
+void lv_port_perf_frame_done(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&perf_lock);
+    frame_render_us += (uint32_t)(now - render_mark_us);
+    frame_closing = true;
+    if (trans_count == 0) {
+        // 这一帧没有需要发送的内容 (或者已经发完了)
+        perf_frame_close(now);
+    }
+    portEXIT_CRITICAL(&perf_lock);
+}
+
+void lv_port_perf_get(lv_port_perf_stats_t *out, bool reset)
+{
+    esp_lcd_st7789v3_stats_t panel_now;
+    esp_lcd_st7789v3_get_stats(perf_panel, &panel_now, false);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&perf_lock);
+    *out = acc;
+    if (reset) {
+        memset(&acc, 0, sizeof(acc));
+    }
+    portEXIT_CRITICAL(&perf_lock);
+
+    out->period_ms = (uint32_t)((now - period_start_us) / 1000);
+    out->lock_wait_us = panel_now.lock_wait_us - panel_last.lock_wait_us;
+    out->bytes = (uint32_t)(panel_now.bytes_sent - panel_last.bytes_sent);
+    if (reset) {
+        panel_last = panel_now;
+        period_start_us = now;
+    }
+}
+
+void lv_port_perf_dump(bool machine)
+{
+    lv_port_perf_stats_t st;
+    lv_port_perf_get(&st, true);
+
+    uint32_t n = st.frames ? st.frames : 1;
+    uint32_t fps_x10 = st.period_ms ? st.frames * 10000 / st.period_ms : 0;
+    const uint32_t *h = st.fps_hist;
+
+    if (machine) {
+        // 一行 key=value，便于脚本从串口日志中提取
+        printf("PERF frames=%" PRIu32 " period_ms=%" PRIu32 " fps=%" PRIu32 ".%" PRIu32
+               " render_us=%" PRIu32 " render_max_us=%" PRIu32 " spi_us=%" PRIu32
+               " frame_us=%" PRIu32 " frame_max_us=%" PRIu32 " lock_wait_us=%" PRIu32 " bytes=%" PRIu32
+               " hist=%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n",
+               st.frames, st.period_ms, fps_x10 / 10, fps_x10 % 10,
+               (uint32_t)(st.render_us / n), st.render_max_us, (uint32_t)(st.spi_us / n),
+               (uint32_t)(st.frame_us / n), st.frame_max_us, (uint32_t)(st.lock_wait_us / n), (uint32_t)(st.bytes / n),
+               h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+        return;
+    }
+
+    ESP_LOGI(TAG, "%" PRIu32 " frames in %" PRIu32 " ms (%" PRIu32 ".%" PRIu32 " fps)",
+             st.frames, st.period_ms, fps_x10 / 10, fps_x10 % 10);
+    ESP_LOGI(TAG, "per frame: render %" PRIu32 " us (max %" PRIu32 "), spi %" PRIu32 " us, total %" PRIu32
+             " us (max %" PRIu32 "), bus wait %" PRIu32 " us, %" PRIu32 " bytes",
+             (uint32_t)(st.render_us / n), st.render_max_us, (uint32_t)(st.spi_us / n),
+             (uint32_t)(st.frame_us / n), st.frame_max_us, (uint32_t)(st.lock_wait_us / n), (uint32_t)(st.bytes / n));
+    ESP_LOGI(TAG, "fps histogram: <10:%" PRIu32 " 10-19:%" PRIu32 " 20-29:%" PRIu32 " 30-39:%" PRIu32
+             " 40-49:%" PRIu32 " 50-59:%" PRIu32 " >=60:%" PRIu32,
+             h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+}
+
+static void perf_timer_cb(lv_timer_t *timer)
+{
+#if CONFIG_APP_LCD_PERF_FORMAT_LINE
+    lv_port_perf_dump(true);
+#else
+    lv_port_perf_dump(false);
+#endif
+}
+
+void lv_port_perf_init(esp_lcd_panel_handle_t panel)
+{
+    perf_panel = panel;
+    esp_lcd_st7789v3_get_stats(panel, &panel_last, false);
+    period_start_us = esp_timer_get_time();
+    // 在 LVGL 任务里输出，避免在其他任务中访问驱动统计时和刷新并发；周期为 0 时只按需读取
+    if (CONFIG_APP_LCD_PERF_PERIOD_S > 0) {
+        lv_timer_create(perf_timer_cb, CONFIG_APP_LCD_PERF_PERIOD_S * 1000, NULL);
+    }
+}
+
+#endif /* CONFIG_APP_LCD_PERF */
@@ -0,0 +1,153 @@
+// lv_port_storage.c
+//
+// 分阶段启动中的存储部分。原来 app_main 先挂载 LittleFS (失败时还可能格式化)，
+// app_lcd_init 挂载 TF 卡后还要建立目录索引，第一帧要等这些都完成。
+// TF 卡仍由 app_lcd_init 在 LCD 的任何传输之前初始化和挂载 (共用总线时卡必须先进入 SPI 模式)，
+// 耗时的 LittleFS 挂载和目录索引则放到这里的后台任务中，lvgl_task 继续初始化 LVGL 并显示第一帧。
+// 后台任务优先级低于 LVGL 任务，只在 LVGL 任务等待时运行。先挂载不使用 SPI 总线的 LittleFS，
+// 再建立 TF 卡索引；每完成一个就在事件组中置位，并在 LVGL 任务中调用等待它的回调。
+
+#include <stdbool.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_littlefs.h"
+#include "lvgl.h"
+#include "lv_port_disp.h"
+#include "lv_port_tick.h"
+#include "lv_port_storage.h"
+
+static const char *TAG = "lv_port_storage";
+
+#define STORAGE_TASK_STACK      (4096)
+#define STORAGE_OK_SHIFT        (4)     // 挂载结束的位在低 4 位，挂载成功的位左移 4 位
+#define STORAGE_CB_MAX          (4)
+
+typedef struct {
+    lv_port_storage_cb_t cb;
+    void *user_data;
+    lv_port_storage_t which;
+} storage_waiter_t;
+
+static StaticEventGroup_t s_events_buf;
+static EventGroupHandle_t s_events;
+// 等待挂载的回调，只在 LVGL 任务中或持有 lv_port_lock 时访问
+static storage_waiter_t s_waiters[STORAGE_CB_MAX];
+
+static esp_err_t storage_mount_littlefs(void)
+{
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = "/littlefs",
+        .partition_label = "storage",
+        .format_if_mount_failed = true,
+        .dont_mount = false,
+    };
+
+    // esp_vfs_littlefs_register 一次完成挂载 (失败时格式化) 和 VFS 注册
+    esp_err_t ret = esp_vfs_littlefs_register(&conf);
+    if (ret == ESP_FAIL) {
+        ESP_LOGE(TAG, "Failed to mount or format LittleFS");
+    } else if (ret == ESP_ERR_NOT_FOUND) {
+        ESP_LOGE(TAG, "Failed to find LittleFS partition");
+    } else if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize LittleFS (%s)", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void storage_set_done(lv_port_storage_t which, bool mounted)
+{
+    xEventGroupSetBits(s_events, which | (mounted ? which << STORAGE_OK_SHIFT : 0));
+}
+
+/* 在 LVGL 任务中调用等待的存储都已挂载结束的回调 */
+static void storage_dispatch_cb(void *arg)
+{
+    EventBits_t done = xEventGroupGetBits(s_events);
+    for (int i = 0; i < STORAGE_CB_MAX; i++) {
+        storage_waiter_t w = s_waiters[i];
+        if (w.cb == NULL || (done & w.which) != w.which) {
+            continue;
+        }
+        s_waiters[i].cb = NULL;
+        w.cb(lv_port_storage_ready(w.which), w.user_data);
+    }
+}
+
+static void storage_notify(lv_port_storage_t which, bool mounted)
+{
+    storage_set_done(which, mounted);
+    lv_port_lock(0);
+    lv_async_call(storage_dispatch_cb, NULL);
+    lv_port_unlock();
+}
+
+static void storage_task(void *arg)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    bool flash_ok = (storage_mount_littlefs() == ESP_OK);
+    storage_notify(LV_PORT_STORAGE_FLASH, flash_ok);
+    int64_t flash_us = esp_timer_get_time();
+
+    bool sd_ok = (app_sd_build_index() == ESP_OK);
+    storage_notify(LV_PORT_STORAGE_SD, sd_ok);
+
+    ESP_LOGI(TAG, "LittleFS %s after %" PRIu32 " ms, SD %s after %" PRIu32 " ms",
+             flash_ok ? "mounted" : "unavailable", (uint32_t)((flash_us - start_us) / 1000),
+             sd_ok ? "mounted" : "unavailable", (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+    vTaskDelete(NULL);
+}
+
+esp_err_t lv_port_storage_start(void)
+{
+    ESP_RETURN_ON_FALSE(s_events == NULL, ESP_ERR_INVALID_STATE, TAG, "storage already started");
+    s_events = xEventGroupCreateStatic(&s_events_buf);
+
+    BaseType_t ok = xTaskCreatePinnedToCore(storage_task, "storage", STORAGE_TASK_STACK, NULL,
+                                            CONFIG_APP_STORAGE_TASK_PRIORITY, NULL, 0);
+    ESP_RETURN_ON_FALSE(ok == pdPASS, ESP_ERR_NO_MEM, TAG, "create storage task failed");
+    return ESP_OK;
+}
+
+bool lv_port_storage_ready(lv_port_storage_t which)
+{
+    if (s_events == NULL) {
+        return false;
+    }
+    EventBits_t ok_bits = which << STORAGE_OK_SHIFT;
+    return (xEventGroupGetBits(s_events) & ok_bits) == ok_bits;
+}
+
+bool lv_port_storage_wait(lv_port_storage_t which, uint32_t timeout_ms)
+{
+    if (s_events == NULL) {
+        return false;
+    }
+    TickType_t ticks = timeout_ms ? pdMS_TO_TICKS(timeout_ms) : portMAX_DELAY;
+    EventBits_t bits = xEventGroupWaitBits(s_events, which, pdFALSE, pdTRUE, ticks);
+    EventBits_t ok_bits = which << STORAGE_OK_SHIFT;
+    return (bits & ok_bits) == ok_bits;
+}
+
+esp_err_t lv_port_storage_when_ready(lv_port_storage_t which, lv_port_storage_cb_t cb, void *user_data)
+{
+    int i = 0;
+    while (i < STORAGE_CB_MAX && s_waiters[i].cb != NULL) {
+        i++;
+    }
+    ESP_RETURN_ON_FALSE(i < STORAGE_CB_MAX, ESP_ERR_NO_MEM, TAG, "too many storage waiters");
+    s_waiters[i].cb = cb;
+    s_waiters[i].user_data = user_data;
+    s_waiters[i].which = which;
+
+    // 挂载已经结束，后台任务发出的那次调用可能已经执行过了
+    if (s_events && (xEventGroupGetBits(s_events) & which) == which) {
+        lv_async_call(storage_dispatch_cb, NULL);
+    }
+    return ESP_OK;
+}
@@ -8,12 +8,13 @@
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
-#include "esp_lvgl_port.h"
 #include "esp_lcd_st7789v3.h"
 #include "include/lv_port_tick.h"
 #include "include/lv_port_disp.h"
 #include "include/lv_port_indev.h"
 #include "include/lv_port_fs.h"
+#include "include/lv_port_img_dec.h"
+#include "include/lv_port_storage.h"
 #include "ui.h"
 
 #include "wifi_prov_mgr.h"
@@ -22,6 +23,61 @@ static char *TAG = "lv_port_tick";
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+/*
+ * LVGL 调度：整个工程只有 lvgl_task 调用 lv_timer_handler()。
+ * 任务按 lv_timer_handler() 返回的时间睡眠，其他任务修改界面或有输入/数据到来时
+ * 通过任务通知提前唤醒它。所有在 lvgl_task 之外访问 LVGL 的代码都必须持有 lv_port_lock。
+ */
+static SemaphoreHandle_t lvgl_mux = NULL;
+static TaskHandle_t lvgl_task_handle = NULL;
+static esp_timer_handle_t lvgl_tick_timer = NULL;
+
+static void lvgl_tick_cb(void *arg)
+{
+    lv_tick_inc(CONFIG_APP_LVGL_TICK_PERIOD_MS);
+}
+
+static esp_err_t lv_port_sched_init(void)
+{
+    lvgl_mux = xSemaphoreCreateRecursiveMutex();
+    ESP_RETURN_ON_FALSE(lvgl_mux, ESP_ERR_NO_MEM, TAG, "No memory for LVGL mutex");
+
+    const esp_timer_create_args_t tick_args = {
+        .callback = lvgl_tick_cb,
+        .name = "lvgl_tick",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&tick_args, &lvgl_tick_timer), TAG, "Create LVGL tick timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_start_periodic(lvgl_tick_timer, CONFIG_APP_LVGL_TICK_PERIOD_MS * 1000), TAG,
+                        "Start LVGL tick timer failed");
+    return ESP_OK;
+}
+
+bool lv_port_lock(uint32_t timeout_ms)
+{
+    assert(lvgl_mux && "lv_port_lock called before lvgl_task started");
+    const TickType_t ticks = (timeout_ms == 0) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTakeRecursive(lvgl_mux, ticks) == pdTRUE;
+}
+
+void lv_port_unlock(void)
+{
+    assert(lvgl_mux && "lv_port_unlock called before lvgl_task started");
+    xSemaphoreGiveRecursive(lvgl_mux);
+    // 其他任务修改了界面，让 LVGL 任务马上处理，而不是等到下一次超时
+    if (xTaskGetCurrentTaskHandle() != lvgl_task_handle) {
+        lv_port_wake();
+    }
+}
+
+void lv_port_wake(void)
+{
+    if (lvgl_task_handle) {
+        xTaskNotifyGive(lvgl_task_handle);
+    }
+}
 
 // Some resources are lazy allocated in the LCD driver, the threadhold is left for that case
 #define TEST_MEMORY_LEAK_THRESHOLD (512)
@@ -94,18 +150,35 @@ void list_files_in_directory(const char *path) {
 
 void lvgl_task(void *pvParameters)
 {
+    lvgl_task_handle = xTaskGetCurrentTaskHandle();
+    ESP_ERROR_CHECK(lv_port_sched_init());
+
+    lv_port_lock(0);
     ESP_ERROR_CHECK(app_lcd_init());
+    // TF 卡已在 app_lcd_init 中挂载，LittleFS 和 TF 卡目录索引在低优先级的后台任务中完成，第一帧不再等待它们
+    ESP_ERROR_CHECK(lv_port_storage_start());
     ESP_ERROR_CHECK(app_lvgl_init());
     ESP_ERROR_CHECK(lvgl_indev_init());
     lv_port_fs_init();  
+    lv_port_img_dec_init();
 
     create_main_screen();
+    lv_port_unlock();
 
     while (1) {
+        lv_port_lock(0);
+        uint32_t delay_ms = lv_timer_handler();
+        lv_port_unlock();
 
-        uint32_t time = lv_timer_handler();
-        vTaskDelay(pdMS_TO_TICKS(10));  // 推荐 5~20ms
-        // ESP_LOGI(TAG, "[time:%d] ", (int)time);
+        // 没有就绪的定时器时 lv_timer_handler 返回 LV_NO_TIMER_READY，按上限睡眠
+        if (delay_ms > CONFIG_APP_LVGL_TASK_MAX_SLEEP_MS) {
+            delay_ms = CONFIG_APP_LVGL_TASK_MAX_SLEEP_MS;
+        }
+        TickType_t ticks = pdMS_TO_TICKS(delay_ms);
+        if (ticks == 0) {
+            ticks = 1; // 至少让出一个 tick，避免空转
+        }
+        ulTaskNotifyTake(pdTRUE, ticks);
     }
 }
 
@@ -0,0 +1,35 @@
+// test_lv_port_fs.c
+//
+// lv_port_fs 的路径转换。应用中的路径写成 "A:/sdcard/x"，解码器、缓存和资源包
+// 必须和驱动回调收到的 "/x" 得到同一个 FatFs 路径。不需要挂载 TF 卡。
+
+#include <string.h>
+#include "unity.h"
+#include "lv_port_fs.h"
+
+TEST_CASE("every form of an SD path maps to the same FatFs path", "[lv_port_fs]")
+{
+    static const char *const paths[] = {"A:/sdcard/Chie_240.bin", "/sdcard/Chie_240.bin", "A:/Chie_240.bin",
+                                        "/Chie_240.bin"};
+    char buf[64];
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        TEST_ASSERT_TRUE_MESSAGE(lv_port_fs_fatfs_path(paths[i], buf, sizeof(buf)), paths[i]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("0:/Chie_240.bin", buf, paths[i]);
+    }
+}
+
+TEST_CASE("mount point is only stripped as a whole path component", "[lv_port_fs]")
+{
+    char buf[64];
+    TEST_ASSERT_TRUE(lv_port_fs_fatfs_path("A:/sdcard", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("0:/", buf);
+    TEST_ASSERT_TRUE(lv_port_fs_fatfs_path("A:/sdcard2/x.bin", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("0:/sdcard2/x.bin", buf);
+}
+
+TEST_CASE("paths on other drives or too long are rejected", "[lv_port_fs]")
+{
+    char buf[16];
+    TEST_ASSERT_FALSE(lv_port_fs_fatfs_path("L:/Chie_240.bin", buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(lv_port_fs_fatfs_path("A:/a_rather_long_name.bin", buf, sizeof(buf)));
+}
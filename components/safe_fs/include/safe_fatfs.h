@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "ff.h" // 包含原始 FatFS 的头文件，以便使用 FIL, FRESULT 等类型
 
@@ -7,8 +9,72 @@
 extern "C" {
 #endif
 
-esp_err_t safe_fs_init(const char* base_path);
-
+/**
+ * @brief 加锁的操作，统计数据按操作分别记录
+ */
+typedef enum {
+    SAFE_FATFS_OP_OPEN = 0,
+    SAFE_FATFS_OP_CLOSE,
+    SAFE_FATFS_OP_READ,
+    SAFE_FATFS_OP_WRITE,
+    SAFE_FATFS_OP_LSEEK,
+    SAFE_FATFS_OP_EXPAND,
+    SAFE_FATFS_OP_TRUNCATE,
+    SAFE_FATFS_OP_STAT,
+    SAFE_FATFS_OP_MKDIR,
+    SAFE_FATFS_OP_UNLINK,
+    SAFE_FATFS_OP_RENAME,
+    SAFE_FATFS_OP_OPENDIR,
+    SAFE_FATFS_OP_READDIR,
+    SAFE_FATFS_OP_CLOSEDIR,
+    SAFE_FATFS_OP_MAX,
+} safe_fatfs_op_t;
+
+/**
+ * @brief 单个操作的加锁统计
+ */
+typedef struct {
+    uint32_t acquire_count;     // 成功获取卷锁的次数
+    uint32_t contended_count;   // 获取时卷锁已被占用、需要等待的次数
+    uint32_t timeout_count;     // 获取超时的次数 (返回 FR_TIMEOUT)
+    uint64_t total_hold_us;     // 累计持有时间 (包括持锁期间等待总线的时间)
+    uint32_t max_hold_us;       // 单次最长持有时间
+} safe_fatfs_op_stats_t;
+
+/**
+ * @brief 初始化每个卷的锁，必须在任何 safe_f_* 调用之前调用
+ */
+esp_err_t safe_fatfs_init(void);
+
+/**
+ * @brief 设置卷是否在共享 SPI 总线上 (默认在)
+ *
+ * 在共享总线上的卷持有卷锁期间还要向 spi_bus_sched 获取 SD 客户端；
+ * 不在总线上的卷 (例如内部 flash 上的 FAT) 只使用自己的卷锁。
+ *
+ * @param vol FatFs 逻辑驱动器号，和 "0:" 中的数字相同
+ */
+void safe_fatfs_set_shared_bus(BYTE vol, bool shared);
+
+/**
+ * @brief 读取某个操作的统计数据
+ */
+void safe_fatfs_get_stats(safe_fatfs_op_t op, safe_fatfs_op_stats_t *out_stats);
+
+/**
+ * @brief 清零所有操作的统计数据
+ */
+void safe_fatfs_reset_stats(void);
+
+/**
+ * @brief 把所有执行过的操作的统计数据打印到日志
+ */
+void safe_fatfs_dump_stats(void);
+
+/*
+ * 以下函数和对应的 f_* 相同，按卷加锁。
+ * 在 CONFIG_SAFE_FATFS_LOCK_TIMEOUT_MS 内拿不到锁时返回 FR_TIMEOUT。
+ */
 
 FRESULT safe_f_open(FIL* fp, const TCHAR* path, BYTE mode);
 
@@ -18,11 +84,11 @@ FRESULT safe_f_read(FIL* fp, void* buff, UINT btr, UINT* br);
 
 FRESULT safe_f_write(FIL* fp, const void* buff, UINT btw, UINT* bw);
 
-FRESULT safe_f_tell(FIL* fp);
+FRESULT safe_f_lseek(FIL* fp, FSIZE_t ofs);
 
-FRESULT safe_f_size(FIL* fp);
+FRESULT safe_f_expand(FIL* fp, FSIZE_t fsz, BYTE opt);
 
-FRESULT safe_f_lseek(FIL* fp, FSIZE_t ofs);
+FRESULT safe_f_truncate(FIL* fp);
 
 FRESULT safe_f_mkdir(const TCHAR* path);
 
@@ -38,6 +104,55 @@ FRESULT safe_f_readdir(FF_DIR* dp, FILINFO* fno);
 
 FRESULT safe_f_closedir(FF_DIR* dp);
 
+/**
+ * @brief 遍历卷的目录树，在 RAM 中建立索引 (CONFIG_SAFE_FATFS_INDEX)
+ *
+ * 建立后 safe_f_stat 和只读打开不存在的文件直接由索引回答，通过 safe_f_* 的修改会同步到索引。
+ * 不经过 safe_f_* 修改卷 (VFS、PC 读卡器) 之后需要重新建立。
+ * 容量不够时返回 ESP_FAIL，所有调用照常访问 TF 卡。
+ *
+ * @param vol FatFs 逻辑驱动器号，同一时间只索引一个卷
+ */
+esp_err_t safe_fatfs_index_build(BYTE vol);
+
+/**
+ * @brief 丢弃索引并释放内存，例如卸载 TF 卡之前
+ */
+void safe_fatfs_index_drop(void);
+
+/**
+ * @brief 用索引列目录的游标
+ */
+typedef struct {
+    int32_t dir;        // 目录在索引中的编号，根目录是 -1
+    uint32_t pos;       // 下一次从这一项开始查找
+    uint32_t gen;       // 打开时的索引版本，索引重建或丢弃后游标失效
+} safe_fatfs_index_dir_t;
+
+/**
+ * @brief 索引已建立且目录存在时返回 true，之后用 safe_fatfs_index_readdir 列出内容，不需要关闭
+ */
+bool safe_fatfs_index_opendir(safe_fatfs_index_dir_t* dir, const TCHAR* path);
+
+/**
+ * @brief 和 f_readdir 相同，列完时 fno->fname[0] 为 0；索引在此期间失效时返回 FR_INVALID_OBJECT
+ */
+FRESULT safe_fatfs_index_readdir(safe_fatfs_index_dir_t* dir, FILINFO* fno);
+
+/*
+ * 读写位置和文件大小缓存在 FIL 中，只有持有这个 FIL 的任务会修改，读取不需要加锁
+ */
+
+static inline FSIZE_t safe_f_tell(FIL* fp)
+{
+    return f_tell(fp);
+}
+
+static inline FSIZE_t safe_f_size(FIL* fp)
+{
+    return f_size(fp);
+}
+
 #ifdef __cplusplus
 }
 #endif
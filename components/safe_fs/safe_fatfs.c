@@ -1,145 +1,460 @@
 // safe_fatfs.c
+//
+// FatFs 调用的线程安全封装。
+//   - 每个卷一把锁：不同卷上的调用互不等待，同一个卷上的调用在卷锁上排队，
+//     总线调度器只会看到一个 SD 等待者；
+//   - 在共享 SPI 总线上的卷，持有卷锁期间再向 spi_bus_sched 获取 SD 客户端，
+//     大块读写按块让出总线给显示屏；
+//   - 等待卷锁和总线的时间有上限，超时返回 FR_TIMEOUT，一张卡住的 TF 卡不会让所有调用者永远阻塞；
+//   - f_tell / f_size 只是读取 FIL 中的字段，不加锁 (见 safe_fatfs.h)；
+//   - 按操作记录获取次数、竞争次数、超时次数和持锁时间；
+//   - 建立目录索引后 (safe_fatfs_index.c)，f_stat 和打开不存在的文件不再访问 TF 卡，
+//     修改目录的调用在持有卷锁时把结果同步到索引，索引和卡上的顺序一致。
 
-#include <stdio.h>  // For standard file I/O (fopen, fclose, fread, fwrite, fseek, ftell)
-#include <string.h> // For string manipulation (e.g., strcpy, strlen)
-#include <dirent.h> // For directory operations (opendir, readdir, closedir)
-#include <errno.h>  // For error handling (errno)
+#include <string.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "esp_timer.h"
 #include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
 #include "ff.h"
 
-// 定义一个静态的互斥锁句柄
-extern SemaphoreHandle_t spi_mutex;
+#include "spi_bus_sched.h"
+#include "safe_fatfs.h"
+#include "safe_fatfs_index.h"
+
+static const char *TAG = "safe_fatfs";
+
+#define FATFS_LOCK_TIMEOUT      pdMS_TO_TICKS(CONFIG_SAFE_FATFS_LOCK_TIMEOUT_MS)
+
+typedef struct {
+    SemaphoreHandle_t lock;
+    bool shared_bus;            // 卷在共享 SPI 总线上，持锁期间还要持有总线
+} fs_volume_t;
+
+/* 一次加锁，从 fs_lock 到 fs_unlock */
+typedef struct {
+    fs_volume_t *vol;
+    safe_fatfs_op_t op;
+    bool contended;
+    int64_t start_us;
+} fs_lock_t;
+
+static fs_volume_t s_volumes[FF_VOLUMES];
+static SemaphoreHandle_t s_state_mutex;     // 保护统计数据
+static safe_fatfs_op_stats_t s_stats[SAFE_FATFS_OP_MAX];
+
+static const char *const s_op_names[SAFE_FATFS_OP_MAX] = {
+    [SAFE_FATFS_OP_OPEN] = "open",
+    [SAFE_FATFS_OP_CLOSE] = "close",
+    [SAFE_FATFS_OP_READ] = "read",
+    [SAFE_FATFS_OP_WRITE] = "write",
+    [SAFE_FATFS_OP_LSEEK] = "lseek",
+    [SAFE_FATFS_OP_EXPAND] = "expand",
+    [SAFE_FATFS_OP_TRUNCATE] = "truncate",
+    [SAFE_FATFS_OP_STAT] = "stat",
+    [SAFE_FATFS_OP_MKDIR] = "mkdir",
+    [SAFE_FATFS_OP_UNLINK] = "unlink",
+    [SAFE_FATFS_OP_RENAME] = "rename",
+    [SAFE_FATFS_OP_OPENDIR] = "opendir",
+    [SAFE_FATFS_OP_READDIR] = "readdir",
+    [SAFE_FATFS_OP_CLOSEDIR] = "closedir",
+};
+
+#if CONFIG_SAFE_FATFS_STATS_PERIOD_S > 0
+static esp_timer_handle_t s_stats_timer;
+
+static void stats_timer_cb(void *arg)
+{
+    safe_fatfs_dump_stats();
+}
+#endif
 
 esp_err_t safe_fatfs_init(void)
 {
-    // // 防止重复初始化
-    // if (s_fatfs_mutex) {
-    //     return ESP_OK;
-    // }
+    // 防止重复初始化
+    if (s_state_mutex) {
+        return ESP_OK;
+    }
+
+    // 总线锁由 spi_bus_sched 统一管理
+    ESP_RETURN_ON_ERROR(spi_bus_sched_init(), TAG, "bus scheduler init failed");
+
+    for (int i = 0; i < FF_VOLUMES; i++) {
+        s_volumes[i].lock = xSemaphoreCreateMutex();
+        s_volumes[i].shared_bus = true;
+        ESP_RETURN_ON_FALSE(s_volumes[i].lock, ESP_ERR_NO_MEM, TAG, "no mem for volume lock");
+    }
+    s_state_mutex = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(s_state_mutex, ESP_ERR_NO_MEM, TAG, "no mem for stats lock");
+    memset(s_stats, 0, sizeof(s_stats));
+    ESP_RETURN_ON_ERROR(index_init(), TAG, "index init failed");
+
+#if CONFIG_SAFE_FATFS_STATS_PERIOD_S > 0
+    const esp_timer_create_args_t timer_args = {
+        .callback = stats_timer_cb,
+        .name = "fatfs_stats",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &s_stats_timer), TAG, "create stats timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_start_periodic(s_stats_timer, CONFIG_SAFE_FATFS_STATS_PERIOD_S * 1000000ULL),
+                        TAG, "start stats timer failed");
+#endif
 
-    // s_fatfs_mutex = xSemaphoreCreateMutex();
-    // if (s_fatfs_mutex == NULL) {
-    //     // ESP_LOGE("SAFE_FATFS", "Failed to create mutex!"); // 建议添加日志
-    //     return ESP_FAIL;
-    // }
     return ESP_OK;
 }
 
-// 宏定义，用于简化每个函数的加锁和解锁逻辑
-#define FATFS_LOCK()                                       \
-    do {                                                   \
-        xSemaphoreTake(spi_mutex, portMAX_DELAY);      \
-    } while (0)
+void safe_fatfs_set_shared_bus(BYTE vol, bool shared)
+{
+    assert(vol < FF_VOLUMES);
+    s_volumes[vol].shared_bus = shared;
+}
+
+/* 路径中的 "N:" 前缀就是卷号，没有前缀时是默认卷 0 */
+static BYTE path_volume(const TCHAR *path)
+{
+    if (path && path[0] >= '0' && path[0] < '0' + FF_VOLUMES && path[1] == ':') {
+        return path[0] - '0';
+    }
+    return 0;
+}
+
+/* 已打开的文件/目录所在的卷。esp_vfs_fat 把逻辑驱动器 N 挂在物理驱动器 N 上 */
+static BYTE obj_volume(const FFOBJID *obj)
+{
+    if (obj->fs && obj->fs->pdrv < FF_VOLUMES) {
+        return obj->fs->pdrv;
+    }
+    return 0; // 没有打开的对象，交给 FatFs 返回 FR_INVALID_OBJECT
+}
+
+static void record_timeout(safe_fatfs_op_t op, bool contended)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    s_stats[op].timeout_count++;
+    if (contended) {
+        s_stats[op].contended_count++;
+    }
+    xSemaphoreGive(s_state_mutex);
+    ESP_LOGW(TAG, "%s: lock timed out", s_op_names[op]);
+}
+
+// 先拿卷锁，再拿总线 (总线总是内层锁)，两者一共最多等待 FATFS_LOCK_TIMEOUT
+static bool fs_lock(fs_lock_t *lk, BYTE vol, safe_fatfs_op_t op)
+{
+    assert(s_state_mutex && vol < FF_VOLUMES);
+
+    fs_volume_t *v = &s_volumes[vol];
+    TickType_t start_tick = xTaskGetTickCount();
+    bool contended = false;
+
+    if (xSemaphoreTake(v->lock, 0) != pdTRUE) {
+        contended = true;
+        if (xSemaphoreTake(v->lock, FATFS_LOCK_TIMEOUT) != pdTRUE) {
+            record_timeout(op, contended);
+            return false;
+        }
+    }
+    if (v->shared_bus) {
+        TickType_t elapsed = xTaskGetTickCount() - start_tick;
+        TickType_t remaining = (elapsed >= FATFS_LOCK_TIMEOUT) ? 0 : FATFS_LOCK_TIMEOUT - elapsed;
+        if (!spi_bus_sched_acquire(SPI_BUS_CLIENT_SD, remaining)) {
+            xSemaphoreGive(v->lock);
+            record_timeout(op, contended);
+            return false;
+        }
+    }
+
+    lk->vol = v;
+    lk->op = op;
+    lk->contended = contended;
+    lk->start_us = esp_timer_get_time();
+    return true;
+}
+
+static void fs_unlock(fs_lock_t *lk)
+{
+    int64_t hold_us = esp_timer_get_time() - lk->start_us;
+    if (lk->vol->shared_bus) {
+        spi_bus_sched_release(SPI_BUS_CLIENT_SD);
+    }
+    xSemaphoreGive(lk->vol->lock);
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    safe_fatfs_op_stats_t *st = &s_stats[lk->op];
+    st->acquire_count++;
+    if (lk->contended) {
+        st->contended_count++;
+    }
+    st->total_hold_us += hold_us;
+    if (hold_us > st->max_hold_us) {
+        st->max_hold_us = (uint32_t)hold_us;
+    }
+    xSemaphoreGive(s_state_mutex);
+}
+
+// TF 卡是共享 SPI 总线上的低优先级客户端，显示屏等待时会在块边界让出总线
+static void fs_yield(fs_lock_t *lk)
+{
+    if (lk->vol->shared_bus) {
+        spi_bus_sched_yield(SPI_BUS_CLIENT_SD);
+    }
+}
 
-#define FATFS_UNLOCK()                                     \
-    do {                                                   \
-        xSemaphoreGive(spi_mutex);                     \
-    } while (0)
 
+#define FA_MODIFY   (FA_WRITE | FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS | FA_OPEN_APPEND)
 
 FRESULT safe_f_open(FIL* fp, const TCHAR* path, BYTE mode)
 {
-    FATFS_LOCK();
-    FRESULT res = f_open(fp, path, mode);
-    FATFS_UNLOCK();
+    // 只读打开索引中没有的文件，不用访问 TF 卡就能失败
+    FRESULT res;
+    if (!(mode & FA_MODIFY) && index_stat(path, NULL, &res) && res != FR_OK) {
+        memset(fp, 0, sizeof(*fp));
+        return res;
+    }
+
+    fs_lock_t lk;
+    if (!fs_lock(&lk, path_volume(path), SAFE_FATFS_OP_OPEN)) {
+        return FR_TIMEOUT;
+    }
+    res = f_open(fp, path, mode);
+    if (res == FR_OK && (mode & FA_MODIFY)) {
+        index_on_open(fp, path, mode);
+    }
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_close(FIL* fp)
 {
-    FATFS_LOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, obj_volume(&fp->obj), SAFE_FATFS_OP_CLOSE)) {
+        return FR_TIMEOUT;
+    }
     FRESULT res = f_close(fp);
-    FATFS_UNLOCK();
+    index_on_close(fp);
+    fs_unlock(&lk);
     return res;
 }
 
+// 大块读写按 spi_bus_sched_sd_chunk_size() 分块，每块之间检查显示屏是否在等待总线
 FRESULT safe_f_read(FIL* fp, void* buff, UINT btr, UINT* br)
 {
-    FATFS_LOCK();
-    FRESULT res = f_read(fp, buff, btr, br);
-    FATFS_UNLOCK();
+    const UINT chunk = spi_bus_sched_sd_chunk_size();
+    BYTE *dst = (BYTE *)buff;
+    FRESULT res = FR_OK;
+    fs_lock_t lk;
+
+    *br = 0;
+    if (!fs_lock(&lk, obj_volume(&fp->obj), SAFE_FATFS_OP_READ)) {
+        return FR_TIMEOUT;
+    }
+    while (btr > 0) {
+        UINT n = (btr > chunk) ? chunk : btr;
+        UINT done = 0;
+        res = f_read(fp, dst, n, &done);
+        *br += done;
+        if (res != FR_OK || done < n) {
+            break; // 出错或到达文件末尾
+        }
+        dst += done;
+        btr -= done;
+        if (btr > 0) {
+            fs_yield(&lk);
+        }
+    }
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_write(FIL* fp, const void* buff, UINT btw, UINT* bw)
 {
-    FATFS_LOCK();
-    FRESULT res = f_write(fp, buff, btw, bw);
-    FATFS_UNLOCK();
+    const UINT chunk = spi_bus_sched_sd_chunk_size();
+    const BYTE *src = (const BYTE *)buff;
+    FRESULT res = FR_OK;
+    fs_lock_t lk;
+
+    *bw = 0;
+    if (!fs_lock(&lk, obj_volume(&fp->obj), SAFE_FATFS_OP_WRITE)) {
+        return FR_TIMEOUT;
+    }
+    while (btw > 0) {
+        UINT n = (btw > chunk) ? chunk : btw;
+        UINT done = 0;
+        res = f_write(fp, src, n, &done);
+        *bw += done;
+        if (res != FR_OK || done < n) {
+            break; // 出错或磁盘已满
+        }
+        src += done;
+        btw -= done;
+        if (btw > 0) {
+            fs_yield(&lk);
+        }
+    }
+    fs_unlock(&lk);
     return res;
 }
 
-FRESULT safe_f_tell(FIL* fp)
+FRESULT safe_f_lseek(FIL* fp, FSIZE_t ofs)
 {
-    FATFS_LOCK();
-    FRESULT res = f_tell(fp);
-    FATFS_UNLOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, obj_volume(&fp->obj), SAFE_FATFS_OP_LSEEK)) {
+        return FR_TIMEOUT;
+    }
+    FRESULT res = f_lseek(fp, ofs);
+    fs_unlock(&lk);
     return res;
 }
-    
-FRESULT safe_f_size(FIL* fp)
+
+FRESULT safe_f_expand(FIL* fp, FSIZE_t fsz, BYTE opt)
 {
-    FATFS_LOCK();
-    FRESULT res = f_size(fp);
-    FATFS_UNLOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, obj_volume(&fp->obj), SAFE_FATFS_OP_EXPAND)) {
+        return FR_TIMEOUT;
+    }
+    FRESULT res = f_expand(fp, fsz, opt);
+    fs_unlock(&lk);
     return res;
 }
 
+FRESULT safe_f_truncate(FIL* fp)
+{
+    fs_lock_t lk;
+    if (!fs_lock(&lk, obj_volume(&fp->obj), SAFE_FATFS_OP_TRUNCATE)) {
+        return FR_TIMEOUT;
+    }
+    FRESULT res = f_truncate(fp);
+    fs_unlock(&lk);
+    return res;
+}
 
-FRESULT safe_f_lseek(FIL* fp, FSIZE_t ofs)
+FRESULT safe_f_mkdir(const TCHAR* path)
 {
-    FATFS_LOCK();
-    FRESULT res = f_lseek(fp, ofs);
-    FATFS_UNLOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, path_volume(path), SAFE_FATFS_OP_MKDIR)) {
+        return FR_TIMEOUT;
+    }
+    FRESULT res = f_mkdir(path);
+    if (res == FR_OK) {
+        index_on_mkdir(path);
+    }
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_stat(const TCHAR* path, FILINFO* fno)
 {
-    FATFS_LOCK();
-    FRESULT res = f_stat(path, fno);
-    FATFS_UNLOCK();
+    FRESULT res;
+    if (index_stat(path, fno, &res)) {
+        return res;
+    }
+
+    fs_lock_t lk;
+    if (!fs_lock(&lk, path_volume(path), SAFE_FATFS_OP_STAT)) {
+        return FR_TIMEOUT;
+    }
+    FILINFO info;
+    res = f_stat(path, &info);
+    index_on_stat(path, res, &info);
+    if (fno) {
+        *fno = info;
+    }
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_unlink(const TCHAR* path)
 {
-    FATFS_LOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, path_volume(path), SAFE_FATFS_OP_UNLINK)) {
+        return FR_TIMEOUT;
+    }
     FRESULT res = f_unlink(path);
-    FATFS_UNLOCK();
+    if (res == FR_OK) {
+        index_on_unlink(path);
+    }
+    fs_unlock(&lk);
     return res;
 }
 
+// FatFs 只能在同一个卷内重命名，按旧路径的卷加锁
 FRESULT safe_f_rename(const TCHAR* path_old, const TCHAR* path_new)
 {
-    FATFS_LOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, path_volume(path_old), SAFE_FATFS_OP_RENAME)) {
+        return FR_TIMEOUT;
+    }
     FRESULT res = f_rename(path_old, path_new);
-    FATFS_UNLOCK();
+    if (res == FR_OK) {
+        index_on_rename(path_old, path_new);
+    }
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_opendir(FF_DIR* dp, const TCHAR* path)
 {
-    FATFS_LOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, path_volume(path), SAFE_FATFS_OP_OPENDIR)) {
+        return FR_TIMEOUT;
+    }
     FRESULT res = f_opendir(dp, path);
-    FATFS_UNLOCK();
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_readdir(FF_DIR* dp, FILINFO* fno)
 {
-    FATFS_LOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, obj_volume(&dp->obj), SAFE_FATFS_OP_READDIR)) {
+        return FR_TIMEOUT;
+    }
     FRESULT res = f_readdir(dp, fno);
-    FATFS_UNLOCK();
+    fs_unlock(&lk);
     return res;
 }
 
 FRESULT safe_f_closedir(FF_DIR* dp)
 {
-    FATFS_LOCK();
+    fs_lock_t lk;
+    if (!fs_lock(&lk, obj_volume(&dp->obj), SAFE_FATFS_OP_CLOSEDIR)) {
+        return FR_TIMEOUT;
+    }
     FRESULT res = f_closedir(dp);
-    FATFS_UNLOCK();
+    fs_unlock(&lk);
     return res;
 }
+
+void safe_fatfs_get_stats(safe_fatfs_op_t op, safe_fatfs_op_stats_t *out_stats)
+{
+    assert(op < SAFE_FATFS_OP_MAX && out_stats);
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    *out_stats = s_stats[op];
+    xSemaphoreGive(s_state_mutex);
+}
+
+void safe_fatfs_reset_stats(void)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    memset(s_stats, 0, sizeof(s_stats));
+    xSemaphoreGive(s_state_mutex);
+}
+
+void safe_fatfs_dump_stats(void)
+{
+    for (int i = 0; i < SAFE_FATFS_OP_MAX; i++) {
+        safe_fatfs_op_stats_t st;
+        safe_fatfs_get_stats(i, &st);
+        if (st.acquire_count == 0 && st.timeout_count == 0) {
+            continue;
+        }
+        uint32_t avg_us = st.acquire_count ? (uint32_t)(st.total_hold_us / st.acquire_count) : 0;
+        ESP_LOGI(TAG, "%-8s acquire=%" PRIu32 " contended=%" PRIu32 " timeout=%" PRIu32
+                 " hold avg=%" PRIu32 "us max=%" PRIu32 "us",
+                 s_op_names[i], st.acquire_count, st.contended_count, st.timeout_count,
+                 avg_us, st.max_hold_us);
+    }
+    index_dump_stats();
+}
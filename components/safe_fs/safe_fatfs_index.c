@@ -0,0 +1,721 @@
+// safe_fatfs_index.c
+//
+// TF 卡目录树在 RAM 中的索引 (CONFIG_SAFE_FATFS_INDEX)。
+// 挂载后遍历一次目录树，每一项记录相对路径、大小、修改时间和属性，按路径哈希分桶。
+// 之后 f_stat、只读打开不存在的文件和列目录都不再逐项读取 TF 卡上的目录；
+// 通过 safe_f_* 做的修改由 safe_fatfs.c 调用 index_on_* 同步到索引。
+//
+// FatFs 没有按起始簇打开文件的接口，所以索引不记录簇号，存在的文件仍由 f_open 查找目录项，
+// 但调用者不再需要先 f_stat 一次。
+// 索引只回答能确定的写法：带 '~' 的名字 (可能是短文件名)、非 ASCII 字符 (大小写规则取决于代码页)、
+// "." ".." 和末尾带空格或点的名字都交给 FatFs。
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+
+#include "safe_fatfs.h"
+#include "safe_fatfs_index.h"
+
+#if CONFIG_SAFE_FATFS_INDEX
+
+static const char *TAG = "fatfs_index";
+
+#define IDX_MAX_ENTRIES     CONFIG_SAFE_FATFS_INDEX_MAX_ENTRIES
+#define IDX_PATH_BYTES      (CONFIG_SAFE_FATFS_INDEX_PATH_KB * 1024)
+#define IDX_BUCKETS         (256)
+#define IDX_NONE            UINT16_MAX
+#define IDX_WRITERS         (8)         // 同时以写方式打开的文件，超出的文件在重建索引前总是查 TF 卡
+#define IDX_PATH_MAX        (FF_MAX_LFN + 1)
+
+#define IDX_FLAG_FREE       (0x01)      // 空闲项，在空闲链表中
+#define IDX_FLAG_REFRESH    (0x02)      // 文件被写过，下一次 f_stat 从 TF 卡读取大小和时间
+#define IDX_FLAG_UNLISTED   (0x04)      // 建立索引时还没有列出内容的目录
+
+typedef enum {
+    IDX_OFF = 0,        // 没有索引，所有调用访问 TF 卡
+    IDX_BUILDING,       // 正在遍历目录树，只接受更新，不回答查询
+    IDX_READY,
+} idx_state_t;
+
+typedef struct {
+    uint32_t hash;          // 相对路径 (ASCII 转小写) 的哈希
+    uint32_t parent;        // 父目录相对路径的哈希，列目录时比较
+    uint32_t path_off;      // 相对路径在路径表中的偏移，不含 "0:/"
+    FSIZE_t size;
+    WORD fdate;
+    WORD ftime;
+    uint16_t next;          // 同一个桶中的下一项，空闲项则是空闲链表中的下一项
+    uint8_t attrib;
+    uint8_t flags;
+    uint8_t writers;        // 以写方式打开着的次数，大于 0 时索引中的大小和时间不可信
+} idx_entry_t;
+
+typedef struct {
+    FIL *fp;
+    uint16_t entry;
+} idx_writer_t;
+
+static SemaphoreHandle_t s_mutex;
+static idx_state_t s_state;
+static BYTE s_vol;
+static uint32_t s_gen;                  // 每次建立或丢弃索引加一，列目录的游标据此失效
+static idx_entry_t *s_entries;
+static uint32_t s_count;                // 用过的项数，包括空闲链表中的
+static uint16_t s_free;
+static char *s_paths;                   // 路径表，只追加，删除的路径在重建时回收
+static uint32_t s_paths_used;
+static uint16_t s_buckets[IDX_BUCKETS];
+static idx_writer_t s_writers[IDX_WRITERS];
+static uint32_t s_hits;
+static uint32_t s_absent;
+static uint32_t s_fallbacks;
+
+static void idx_lock(void)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+}
+
+static void idx_unlock(void)
+{
+    xSemaphoreGive(s_mutex);
+}
+
+/* FNV-1a，ASCII 字母按小写计算，和 FatFs 不区分大小写的比较一致 */
+static uint32_t idx_hash(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)s[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+static const char *idx_path(const idx_entry_t *e)
+{
+    return s_paths + e->path_off;
+}
+
+/* 相对路径中最后一个 '/' 之前是父目录，根目录下的项父目录是空串 */
+static size_t idx_parent_len(const char *rel)
+{
+    const char *slash = strrchr(rel, '/');
+    return slash ? (size_t)(slash - rel) : 0;
+}
+
+/*
+ * "0:/a/b"、"/a/b"、"a\b" 都转换成索引中的相对路径 "a/b"，根目录是空串。
+ * 不在索引的卷上或者带有索引不能确定的写法时返回 false。
+ */
+static bool idx_normalize(const TCHAR *path, char *out, size_t size)
+{
+    if (path[0] != '\0' && path[1] == ':') {
+        if (path[0] != '0' + s_vol) {
+            return false;
+        }
+        path += 2;
+    } else if (s_vol != 0) {
+        return false; // 不带卷号的路径在默认卷 0 上
+    }
+
+    size_t n = 0;
+    size_t name = 0; // 当前名字在 out 中的起始位置
+    for (const char *p = path;; p++) {
+        char c = (*p == '\\') ? '/' : *p;
+        if (c == '/' || c == '\0') {
+            size_t len = n - name;
+            if (len > 0) {
+                const char *s = out + name;
+                if ((len <= 2 && s[0] == '.' && s[len - 1] == '.') || s[len - 1] == '.' || s[len - 1] == ' ') {
+                    return false;
+                }
+                if (c == '/') {
+                    if (n + 1 >= size) {
+                        return false;
+                    }
+                    out[n++] = '/';
+                    name = n;
+                }
+            }
+            if (c == '\0') {
+                break;
+            }
+            continue;
+        }
+        if ((uint8_t)c >= 0x80 || c == '~' || c == '*' || c == '?' || n + 1 >= size) {
+            return false;
+        }
+        out[n++] = c;
+    }
+    if (n > 0 && out[n - 1] == '/') {
+        n--;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+static int idx_find(const char *rel)
+{
+    uint32_t h = idx_hash(rel, strlen(rel));
+    for (uint16_t i = s_buckets[h % IDX_BUCKETS]; i != IDX_NONE; i = s_entries[i].next) {
+        if (s_entries[i].hash == h && strcasecmp(idx_path(&s_entries[i]), rel) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void idx_link(uint16_t i)
+{
+    uint16_t *head = &s_buckets[s_entries[i].hash % IDX_BUCKETS];
+    s_entries[i].next = *head;
+    *head = i;
+}
+
+static void idx_unlink(uint16_t i)
+{
+    uint16_t *pp = &s_buckets[s_entries[i].hash % IDX_BUCKETS];
+    while (*pp != IDX_NONE && *pp != i) {
+        pp = &s_entries[*pp].next;
+    }
+    if (*pp == i) {
+        *pp = s_entries[i].next;
+    }
+}
+
+/* 容量不够或者遇到无法跟踪的修改时放弃索引，之后所有调用访问 TF 卡，直到下一次建立索引 */
+static void idx_disable(const char *why)
+{
+    if (s_state != IDX_OFF) {
+        ESP_LOGW(TAG, "%s, index disabled until the next build", why);
+    }
+    s_state = IDX_OFF;
+    s_gen++;
+}
+
+static bool idx_set_path(idx_entry_t *e, const char *rel)
+{
+    size_t len = strlen(rel);
+    if (s_paths_used + len + 1 > IDX_PATH_BYTES) {
+        idx_disable("path table full");
+        return false;
+    }
+    memcpy(s_paths + s_paths_used, rel, len + 1);
+    e->path_off = s_paths_used;
+    s_paths_used += len + 1;
+    e->hash = idx_hash(rel, len);
+    e->parent = idx_hash(rel, idx_parent_len(rel));
+    return true;
+}
+
+/* 加入或更新一项，返回编号。容量不够时放弃索引并返回 -1 */
+static int idx_upsert(const char *rel, FSIZE_t size, WORD fdate, WORD ftime, BYTE attrib)
+{
+    int i = idx_find(rel);
+    if (i < 0) {
+        if (s_free != IDX_NONE) {
+            i = s_free;
+            s_free = s_entries[i].next;
+        } else if (s_count < IDX_MAX_ENTRIES) {
+            i = s_count++;
+        } else {
+            idx_disable("too many files");
+            return -1;
+        }
+        idx_entry_t *e = &s_entries[i];
+        memset(e, 0, sizeof(*e));
+        if (!idx_set_path(e, rel)) {
+            e->flags = IDX_FLAG_FREE;
+            e->next = s_free;
+            s_free = i;
+            return -1;
+        }
+        idx_link(i);
+    }
+    idx_entry_t *e = &s_entries[i];
+    e->size = size;
+    e->fdate = fdate;
+    e->ftime = ftime;
+    e->attrib = attrib;
+    return i;
+}
+
+static void idx_remove(int i)
+{
+    idx_unlink(i);
+    for (int w = 0; w < IDX_WRITERS; w++) {
+        if (s_writers[w].fp && s_writers[w].entry == i) {
+            s_writers[w].fp = NULL;
+        }
+    }
+    idx_entry_t *e = &s_entries[i];
+    e->flags = IDX_FLAG_FREE;
+    e->hash = 0;
+    e->next = s_free;
+    s_free = i;
+}
+
+static void idx_fill(const idx_entry_t *e, FILINFO *fno)
+{
+    const char *path = idx_path(e);
+    const char *slash = strrchr(path, '/');
+    fno->fsize = e->size;
+    fno->fdate = e->fdate;
+    fno->ftime = e->ftime;
+    fno->fattrib = e->attrib;
+    strlcpy(fno->fname, slash ? slash + 1 : path, sizeof(fno->fname));
+#if FF_USE_LFN
+    fno->altname[0] = '\0';
+#endif
+}
+
+static void idx_reset(void)
+{
+    s_count = 0;
+    s_free = IDX_NONE;
+    s_paths_used = 0;
+    memset(s_buckets, 0xff, sizeof(s_buckets));
+    memset(s_writers, 0, sizeof(s_writers));
+    s_hits = 0;
+    s_absent = 0;
+    s_fallbacks = 0;
+}
+
+esp_err_t index_init(void)
+{
+    if (s_mutex == NULL) {
+        s_mutex = xSemaphoreCreateMutex();
+        ESP_RETURN_ON_FALSE(s_mutex, ESP_ERR_NO_MEM, TAG, "no mem for index lock");
+    }
+    return ESP_OK;
+}
+
+esp_err_t safe_fatfs_index_build(BYTE vol)
+{
+    ESP_RETURN_ON_FALSE(s_mutex, ESP_ERR_INVALID_STATE, TAG, "safe_fatfs_init not called");
+    ESP_RETURN_ON_FALSE(vol < FF_VOLUMES, ESP_ERR_INVALID_ARG, TAG, "bad volume %d", vol);
+
+    idx_lock();
+    if (s_entries == NULL) {
+        s_entries = malloc(IDX_MAX_ENTRIES * sizeof(idx_entry_t));
+        s_paths = malloc(IDX_PATH_BYTES);
+    }
+    if (s_entries == NULL || s_paths == NULL) {
+        free(s_entries);
+        free(s_paths);
+        s_entries = NULL;
+        s_paths = NULL;
+        s_state = IDX_OFF;
+        idx_unlock();
+        ESP_LOGE(TAG, "no mem for %d entries", IDX_MAX_ENTRIES);
+        return ESP_ERR_NO_MEM;
+    }
+    idx_reset();
+    s_vol = vol;
+    s_state = IDX_BUILDING;
+    s_gen++;
+    idx_unlock();
+
+    // 广度优先：列出一个目录，把其中的子目录标记为 UNLISTED，再找下一个 UNLISTED 的目录。
+    // 每读一项只短暂持有索引锁，遍历期间其他任务的读写照常进行并同步到索引
+    int64_t start_us = esp_timer_get_time();
+    char path[IDX_PATH_MAX + 3];    // "N:/" + 相对路径
+    char rel[IDX_PATH_MAX];
+    FF_DIR dir;
+    FILINFO fno;
+    FRESULT res = FR_OK;
+    int cur = -1; // 根目录
+    while (res == FR_OK) {
+        idx_lock();
+        if (s_state != IDX_BUILDING) {
+            res = FR_NOT_ENOUGH_CORE;
+        } else {
+            snprintf(path, sizeof(path), "%c:/%s", '0' + vol, cur < 0 ? "" : idx_path(&s_entries[cur]));
+            if (cur >= 0) {
+                s_entries[cur].flags &= ~IDX_FLAG_UNLISTED;
+            }
+        }
+        idx_unlock();
+        if (res != FR_OK) {
+            break;
+        }
+
+        res = safe_f_opendir(&dir, path);
+        if (res != FR_OK) {
+            break;
+        }
+        while ((res = safe_f_readdir(&dir, &fno)) == FR_OK && fno.fname[0] != '\0') {
+            int n = (cur < 0) ? snprintf(rel, sizeof(rel), "%s", fno.fname)
+                              : snprintf(rel, sizeof(rel), "%s/%s", path + 3, fno.fname);
+            if (n < 0 || n >= (int)sizeof(rel)) {
+                res = FR_INVALID_NAME;
+                break;
+            }
+            idx_lock();
+            int i = (s_state == IDX_BUILDING) ? idx_upsert(rel, fno.fsize, fno.fdate, fno.ftime, fno.fattrib) : -1;
+            if (i >= 0 && (fno.fattrib & AM_DIR)) {
+                s_entries[i].flags |= IDX_FLAG_UNLISTED;
+            }
+            idx_unlock();
+            if (i < 0) {
+                res = FR_NOT_ENOUGH_CORE;
+                break;
+            }
+        }
+        safe_f_closedir(&dir);
+
+        idx_lock();
+        cur = -1;
+        for (uint32_t i = 0; i < s_count; i++) {
+            if (!(s_entries[i].flags & IDX_FLAG_FREE) && (s_entries[i].flags & IDX_FLAG_UNLISTED)) {
+                cur = i;
+                break;
+            }
+        }
+        idx_unlock();
+        if (cur < 0) {
+            break;
+        }
+    }
+
+    idx_lock();
+    esp_err_t err = ESP_OK;
+    if (res == FR_OK && s_state == IDX_BUILDING) {
+        s_state = IDX_READY;
+        ESP_LOGI(TAG, "%c: indexed %" PRIu32 " entries, %" PRIu32 " path bytes in %" PRIu32 " ms", '0' + vol,
+                 s_count, s_paths_used, (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+    } else {
+        ESP_LOGW(TAG, "%c: index not built (%s, error %d)", '0' + vol, path, res);
+        s_state = IDX_OFF;
+        s_gen++;
+        err = ESP_FAIL;
+    }
+    idx_unlock();
+    return err;
+}
+
+void safe_fatfs_index_drop(void)
+{
+    idx_lock();
+    s_state = IDX_OFF;
+    s_gen++;
+    free(s_entries);
+    free(s_paths);
+    s_entries = NULL;
+    s_paths = NULL;
+    // 还开着的写文件关闭时不能再访问已释放的条目
+    memset(s_writers, 0, sizeof(s_writers));
+    idx_unlock();
+}
+
+bool index_stat(const TCHAR *path, FILINFO *fno, FRESULT *res)
+{
+    char rel[IDX_PATH_MAX];
+    bool answered = false;
+
+    idx_lock();
+    if (s_state == IDX_READY) {
+        if (idx_normalize(path, rel, sizeof(rel)) && rel[0] != '\0') {
+            int i = idx_find(rel);
+            if (i >= 0) {
+                const idx_entry_t *e = &s_entries[i];
+                if (e->writers == 0 && !(e->flags & IDX_FLAG_REFRESH)) {
+                    if (fno) {
+                        idx_fill(e, fno);
+                    }
+                    *res = FR_OK;
+                    answered = true;
+                    s_hits++;
+                }
+            } else {
+                // 父目录存在时是 FR_NO_FILE，否则和 FatFs 一样是 FR_NO_PATH
+                size_t plen = idx_parent_len(rel);
+                rel[plen] = '\0';
+                int p = (plen > 0) ? idx_find(rel) : -1;
+                *res = (plen == 0 || (p >= 0 && (s_entries[p].attrib & AM_DIR))) ? FR_NO_FILE : FR_NO_PATH;
+                answered = true;
+                s_absent++;
+            }
+        }
+        if (!answered) {
+            s_fallbacks++;
+        }
+    }
+    idx_unlock();
+    return answered;
+}
+
+void index_on_stat(const TCHAR *path, FRESULT res, const FILINFO *fno)
+{
+    char rel[IDX_PATH_MAX];
+
+    idx_lock();
+    if (s_state != IDX_OFF && idx_normalize(path, rel, sizeof(rel)) && rel[0] != '\0') {
+        if (res == FR_OK && fno) {
+            int i = idx_upsert(rel, fno->fsize, fno->fdate, fno->ftime, fno->fattrib);
+            if (i >= 0 && s_entries[i].writers == 0) {
+                s_entries[i].flags &= ~IDX_FLAG_REFRESH;
+            }
+        } else if (res == FR_NO_FILE) {
+            int i = idx_find(rel);
+            if (i >= 0) {
+                idx_remove(i);
+            }
+        }
+    }
+    idx_unlock();
+}
+
+void index_on_open(FIL *fp, const TCHAR *path, BYTE mode)
+{
+    char rel[IDX_PATH_MAX];
+
+    idx_lock();
+    if (s_state != IDX_OFF) {
+        if (!idx_normalize(path, rel, sizeof(rel)) || rel[0] == '\0') {
+            // 可能以短文件名之类的写法创建了索引中没有的文件
+            idx_disable("file created with an unindexed path");
+        } else {
+            int i = idx_find(rel);
+            if (i < 0) {
+                i = idx_upsert(rel, f_size(fp), 0, 0, AM_ARC);
+            }
+            if (i >= 0) {
+                s_entries[i].writers++;
+                s_entries[i].flags |= IDX_FLAG_REFRESH;
+                int w = 0;
+                while (w < IDX_WRITERS && s_writers[w].fp != NULL) {
+                    w++;
+                }
+                if (w < IDX_WRITERS) {
+                    s_writers[w].fp = fp;
+                    s_writers[w].entry = i;
+                } else {
+                    ESP_LOGW(TAG, "too many files open for writing, %s is checked on the card from now on", path);
+                }
+            }
+        }
+    }
+    idx_unlock();
+}
+
+void index_on_close(FIL *fp)
+{
+    idx_lock();
+    if (s_entries == NULL) {
+        idx_unlock();
+        return;
+    }
+    for (int w = 0; w < IDX_WRITERS; w++) {
+        if (s_writers[w].fp == fp) {
+            idx_entry_t *e = &s_entries[s_writers[w].entry];
+            if (e->writers > 0) {
+                e->writers--;
+            }
+            s_writers[w].fp = NULL;
+            break;
+        }
+    }
+    idx_unlock();
+}
+
+void index_on_mkdir(const TCHAR *path)
+{
+    char rel[IDX_PATH_MAX];
+
+    idx_lock();
+    if (s_state != IDX_OFF) {
+        if (!idx_normalize(path, rel, sizeof(rel)) || rel[0] == '\0') {
+            idx_disable("directory created with an unindexed path");
+        } else {
+            int i = idx_upsert(rel, 0, 0, 0, AM_DIR);
+            if (i >= 0) {
+                s_entries[i].flags |= IDX_FLAG_REFRESH; // 修改时间从 TF 卡读取
+            }
+        }
+    }
+    idx_unlock();
+}
+
+void index_on_unlink(const TCHAR *path)
+{
+    char rel[IDX_PATH_MAX];
+
+    idx_lock();
+    if (s_state != IDX_OFF) {
+        if (!idx_normalize(path, rel, sizeof(rel))) {
+            idx_disable("file removed with an unindexed path");
+        } else {
+            int i = idx_find(rel);
+            if (i >= 0) {
+                idx_remove(i); // 只有空目录能被删除，不用处理子项
+            }
+        }
+    }
+    idx_unlock();
+}
+
+/* 改名后的路径写入路径表，重新计算哈希和父目录 */
+static bool idx_move(int i, const char *rel)
+{
+    idx_unlink(i);
+    if (!idx_set_path(&s_entries[i], rel)) {
+        return false;
+    }
+    idx_link(i);
+    return true;
+}
+
+void index_on_rename(const TCHAR *path_old, const TCHAR *path_new)
+{
+    char rel_old[IDX_PATH_MAX];
+    char rel_new[IDX_PATH_MAX];
+    char moved[IDX_PATH_MAX];
+
+    idx_lock();
+    if (s_state == IDX_OFF) {
+        idx_unlock();
+        return;
+    }
+    int i = -1;
+    if (idx_normalize(path_old, rel_old, sizeof(rel_old)) && idx_normalize(path_new, rel_new, sizeof(rel_new))) {
+        i = idx_find(rel_old);
+    }
+    if (i < 0) {
+        idx_disable("renamed an unindexed path");
+        idx_unlock();
+        return;
+    }
+
+    bool is_dir = s_entries[i].attrib & AM_DIR;
+    bool ok = idx_move(i, rel_new);
+    if (ok && is_dir) {
+        // 目录下所有项的路径前缀一起改掉
+        size_t old_len = strlen(rel_old);
+        for (uint32_t j = 0; ok && j < s_count; j++) {
+            const char *p = idx_path(&s_entries[j]);
+            if ((s_entries[j].flags & IDX_FLAG_FREE) || strncasecmp(p, rel_old, old_len) != 0 || p[old_len] != '/') {
+                continue;
+            }
+            int n = snprintf(moved, sizeof(moved), "%s%s", rel_new, p + old_len);
+            if (n < 0 || n >= (int)sizeof(moved)) {
+                idx_disable("renamed path too long");
+                ok = false;
+            } else {
+                ok = idx_move(j, moved);
+            }
+        }
+    }
+    idx_unlock();
+}
+
+bool safe_fatfs_index_opendir(safe_fatfs_index_dir_t *dir, const TCHAR *path)
+{
+    char rel[IDX_PATH_MAX];
+    bool ok = false;
+
+    idx_lock();
+    if (s_state == IDX_READY && idx_normalize(path, rel, sizeof(rel))) {
+        int i = (rel[0] != '\0') ? idx_find(rel) : -1;
+        if (rel[0] == '\0' || (i >= 0 && (s_entries[i].attrib & AM_DIR))) {
+            dir->dir = i;
+            dir->pos = 0;
+            dir->gen = s_gen;
+            ok = true;
+        }
+    }
+    idx_unlock();
+    return ok;
+}
+
+FRESULT safe_fatfs_index_readdir(safe_fatfs_index_dir_t *dir, FILINFO *fno)
+{
+    FRESULT res = FR_OK;
+    fno->fname[0] = '\0';
+
+    idx_lock();
+    if (s_state != IDX_READY || dir->gen != s_gen) {
+        res = FR_INVALID_OBJECT; // 列目录期间索引被丢弃或重建
+    } else {
+        const char *dpath = (dir->dir < 0) ? "" : idx_path(&s_entries[dir->dir]);
+        size_t dlen = strlen(dpath);
+        uint32_t parent = idx_hash(dpath, dlen);
+        while (dir->pos < s_count) {
+            const idx_entry_t *e = &s_entries[dir->pos++];
+            if ((e->flags & IDX_FLAG_FREE) || e->parent != parent) {
+                continue;
+            }
+            const char *p = idx_path(e);
+            if (idx_parent_len(p) == dlen && strncasecmp(p, dpath, dlen) == 0) {
+                idx_fill(e, fno);
+                break;
+            }
+        }
+    }
+    idx_unlock();
+    return res;
+}
+
+void index_dump_stats(void)
+{
+    static const char *const state_names[] = {"off", "building", "ready"};
+
+    idx_lock();
+    ESP_LOGI(TAG, "index %s: %" PRIu32 "/%d entries, %" PRIu32 "/%d path bytes, hit %" PRIu32 " absent %" PRIu32
+             " fallback %" PRIu32, state_names[s_state], s_count, IDX_MAX_ENTRIES, s_paths_used, IDX_PATH_BYTES,
+             s_hits, s_absent, s_fallbacks);
+    idx_unlock();
+}
+
+#else /* CONFIG_SAFE_FATFS_INDEX */
+
+esp_err_t index_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t safe_fatfs_index_build(BYTE vol)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void safe_fatfs_index_drop(void) {}
+
+bool index_stat(const TCHAR *path, FILINFO *fno, FRESULT *res)
+{
+    return false;
+}
+
+void index_on_stat(const TCHAR *path, FRESULT res, const FILINFO *fno) {}
+void index_on_open(FIL *fp, const TCHAR *path, BYTE mode) {}
+void index_on_close(FIL *fp) {}
+void index_on_mkdir(const TCHAR *path) {}
+void index_on_unlink(const TCHAR *path) {}
+void index_on_rename(const TCHAR *path_old, const TCHAR *path_new) {}
+
+bool safe_fatfs_index_opendir(safe_fatfs_index_dir_t *dir, const TCHAR *path)
+{
+    return false;
+}
+
+FRESULT safe_fatfs_index_readdir(safe_fatfs_index_dir_t *dir, FILINFO *fno)
+{
+    fno->fname[0] = '\0';
+    return FR_INVALID_OBJECT;
+}
+
+void index_dump_stats(void) {}
+
+#endif /* CONFIG_SAFE_FATFS_INDEX */
@@ -0,0 +1,34 @@
+// safe_fatfs_index.h
+//
+// 目录索引和 safe_fatfs.c 之间的内部接口，不对组件外公开。
+// index_on_* 在持有卷锁时调用，和卡上的修改顺序一致；index_stat 不需要卷锁。
+// 加锁顺序总是先卷锁后索引锁，索引锁内不调用 safe_f_*。
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "ff.h"
+
+esp_err_t index_init(void);
+
+/*
+ * 用索引回答 f_stat。返回 true 时 *res 是 FR_OK / FR_NO_FILE / FR_NO_PATH，
+ * 返回 false 表示索引不能确定 (没有建立、路径写法特殊、文件正在被写)，调用者应该访问 TF 卡。
+ */
+bool index_stat(const TCHAR *path, FILINFO *fno, FRESULT *res);
+
+/* 访问 TF 卡得到的 f_stat 结果写回索引：FR_OK 时更新这一项，FR_NO_FILE 时删除 */
+void index_on_stat(const TCHAR *path, FRESULT res, const FILINFO *fno);
+
+/* 以写入或创建方式打开成功 */
+void index_on_open(FIL *fp, const TCHAR *path, BYTE mode);
+
+/* 关闭文件 (无论 f_close 是否成功) */
+void index_on_close(FIL *fp);
+
+void index_on_mkdir(const TCHAR *path);
+void index_on_unlink(const TCHAR *path);
+void index_on_rename(const TCHAR *path_old, const TCHAR *path_new);
+
+void index_dump_stats(void);
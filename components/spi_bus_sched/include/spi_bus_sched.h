@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 共享 SPI 总线 (SPI2_HOST) 上的客户端，数值越小优先级越高
+ */
+typedef enum {
+    SPI_BUS_CLIENT_LCD = 0,     // ST7789V3 显示屏，高优先级
+    SPI_BUS_CLIENT_SD,          // TF 卡 (FatFs)，低优先级，按块传输
+    SPI_BUS_CLIENT_MAX,
+} spi_bus_client_t;
+
+/**
+ * @brief 单个客户端的总线使用统计
+ */
+typedef struct {
+    uint32_t acquire_count;     // 成功获取总线的次数
+    uint32_t contended_count;   // 获取时总线已被占用、需要等待的次数
+    uint32_t yield_count;       // 在块边界把总线让给高优先级客户端的次数
+    uint32_t timeout_count;     // 获取超时的次数
+    uint64_t total_wait_us;     // 累计等待时间
+    uint32_t max_wait_us;       // 单次最长等待时间
+} spi_bus_sched_stats_t;
+
+/**
+ * @brief 初始化总线调度器，必须在任何客户端访问总线之前调用
+ */
+esp_err_t spi_bus_sched_init(void);
+
+/**
+ * @brief 获取总线
+ *
+ * 低优先级客户端在有高优先级客户端等待时不会抢占总线。
+ *
+ * @param client 客户端
+ * @param timeout 最长等待时间 (tick)，portMAX_DELAY 表示一直等待
+ * @return true 获取成功，false 超时
+ */
+bool spi_bus_sched_acquire(spi_bus_client_t client, TickType_t timeout);
+
+/**
+ * @brief 释放总线
+ */
+void spi_bus_sched_release(spi_bus_client_t client);
+
+/**
+ * @brief 在传输块边界调用：如果有更高优先级的客户端在等待，先把总线交给它，
+ *        等它用完后再重新获取。调用者必须已经持有总线。
+ */
+void spi_bus_sched_yield(spi_bus_client_t client);
+
+/**
+ * @brief SD 传输的分块大小 (字节)
+ */
+size_t spi_bus_sched_sd_chunk_size(void);
+
+/**
+ * @brief 读取某个客户端的统计数据
+ */
+void spi_bus_sched_get_stats(spi_bus_client_t client, spi_bus_sched_stats_t *out_stats);
+
+/**
+ * @brief 清零所有客户端的统计数据
+ */
+void spi_bus_sched_reset_stats(void);
+
+/**
+ * @brief 把所有客户端的统计数据打印到日志
+ */
+void spi_bus_sched_dump_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,226 @@
+// spi_bus_sched.c
+//
+// 显示屏和 TF 卡共用 SPI2_HOST。以前所有访问都串行在一个全局 spi_mutex 上，
+// 一次大的 f_read 会在整个读取期间挡住显示刷新。
+// 这里改成带优先级的调度：
+//   - 每个客户端有自己的等待计数，低优先级客户端在有高优先级客户端等待时不去抢总线；
+//   - SD 传输被 safe_fatfs 切成小块，每块之间调用 spi_bus_sched_yield()，
+//     让等待中的显示事务先执行；
+//   - 记录每个客户端的等待时间，便于评估 UI 帧时间受 SD 访问影响的程度。
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+#include "spi_bus_sched.h"
+
+static const char *TAG = "spi_bus_sched";
+
+// 事件组中第 n 位置位表示客户端 n 当前没有任务在等待总线
+#define CLIENT_IDLE_BIT(c)      (1u << (c))
+#define CLIENTS_ABOVE(c)        (CLIENT_IDLE_BIT(c) - 1u)
+
+static SemaphoreHandle_t s_bus_mutex;       // 真正的总线锁
+static SemaphoreHandle_t s_state_mutex;     // 保护等待计数和统计数据
+static EventGroupHandle_t s_idle_events;
+static uint32_t s_waiting[SPI_BUS_CLIENT_MAX];
+static spi_bus_sched_stats_t s_stats[SPI_BUS_CLIENT_MAX];
+
+static const char *const s_client_names[SPI_BUS_CLIENT_MAX] = {
+    [SPI_BUS_CLIENT_LCD] = "LCD",
+    [SPI_BUS_CLIENT_SD] = "SD",
+};
+
+#if CONFIG_SPI_BUS_SCHED_STATS_PERIOD_S > 0
+static esp_timer_handle_t s_stats_timer;
+
+static void stats_timer_cb(void *arg)
+{
+    spi_bus_sched_dump_stats();
+}
+#endif
+
+esp_err_t spi_bus_sched_init(void)
+{
+    // 防止重复初始化
+    if (s_bus_mutex) {
+        return ESP_OK;
+    }
+
+    s_bus_mutex = xSemaphoreCreateMutex();
+    s_state_mutex = xSemaphoreCreateMutex();
+    s_idle_events = xEventGroupCreate();
+    ESP_RETURN_ON_FALSE(s_bus_mutex && s_state_mutex && s_idle_events, ESP_ERR_NO_MEM, TAG, "no mem for bus scheduler");
+
+    memset(s_waiting, 0, sizeof(s_waiting));
+    memset(s_stats, 0, sizeof(s_stats));
+    xEventGroupSetBits(s_idle_events, CLIENT_IDLE_BIT(SPI_BUS_CLIENT_MAX) - 1u);
+
+#if CONFIG_SPI_BUS_SCHED_STATS_PERIOD_S > 0
+    const esp_timer_create_args_t timer_args = {
+        .callback = stats_timer_cb,
+        .name = "bus_stats",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &s_stats_timer), TAG, "create stats timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_start_periodic(s_stats_timer, CONFIG_SPI_BUS_SCHED_STATS_PERIOD_S * 1000000ULL),
+                        TAG, "start stats timer failed");
+#endif
+
+    return ESP_OK;
+}
+
+static void waiting_inc(spi_bus_client_t client)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (s_waiting[client]++ == 0) {
+        xEventGroupClearBits(s_idle_events, CLIENT_IDLE_BIT(client));
+    }
+    xSemaphoreGive(s_state_mutex);
+}
+
+static void waiting_dec(spi_bus_client_t client)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    if (--s_waiting[client] == 0) {
+        xEventGroupSetBits(s_idle_events, CLIENT_IDLE_BIT(client));
+    }
+    xSemaphoreGive(s_state_mutex);
+}
+
+// 剩余的超时时间 (tick)
+static TickType_t remaining_ticks(TickType_t timeout, TickType_t start)
+{
+    if (timeout == portMAX_DELAY) {
+        return portMAX_DELAY;
+    }
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    return (elapsed >= timeout) ? 0 : timeout - elapsed;
+}
+
+// 等待所有更高优先级的客户端都没有任务在排队
+static bool wait_higher_idle(spi_bus_client_t client, TickType_t timeout)
+{
+    EventBits_t mask = CLIENTS_ABOVE(client);
+    if (mask == 0) {
+        return true;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_idle_events, mask, pdFALSE, pdTRUE, timeout);
+    return (bits & mask) == mask;
+}
+
+static void record_wait(spi_bus_client_t client, bool acquired, bool contended, int64_t wait_us)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    spi_bus_sched_stats_t *st = &s_stats[client];
+    if (acquired) {
+        st->acquire_count++;
+        st->total_wait_us += wait_us;
+        if (wait_us > st->max_wait_us) {
+            st->max_wait_us = (uint32_t)wait_us;
+        }
+    } else {
+        st->timeout_count++;
+    }
+    if (contended) {
+        st->contended_count++;
+    }
+    xSemaphoreGive(s_state_mutex);
+}
+
+bool spi_bus_sched_acquire(spi_bus_client_t client, TickType_t timeout)
+{
+    assert(s_bus_mutex && client < SPI_BUS_CLIENT_MAX);
+
+    // 快速路径：没有更高优先级的等待者且总线空闲
+    if ((xEventGroupGetBits(s_idle_events) & CLIENTS_ABOVE(client)) == CLIENTS_ABOVE(client) &&
+        xSemaphoreTake(s_bus_mutex, 0) == pdTRUE) {
+        record_wait(client, true, false, 0);
+        return true;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    TickType_t start_tick = xTaskGetTickCount();
+    bool acquired = false;
+
+    waiting_inc(client);
+    if (wait_higher_idle(client, timeout)) {
+        acquired = xSemaphoreTake(s_bus_mutex, remaining_ticks(timeout, start_tick)) == pdTRUE;
+    }
+    waiting_dec(client);
+
+    record_wait(client, acquired, true, esp_timer_get_time() - start_us);
+    if (!acquired) {
+        ESP_LOGW(TAG, "%s: acquire bus timed out", s_client_names[client]);
+    }
+    return acquired;
+}
+
+void spi_bus_sched_release(spi_bus_client_t client)
+{
+    assert(s_bus_mutex && client < SPI_BUS_CLIENT_MAX);
+    xSemaphoreGive(s_bus_mutex);
+}
+
+void spi_bus_sched_yield(spi_bus_client_t client)
+{
+    assert(s_bus_mutex && client < SPI_BUS_CLIENT_MAX);
+
+    EventBits_t mask = CLIENTS_ABOVE(client);
+    if ((xEventGroupGetBits(s_idle_events) & mask) == mask) {
+        return;
+    }
+
+    // 有高优先级客户端在等待：交出总线，等它们全部处理完再拿回来
+    xSemaphoreGive(s_bus_mutex);
+    int64_t start_us = esp_timer_get_time();
+    wait_higher_idle(client, portMAX_DELAY);
+    xSemaphoreTake(s_bus_mutex, portMAX_DELAY);
+    int64_t wait_us = esp_timer_get_time() - start_us;
+
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    spi_bus_sched_stats_t *st = &s_stats[client];
+    st->yield_count++;
+    st->total_wait_us += wait_us;
+    if (wait_us > st->max_wait_us) {
+        st->max_wait_us = (uint32_t)wait_us;
+    }
+    xSemaphoreGive(s_state_mutex);
+}
+
+size_t spi_bus_sched_sd_chunk_size(void)
+{
+    return CONFIG_SPI_BUS_SCHED_SD_CHUNK_SIZE;
+}
+
+void spi_bus_sched_get_stats(spi_bus_client_t client, spi_bus_sched_stats_t *out_stats)
+{
+    assert(client < SPI_BUS_CLIENT_MAX && out_stats);
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    *out_stats = s_stats[client];
+    xSemaphoreGive(s_state_mutex);
+}
+
+void spi_bus_sched_reset_stats(void)
+{
+    xSemaphoreTake(s_state_mutex, portMAX_DELAY);
+    memset(s_stats, 0, sizeof(s_stats));
+    xSemaphoreGive(s_state_mutex);
+}
+
+void spi_bus_sched_dump_stats(void)
+{
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        spi_bus_sched_stats_t st;
+        spi_bus_sched_get_stats(i, &st);
+        uint32_t avg_us = st.acquire_count ? (uint32_t)(st.total_wait_us / st.acquire_count) : 0;
+        ESP_LOGI(TAG, "%-3s acquire=%" PRIu32 " contended=%" PRIu32 " yield=%" PRIu32 " timeout=%" PRIu32
+                 " wait avg=%" PRIu32 "us max=%" PRIu32 "us",
+                 s_client_names[i], st.acquire_count, st.contended_count, st.yield_count,
+                 st.timeout_count, avg_us, st.max_wait_us);
+    }
+}
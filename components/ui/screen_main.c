@@ -1,5 +1,10 @@
 #include "lvgl.h"
 #include "controller.h"
+#include "assets.h"
+#include "lv_port_storage.h"
+#include "lv_port_fs.h"
+
+#define BACKGROUND_SD_PATH "A:/sdcard/Chie_240.bin"
 // #include "lv_qrcode.h"
 
 static lv_obj_t * main_scr;   // 主界面对象
@@ -113,6 +118,20 @@ static void ota_update_event_cb(lv_event_t * e)
     }
 }
 
+static void background_sd_ready_cb(bool mounted, void * user_data)
+{
+    if (!mounted) {
+        return;
+    }
+    // 卡上没有这个文件时不设置图片，背景保持为空；有时由 lv_port_img_dec 解码
+    uint32_t stamp, size;
+    if (!lv_port_fs_file_info(BACKGROUND_SD_PATH, &stamp, &size)) {
+        LV_LOG_WARN("%s not found on the SD card", BACKGROUND_SD_PATH);
+        return;
+    }
+    lv_img_set_src((lv_obj_t *)user_data, BACKGROUND_SD_PATH);
+}
+
 void create_main_screen(void)
 {
     main_scr = lv_obj_create(NULL);
@@ -122,8 +141,14 @@ void create_main_screen(void)
     // 1. 创建一个图像对象
     lv_obj_t * background_img = lv_img_create(main_scr);
 
-    // 2. 设置图像的来源
-    lv_img_set_src(background_img, "A:/sdcard/Chie_240.bin");
+    // 2. 设置图像的来源：优先使用 assets 分区中映射的图片，没有时再从 TF 卡读取
+    const lv_img_dsc_t *background = assets_get_img("Chie_240");
+    if (background) {
+        lv_img_set_src(background_img, background);
+    } else {
+        // TF 卡的目录索引在后台建立，完成后再设置图片，界面先不带背景显示
+        lv_port_storage_when_ready(LV_PORT_STORAGE_SD, background_sd_ready_cb, background_img);
+    }
 
     // 3. 将图片在屏幕上居中显示
     lv_obj_align(background_img, LV_ALIGN_CENTER, 0, 0);
@@ -3,11 +3,15 @@
 #include "esp_http_client.h"
 #include "esp_log.h"
 #include "safe_fatfs.h" // 假设这是您的线程安全文件系统接口
+#include "sdkconfig.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "web_download";
 
+// 写缓冲按整扇区取整，每次写入都从扇区边界开始、覆盖整数个扇区
+#define WRITE_BUF_SIZE ((CONFIG_WEB_DOWNLOAD_WRITE_BUF_KB * 1024) / FF_MAX_SS * FF_MAX_SS)
+
 // --- 服务器和文件系统配置 ---
 static const char *BASE_REQUEST_URL = "http://idolc3.cjiax.top:34611/request_file/";
 static const char *BASE_OTA_URL = "http://idolc3.cjiax.top:34611/ota";
@@ -23,12 +27,19 @@ typedef struct {
     char *output_path_buffer;           // 指向外部提供的、用于存储最终文件路径的缓冲区
     size_t output_path_buffer_size;     // 缓冲区大小
     bool header_processed;              // 标记是否已成功处理了响应头并打开了文件
+    uint8_t *write_buf;                 // 写缓冲，为 NULL 时每个数据块直接写入
+    size_t write_len;                   // 写缓冲中还没写入文件的字节数
+    size_t written;                     // 已经收到的文件字节数 (包括写缓冲中的部分)
+    bool expanded;                      // 文件已按 Content-Length 预分配
 } download_context_t;
 
 // 函数声明
 static esp_err_t web_download_from_url(const char *url, char *out_file_path, size_t path_buffer_size, int *out_http_status_code);
 static esp_err_t _http_event_handler(esp_http_client_event_t *evt);
 static esp_err_t parse_filename_from_header(const char *header_value, char *out_filename, size_t max_len);
+static bool download_write(download_context_t *ctx, const void *data, size_t len);
+static bool download_flush(download_context_t *ctx);
+static void download_close_file(download_context_t *ctx);
 
 
 /**
@@ -64,6 +75,78 @@ static esp_err_t parse_filename_from_header(const char *header_value, char *out_
     return ESP_OK;
 }
 
+/**
+ * @brief 把写缓冲中的数据写入文件
+ */
+static bool download_flush(download_context_t *ctx)
+{
+    if (ctx->write_len == 0) {
+        return true;
+    }
+    UINT bytes_written = 0;
+    FRESULT res = safe_f_write(ctx->fp, ctx->write_buf, ctx->write_len, &bytes_written);
+    bool ok = (res == FR_OK && bytes_written == ctx->write_len);
+    ctx->write_len = 0;
+    if (!ok) {
+        ESP_LOGE(TAG, "File write error %d", res);
+    }
+    return ok;
+}
+
+/**
+ * @brief 收到的数据先放进写缓冲，缓冲满了才写入文件
+ */
+static bool download_write(download_context_t *ctx, const void *data, size_t len)
+{
+    ctx->written += len;
+    if (ctx->write_buf == NULL) {
+        UINT bytes_written = 0;
+        if (safe_f_write(ctx->fp, data, len, &bytes_written) != FR_OK || bytes_written != len) {
+            ESP_LOGE(TAG, "File write error");
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t *src = data;
+    while (len > 0) {
+        size_t n = WRITE_BUF_SIZE - ctx->write_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(ctx->write_buf + ctx->write_len, src, n);
+        ctx->write_len += n;
+        src += n;
+        len -= n;
+        if (ctx->write_len == WRITE_BUF_SIZE && !download_flush(ctx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 写入剩余数据并关闭文件
+ *
+ * 预分配的大小和实际收到的不一致时 (连接中断或服务器少发)，把文件截断到实际长度。
+ */
+static void download_close_file(download_context_t *ctx)
+{
+    if (ctx->fp) {
+        download_flush(ctx);
+        if (ctx->expanded && safe_f_size(ctx->fp) != ctx->written) {
+            ESP_LOGW(TAG, "Received %u bytes, truncating preallocated file", (unsigned)ctx->written);
+            safe_f_truncate(ctx->fp);
+        }
+        safe_f_close(ctx->fp);
+        free(ctx->fp);
+        ctx->fp = NULL;
+    }
+    free(ctx->write_buf);
+    ctx->write_buf = NULL;
+    ctx->write_len = 0;
+}
+
 /**
  * @brief 核心HTTP事件处理函数
  */
@@ -75,11 +158,7 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
     switch (evt->event_id) {
         case HTTP_EVENT_ERROR:
             ESP_LOGE(TAG, "HTTP_EVENT_ERROR");
-            if (ctx->fp) {
-                safe_f_close(ctx->fp);
-                free(ctx->fp);
-                ctx->fp = NULL;
-            }
+            download_close_file(ctx);
             return ESP_FAIL;
 
         case HTTP_EVENT_ON_CONNECTED:
@@ -109,6 +188,14 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
                         return ESP_FAIL;
                     }
                     ctx->header_processed = true;
+                    ctx->written = 0;
+                    ctx->expanded = false;
+#if WRITE_BUF_SIZE > 0
+                    ctx->write_buf = malloc(WRITE_BUF_SIZE);
+                    if (!ctx->write_buf) {
+                        ESP_LOGW(TAG, "No memory for write buffer, writing chunks directly");
+                    }
+#endif
                 } else {
                     return ESP_FAIL;
                 }
@@ -122,9 +209,19 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
                 ESP_LOGE(TAG, "Received data but file is not open!");
                 return ESP_FAIL;
             }
-            UINT bytes_written = 0;
-            if (safe_f_write(ctx->fp, evt->data, evt->data_len, &bytes_written) != FR_OK || bytes_written != evt->data_len) {
-                ESP_LOGE(TAG, "File write error");
+            if (ctx->written == 0) {
+                // 响应头都已收到，长度已知时一次分配连续的簇，写入时不再逐簇查找空闲簇、更新 FAT
+                int64_t content_length = esp_http_client_get_content_length(evt->client);
+                if (content_length > 0) {
+                    FRESULT res = safe_f_expand(ctx->fp, (FSIZE_t)content_length, 1);
+                    if (res == FR_OK) {
+                        ctx->expanded = true;
+                    } else {
+                        ESP_LOGW(TAG, "Preallocating %lld bytes failed (%d), file may be fragmented", content_length, res);
+                    }
+                }
+            }
+            if (!download_write(ctx, evt->data, evt->data_len)) {
                 return ESP_FAIL;
             }
             break;
@@ -133,9 +230,7 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
             ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
             if (ctx->fp) {
                 ESP_LOGI(TAG, "File download finished. Closing file.");
-                safe_f_close(ctx->fp);
-                free(ctx->fp);
-                ctx->fp = NULL;
+                download_close_file(ctx);
             }
             break;
 
@@ -143,9 +238,7 @@ static esp_err_t _http_event_handler(esp_http_client_event_t *evt)
             ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
             if (ctx->fp) {
                 ESP_LOGW(TAG, "Disconnected unexpectedly, closing file.");
-                safe_f_close(ctx->fp);
-                free(ctx->fp);
-                ctx->fp = NULL;
+                download_close_file(ctx);
             }
             break;
 
@@ -188,6 +281,7 @@ static esp_err_t web_download_from_url(const char *url, char *out_file_path, siz
     }
 
     esp_http_client_cleanup(client);
+    download_close_file(ctx); // perform 出错返回时可能还没有收到 FINISH/DISCONNECTED 事件
     free(ctx);
 
     return err;
@@ -14,19 +14,18 @@
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
-#include "esp_lvgl_port.h"
 #include "esp_lcd_st7789v3.h"
-#include "esp_littlefs.h"
 #include "esp_task_wdt.h"
 #include "lv_port_tick.h"
 #include "sht40.h"
 #include "esp_app_desc.h"
 #include "esp_app_format.h"
+#include "spi_bus_sched.h"
+#include "safe_fatfs.h"
+#include "assets.h"
 
 static char *TAG = "main";
 
-SemaphoreHandle_t spi_mutex;
-
 void app_main(void)
 {
 
@@ -41,30 +40,15 @@ void app_main(void)
     }
 
 
-    spi_mutex = xSemaphoreCreateMutex();
-
-    ESP_LOGI(TAG, "Initializing LittleFS");
-
-    esp_vfs_littlefs_conf_t conf = {
-        .base_path = "/littlefs",
-        .partition_label = "storage",
-        .format_if_mount_failed = true,
-        .dont_mount = false,
-    };
-
-    // Use settings defined above to initialize and mount LittleFS filesystem.
-    // Note: esp_vfs_littlefs_register is an all-in-one convenience function.
-    esp_err_t ret = esp_vfs_littlefs_register(&conf);
+    // LCD 和 TF 卡共用 SPI2_HOST，由总线调度器统一仲裁
+    ESP_ERROR_CHECK(spi_bus_sched_init());
+    // TF 卡的卷锁，必须在 app_lcd_init 挂载 TF 卡之前创建
+    ESP_ERROR_CHECK(safe_fatfs_init());
+    // LittleFS 和 TF 卡目录索引由 lvgl_task 启动的后台任务处理 (lv_port_storage.c)，不再推迟第一帧
 
-    if (ret != ESP_OK) {
-        if (ret == ESP_FAIL) {
-            ESP_LOGE(TAG, "Failed to mount or format filesystem");
-        } else if (ret == ESP_ERR_NOT_FOUND) {
-            ESP_LOGE(TAG, "Failed to find LittleFS partition");
-        } else {
-            ESP_LOGE(TAG, "Failed to initialize LittleFS (%s)", esp_err_to_name(ret));
-        }
-        return;
+    // assets 分区中的图片直接从 flash 映射，失败时界面退回到从 TF 卡读取
+    if (assets_init() != ESP_OK) {
+        ESP_LOGW(TAG, "assets partition unavailable, images come from the SD card");
     }
 
     printf("TEST ESP LVGL port\n\r");
@@ -1,8 +1,12 @@
 #!/usr/bin/env python3
 import os
+import json
+import hashlib
 import logging
 import argparse
 import subprocess
+import multiprocessing
+from functools import partial
 from os import path
 from enum import Enum
 from typing import List
@@ -18,6 +22,12 @@ try:
 except ImportError:
     raise ImportError("Need lz4 package, do `pip3 install lz4`")
 
+try:
+    import numpy as np
+except ImportError:
+    # optional, without numpy every pixel goes through the python loops below
+    np = None
+
 
 def uint8_t(val) -> bytes:
     return val.to_bytes(1, byteorder='little')
@@ -218,6 +228,9 @@ def unpack_colors(data: bytes, cf: ColorFormat, w) -> List:
     Unpack lvgl 1/2/4/8/16/32 bpp color to png color: alpha map, grey scale,
     or R,G,B,(A) map
     """
+    if np is not None and w > 0:
+        return _unpack_colors_np(data, cf, w)
+
     ret = []
     bpp = cf.bpp
     if bpp == 8:
@@ -314,6 +327,97 @@ def unpack_colors(data: bytes, cf: ColorFormat, w) -> List:
     return ret
 
 
+def _bit_extend_lut(bpp):
+    return np.array([bit_extend(v, bpp) for v in range(1 << bpp)],
+                    dtype=np.uint8)
+
+
+def _pack_bits(values, bpp) -> bytes:
+    """
+    Pack a (h, w) array of 1/2/4 bit values MSB first, each row padded to
+    whole bytes, the same as png.pack_rows
+    """
+    ppb = 8 // bpp
+    h, w = values.shape
+    values = np.pad(values.astype(np.uint8), ((0, 0), (0, -w % ppb)))
+    shifts = np.arange(ppb - 1, -1, -1, dtype=np.uint8) * bpp
+    packed = np.bitwise_or.reduce(values.reshape(h, -1, ppb) << shifts, axis=2)
+    return packed.astype(np.uint8).tobytes()
+
+
+def _unpack_bits(data, bpp, w):
+    """
+    Unpack rows of 1/2/4 bit values, dropping the padding bits of each row
+    """
+    ppb = 8 // bpp
+    stride = (w * bpp + 7) // 8
+    rows = np.frombuffer(bytes(data), dtype=np.uint8)
+    rows = rows[:len(rows) // stride * stride].reshape(-1, stride)
+    shifts = np.arange(ppb - 1, -1, -1, dtype=np.uint8) * bpp
+    values = (rows[:, :, None] >> shifts) & ((1 << bpp) - 1)
+    return values.reshape(len(rows), -1)[:, :w]
+
+
+def _unpack_rgb565(pixels):
+    r = _bit_extend_lut(5)[(pixels >> 11) & 0x1f]
+    g = _bit_extend_lut(6)[(pixels >> 5) & 0x3f]
+    b = _bit_extend_lut(5)[(pixels >> 0) & 0x1f]
+    return r, g, b
+
+
+def _unpack_colors_np(data: bytes, cf: ColorFormat, w) -> bytearray:
+    """
+    numpy version of unpack_colors, returns the same values as a bytearray
+    """
+    bpp = cf.bpp
+    raw = np.frombuffer(bytes(data), dtype=np.uint8)
+    if bpp == 8:
+        return bytearray(raw.tobytes())
+    elif bpp < 8:
+        values = _unpack_bits(raw, bpp, w)
+        if cf.is_alpha_only:
+            values = values * (255 // ((1 << bpp) - 1))
+        planes = [values]
+    elif bpp == 16:
+        pixels = raw[:len(raw) // 2 * 2].view('<u2')
+        planes = _unpack_rgb565(pixels)
+    elif cf == ColorFormat.RGB888:
+        raw = raw[:len(raw) // 3 * 3].reshape(-1, 3)
+        planes = [raw[:, 2], raw[:, 1], raw[:, 0]]
+    elif cf == ColorFormat.RGB565A8:
+        alpha_size = len(raw) // 3
+        alpha = raw[len(raw) - alpha_size:]
+        pixels = raw[:len(raw) - alpha_size]
+        pixels = pixels[:len(pixels) // 2 * 2].view('<u2')
+        n = min(len(alpha), len(pixels))
+        planes = [*_unpack_rgb565(pixels[:n]), alpha[:n]]
+    elif cf == ColorFormat.ARGB8565:
+        raw = raw[:len(raw) // 3 * 3].reshape(-1, 3)
+        pixels = raw[:, 0].astype(np.uint16) | (raw[:, 1].astype(np.uint16) << 8)
+        planes = [*_unpack_rgb565(pixels), raw[:, 2]]
+    elif bpp == 32:
+        raw = raw[:len(raw) // 4 * 4].reshape(-1, 4).astype(np.uint32)
+        b, g, r, a = raw[:, 0], raw[:, 1], raw[:, 2], raw[:, 3]
+        if cf == ColorFormat.ARGB8888_PREMULTIPLIED:
+            r, g, b = r * a // 255, g * a // 255, b * a // 255
+        planes = [r, g, b, a]
+    else:
+        assert 0
+
+    out = np.stack([np.asarray(p).reshape(-1) for p in planes], axis=-1)
+    return bytearray(out.astype(np.uint8).tobytes())
+
+
+def _read_rgba8(filename):
+    """
+    Read png as an (h, w, 4) uint8 RGBA array
+    """
+    reader = png.Reader(str(filename))
+    w, h, rows, info = reader.asRGBA8()
+    px = np.frombuffer(b''.join(bytes(row) for row in rows), dtype=np.uint8)
+    return w, h, px.reshape(h, w, 4), info
+
+
 def write_c_array_file(
         w: int, h: int,
         stride: int,
@@ -596,6 +700,13 @@ class LVGLImage:
         if not self.cf.has_alpha:
             raise ParameterError(f"Image has no alpha channel: {self.cf.name}")
 
+        if np is not None and self.cf in (ColorFormat.ARGB8888,
+                                          ColorFormat.RGB565A8,
+                                          ColorFormat.ARGB8565):
+            self._premultiply_np()
+            self.premultiplied = True
+            return
+
         if self.cf.is_indexed:
 
             def multiply(r, g, b, a):
@@ -677,6 +788,38 @@ class LVGLImage:
 
         self.premultiplied = True
 
+    def _premultiply_np(self):
+        """
+        numpy version of premultiply for the pixel formats, same rounding
+        """
+        w, h, stride = self.w, self.h, self.stride
+        data = np.frombuffer(bytes(self.data), dtype=np.uint8).copy()
+        rows = data[:h * stride].reshape(h, stride)
+
+        if self.cf is ColorFormat.ARGB8888:
+            px = rows[:, :w * 4].reshape(h, w, 4).astype(np.uint32)
+            px[..., :3] = (px[..., :3] * px[..., 3:]) >> 8
+            rows[:, :w * 4] = px.reshape(h, w * 4)
+        else:
+            if self.cf is ColorFormat.RGB565A8:
+                step = 2
+                a = data[h * stride:].reshape(h, stride // 2)[:, :w]
+            else:  # ARGB8565
+                step = 3
+                a = rows[:, 2:w * 3:3]
+            a = a.astype(np.uint32)
+            lo = rows[:, 0:w * step:step]
+            hi = rows[:, 1:w * step:step]
+            color = lo.astype(np.uint32) | (hi.astype(np.uint32) << 8)
+            r = ((color >> 11) & 0x1f) * a // 255
+            g = ((color >> 5) & 0x3f) * a // 255
+            b = ((color >> 0) & 0x1f) * a // 255
+            color = (r << 11) | (g << 5) | (b << 0)
+            rows[:, 0:w * step:step] = color & 0xff
+            rows[:, 1:w * step:step] = color >> 8
+
+        self.data = bytearray(data.tobytes())
+
     @property
     def data_len(self) -> int:
         """
@@ -823,9 +966,14 @@ class LVGLImage:
         elif self.cf.is_alpha_only:
             # separate packed data to plain data
             transparency = unpack_colors(self.data, self.cf, self.w)
-            data = []
-            for a in transparency:
-                data += [0, 0, 0, a]
+            if np is not None:
+                data = np.zeros((len(transparency), 4), dtype=np.uint8)
+                data[:, 3] = np.frombuffer(bytes(transparency), dtype=np.uint8)
+                data = bytearray(data.tobytes())
+            else:
+                data = []
+                for a in transparency:
+                    data += [0, 0, 0, a]
             encoder = png.Writer(self.w, self.h, greyscale=False, alpha=True)
         elif self.cf == ColorFormat.L8:
             # to grayscale
@@ -937,6 +1085,9 @@ class LVGLImage:
                 if self.nema_gfx:
                     e = bytearray((x >> 4) | ((x & 0x0F) << 4) for x in e)
                 rawdata += e
+        elif np is not None:
+            rows = np.array([list(e) for e in rows], dtype=np.uint8).reshape(h, w)
+            rawdata += _pack_bits(rows, cf.bpp)
         else:
             for e in png.pack_rows(rows, cf.bpp):
                 rawdata += e
@@ -944,6 +1095,18 @@ class LVGLImage:
         self.set_data(cf, w, h, rawdata)
 
     def _png_to_alpha_only(self, cf: ColorFormat, filename: str):
+        if np is not None:
+            w, h, px, info = _read_rgba8(filename)
+            if not info['alpha']:
+                raise FormatError(f"{filename} has no alpha channel")
+            a = px[..., 3]
+            if cf == ColorFormat.A8:
+                rawdata = bytearray(a.tobytes())
+            else:
+                rawdata = bytearray(_pack_bits(a >> (8 - cf.bpp), cf.bpp))
+            self.set_data(cf, w, h, rawdata)
+            return
+
         reader = png.Reader(str(filename))
         w, h, rows, info = reader.asRGBA8()
         if not info['alpha']:
@@ -975,6 +1138,22 @@ class LVGLImage:
         return 1.055 * pow(y, 1 / 2.4) - 0.055
 
     def _png_to_luma_only(self, cf: ColorFormat, filename: str):
+        if np is not None:
+            w, h, px, _ = _read_rgba8(filename)
+            px = px.astype(np.uint32)
+            r, g, b, a = color_pre_multiply(px[..., 0], px[..., 1], px[..., 2],
+                                            px[..., 3], self.background)
+            # gamma curves go through the python functions, a lut for the
+            # 256 inputs and once per distinct luma, so every float matches
+            lut = np.array([self.sRGB_to_linear(v / 255.0) for v in range(256)])
+            luma = 0.2126 * lut[r] + 0.7152 * lut[g] + 0.0722 * lut[b]
+            values, inverse = np.unique(luma, return_inverse=True)
+            l8 = np.array([int(self.linear_to_sRGB(float(y)) * 255) for y in values],
+                          dtype=np.uint8)
+            self.set_data(ColorFormat.L8, w, h,
+                          bytearray(l8[inverse.reshape(-1)].tobytes()))
+            return
+
         reader = png.Reader(str(filename))
         w, h, rows, info = reader.asRGBA8()
         rawdata = bytearray()
@@ -1045,6 +1224,10 @@ class LVGLImage:
         else:
             raise FormatError(f"Invalid color format: {cf.name}")
 
+        if np is not None:
+            self._png_to_colormap_np(cf, filename)
+            return
+
         reader = png.Reader(str(filename))
         w, h, rows, _ = reader.asRGBA8()
         rawdata = bytearray()
@@ -1075,6 +1258,48 @@ class LVGLImage:
 
         self.set_data(cf, w, h, rawdata)
 
+    def _png_to_colormap_np(self, cf, filename: str):
+        """
+        numpy version of _png_to_colormap, each pack() applied to whole planes
+        """
+        w, h, px, _ = _read_rgba8(filename)
+        px = px.astype(np.uint32)
+        r, g, b, a = px[..., 0], px[..., 1], px[..., 2], px[..., 3]
+
+        if (
+            self.rgb565_dither and
+            cf in (ColorFormat.RGB565, ColorFormat.RGB565A8, ColorFormat.ARGB8565)
+        ):
+            y, x = np.indices((h, w))
+            treshold_id = ((y & 7) << 3) + (x & 7)
+
+            r = np.minimum(r + np.array(red_thresh)[treshold_id], 0xFF) & 0xF8
+            g = np.minimum(g + np.array(green_thresh)[treshold_id], 0xFF) & 0xFC
+            b = np.minimum(b + np.array(blue_thresh)[treshold_id], 0xFF) & 0xF8
+
+        if cf in (ColorFormat.XRGB8888, ColorFormat.RGB888, ColorFormat.RGB565):
+            r, g, b, a = color_pre_multiply(r, g, b, a, self.background)
+        elif cf == ColorFormat.ARGB8888_PREMULTIPLIED:
+            r, g, b = r * a // 255, g * a // 255, b * a // 255
+
+        color = ((r >> 3) << 11) | ((g >> 2) << 5) | ((b >> 3) << 0)
+        if cf in (ColorFormat.ARGB8888, ColorFormat.ARGB8888_PREMULTIPLIED):
+            planes = [b, g, r, a]
+        elif cf == ColorFormat.XRGB8888:
+            planes = [b, g, r, np.full_like(a, 0xff)]
+        elif cf == ColorFormat.RGB888:
+            planes = [b, g, r]
+        elif cf == ColorFormat.ARGB8565:
+            planes = [color & 0xff, color >> 8, a]
+        else:  # RGB565, RGB565A8
+            planes = [color & 0xff, color >> 8]
+
+        rawdata = bytearray(np.stack(planes, axis=-1).astype(np.uint8).tobytes())
+        if cf == ColorFormat.RGB565A8:
+            rawdata += a.astype(np.uint8).tobytes()
+
+        self.set_data(cf, w, h, rawdata)
+
 
 red_thresh = [
   1, 7, 3, 5, 0, 8, 2, 6,
@@ -1235,6 +1460,181 @@ class RLEImage(LVGLImage):
         return nonrepeat_count
 
 
+class AnimHeader:
+    """
+    Header of a tile-delta animation (.anim), 32 bytes, little endian:
+        magic u32, version u8, cf u8, flags u16, w u16, h u16, tile u16,
+        frame_count u16, loop_count u16, reserved u16,
+        index_offset u32, max_frame_size u32, reserved u32
+    """
+    MAGIC = 0x4D494E41  # "ANIM"
+    VERSION = 1
+    SIZE = 32
+    FLAG_SWAP16 = 0x0001  # RGB565 stored high byte first (LV_COLOR_16_SWAP)
+
+    def __init__(self, w: int, h: int, tile: int, frame_count: int,
+                 loop_count: int, flags: int, max_frame_size: int):
+        self.w = w
+        self.h = h
+        self.tile = tile
+        self.frame_count = frame_count
+        self.loop_count = loop_count
+        self.flags = flags
+        self.max_frame_size = max_frame_size
+
+    @property
+    def binary(self) -> bytearray:
+        binary = bytearray()
+        binary += uint32_t(self.MAGIC)
+        binary += uint8_t(self.VERSION)
+        binary += uint8_t(ColorFormat.RGB565.value)
+        binary += uint16_t(self.flags)
+        binary += uint16_t(self.w)
+        binary += uint16_t(self.h)
+        binary += uint16_t(self.tile)
+        binary += uint16_t(self.frame_count)
+        binary += uint16_t(self.loop_count)
+        binary += uint16_t(0)
+        binary += uint32_t(self.SIZE)
+        binary += uint32_t(self.max_frame_size)
+        binary += uint32_t(0)
+        return binary
+
+
+class LVGLAnim:
+    """
+    Tile-delta animation played by the device from SD card.
+
+    The frame index follows the header, frame_count + 1 entries of 12 bytes:
+        offset u32, size u32, delay_ms u16, flags u16 (bit 0: keyframe)
+    Entry 0 is the first frame as a keyframe, entries 1..n-1 hold the tiles
+    that changed since the previous frame, and entry n holds the tiles that
+    change from the last frame back to the first one, used when looping.
+
+    Frame data:
+        tile_count u16, reserved u16, tile_index u16 * tile_count,
+        padding to 4 bytes, then the pixels of each listed tile.
+    Tiles are numbered row by row; tiles on the right and bottom edges are
+    clipped to the image, and their pixels are stored clipped.
+    """
+    INDEX_ENTRY_SIZE = 12
+    FRAME_KEY = 0x0001
+
+    def __init__(self,
+                 tile: int = 16,
+                 keyframe_interval: int = 0,
+                 loop_count: int = 0,
+                 swap16: bool = False) -> None:
+        if tile < 4 or tile > 64:
+            raise ParameterError(f"Invalid tile size: {tile}")
+        self.tile = tile
+        self.keyframe_interval = keyframe_interval
+        self.loop_count = loop_count
+        self.swap16 = swap16
+        self.w = 0
+        self.h = 0
+        self.frames = []  # list of (tiles, delay_ms)
+
+    def _tile_rects(self):
+        t = self.tile
+        for y0 in range(0, self.h, t):
+            for x0 in range(0, self.w, t):
+                yield x0, y0, min(x0 + t, self.w), min(y0 + t, self.h)
+
+    def _split_tiles(self, data: bytes, stride: int) -> List[bytes]:
+        tiles = []
+        for x0, y0, x1, y1 in self._tile_rects():
+            tiles.append(b"".join(data[y * stride + x0 * 2:y * stride + x1 * 2]
+                                  for y in range(y0, y1)))
+        return tiles
+
+    def add_frame(self, img: LVGLImage, delay_ms: int):
+        if img.cf != ColorFormat.RGB565:
+            raise FormatError(f"Animation frames must be RGB565, got {img.cf.name}")
+        if not self.frames:
+            self.w, self.h = img.w, img.h
+        elif (img.w, img.h) != (self.w, self.h):
+            raise FormatError(
+                f"Frame size {img.w}x{img.h} differs from {self.w}x{self.h}")
+        self.frames.append((self._split_tiles(img.data, img.stride), delay_ms))
+        return self
+
+    def from_pngs(self,
+                  files: List,
+                  delay_ms: int = 50,
+                  background: int = 0x00_00_00,
+                  rgb565_dither=False):
+        for f in files:
+            img = LVGLImage().from_png(f, ColorFormat.RGB565,
+                                       background=background,
+                                       rgb565_dither=rgb565_dither)
+            self.add_frame(img, delay_ms)
+        return self
+
+    def _frame_data(self, cur: List[bytes], prev: List[bytes]) -> bytes:
+        changed = [i for i, t in enumerate(cur) if prev is None or t != prev[i]]
+
+        data = bytearray()
+        data += uint16_t(len(changed))
+        data += uint16_t(0)
+        for i in changed:
+            data += uint16_t(i)
+        if len(data) % 4:
+            data += b"\x00" * (4 - len(data) % 4)
+        for i in changed:
+            tile = cur[i]
+            if self.swap16:
+                swapped = bytearray(tile)
+                swapped[0::2], swapped[1::2] = tile[1::2], tile[0::2]
+                tile = swapped
+            data += tile
+        return bytes(data)
+
+    def to_anim(self, filename: str):
+        """
+        Write the animation to file, filename should be ended with '.anim'
+        """
+        if not self.frames:
+            raise ParameterError("No frames to write")
+        if not filename.endswith(".anim"):
+            raise BaseException(f"filename must end with .anim: {filename}")
+        os.makedirs(path.dirname(path.abspath(filename)), exist_ok=True)
+
+        n = len(self.frames)
+        entries = []  # (data, delay, flags)
+        for i, (tiles, delay) in enumerate(self.frames):
+            key = i == 0 or (self.keyframe_interval and i % self.keyframe_interval == 0)
+            prev = None if key else self.frames[i - 1][0]
+            entries.append((self._frame_data(tiles, prev), delay,
+                            self.FRAME_KEY if key else 0))
+        # loop back from the last frame to the first one
+        first, delay = self.frames[0]
+        entries.append((self._frame_data(first, self.frames[-1][0]), delay, 0))
+
+        offset = AnimHeader.SIZE + len(entries) * self.INDEX_ENTRY_SIZE
+        index = bytearray()
+        for data, delay, flags in entries:
+            index += uint32_t(offset)
+            index += uint32_t(len(data))
+            index += uint16_t(delay)
+            index += uint16_t(flags)
+            offset += len(data)
+
+        header = AnimHeader(self.w, self.h, self.tile, n, self.loop_count,
+                            AnimHeader.FLAG_SWAP16 if self.swap16 else 0,
+                            max(len(d) for d, _, _ in entries))
+        with open(filename, "wb") as f:
+            f.write(header.binary)
+            f.write(index)
+            for data, _, _ in entries:
+                f.write(data)
+
+        delta = sum(len(d) for d, _, _ in entries[1:n])
+        logging.info(f"anim: {filename}, {n} frames {self.w}x{self.h}, "
+                     f"keyframe {len(entries[0][0])} bytes, deltas {delta} bytes")
+        return self
+
+
 class RAWImage():
     '''
     RAW image is an exception to LVGL image, it has color format of RAW or RAW_ALPHA.
@@ -1277,6 +1677,7 @@ class OutputFormat(Enum):
     C_ARRAY = "C"
     BIN_FILE = "BIN"
     PNG_FILE = "PNG"  # convert to lvgl image and then to png
+    ANIM_FILE = "ANIM"  # all PNGs of a folder as frames of one .anim file
 
 
 class PNGConverter:
@@ -1292,7 +1693,9 @@ class PNGConverter:
                  compress: CompressMethod = CompressMethod.NONE,
                  keep_folder=True,
                  rgb565_dither=False,
-                 nema_gfx=False) -> None:
+                 nema_gfx=False,
+                 jobs: int = 1,
+                 cache: bool = False) -> None:
         self.files = files
         self.cf = cf
         self.ofmt = ofmt
@@ -1305,6 +1708,8 @@ class PNGConverter:
         self.background = background
         self.rgb565_dither = rgb565_dither
         self.nema_gfx = nema_gfx
+        self.jobs = jobs or os.cpu_count() or 1
+        self.cache = cache
 
     def _replace_ext(self, input, ext, outputname: str = None):
         if self.keep_folder:
@@ -1320,42 +1725,104 @@ class PNGConverter:
         output = path.join(self.output, output)
         return output
 
+    def _output_file(self, f, outputname: str = None):
+        if self.cf in (ColorFormat.RAW, ColorFormat.RAW_ALPHA):
+            return self._replace_ext(f, ".c", outputname)
+        if self.ofmt == OutputFormat.BIN_FILE:
+            return self._replace_ext(f, ".bin")
+        elif self.ofmt == OutputFormat.C_ARRAY:
+            return self._replace_ext(f, ".c", outputname)
+        elif self.ofmt == OutputFormat.PNG_FILE:
+            return self._replace_ext(f, ".png")
+        return None
+
+    def _digest(self, f, outputname: str = None) -> str:
+        """
+        Hash of the input file, every option that affects the output, and
+        this script itself, so a changed encoder invalidates the cache too
+        """
+        h = hashlib.sha256()
+        with open(__file__, "rb") as script:
+            h.update(script.read())
+        h.update(repr((self.cf, self.ofmt, self.background, self.align,
+                       self.premultiply, self.compress, self.rgb565_dither,
+                       self.nema_gfx, outputname)).encode())
+        with open(f, "rb") as image:
+            h.update(image.read())
+        return h.hexdigest()
+
+    def _convert_one(self, f, outputname: str = None):
+        if self.cf in (ColorFormat.RAW, ColorFormat.RAW_ALPHA):
+            # Process RAW image explicitly
+            img = RAWImage().from_file(f, self.cf)
+            img.to_c_array(self._replace_ext(f, ".c", outputname), outputname=outputname)
+            return None
+
+        img = LVGLImage().from_png(f, self.cf, background=self.background, rgb565_dither=self.rgb565_dither, nema_gfx=self.nema_gfx)
+        img.adjust_stride(align=self.align)
+
+        if self.premultiply:
+            img.premultiply()
+        if self.ofmt == OutputFormat.BIN_FILE:
+            img.to_bin(self._replace_ext(f, ".bin"),
+                       compress=self.compress)
+        elif self.ofmt == OutputFormat.C_ARRAY:
+            img.to_c_array(self._replace_ext(f, ".c", outputname),
+                           compress=self.compress,
+                           outputname=outputname)
+        elif self.ofmt == OutputFormat.PNG_FILE:
+            img.to_png(self._replace_ext(f, ".png"))
+        return (f, img)
+
     def convert(self, outputname: str):
         if len(self.files) > 1 and outputname is not None:
             raise BaseException(f"Cannot specify output name when converting more than one file.")
 
-        output = []
+        # content hash cache: output file -> digest of what produced it
+        cache_file = path.join(self.output, ".lvglimage_cache.json")
+        cached = {}
+        if self.cache and path.exists(cache_file):
+            try:
+                with open(cache_file) as c:
+                    cached = json.load(c)
+            except (OSError, ValueError):
+                logging.warning(f"ignore broken cache: {cache_file}")
+
+        files = []
+        digests = {}
         for f in self.files:
-            if self.cf in (ColorFormat.RAW, ColorFormat.RAW_ALPHA):
-                # Process RAW image explicitly
-                img = RAWImage().from_file(f, self.cf)
-                img.to_c_array(self._replace_ext(f, ".c", outputname), outputname=outputname)
-            else:
-                img = LVGLImage().from_png(f, self.cf, background=self.background, rgb565_dither=self.rgb565_dither, nema_gfx=self.nema_gfx)
-                img.adjust_stride(align=self.align)
-
-                if self.premultiply:
-                    img.premultiply()
-                output.append((f, img))
-                if self.ofmt == OutputFormat.BIN_FILE:
-                    img.to_bin(self._replace_ext(f, ".bin"),
-                               compress=self.compress)
-                elif self.ofmt == OutputFormat.C_ARRAY:
-                    img.to_c_array(self._replace_ext(f, ".c", outputname),
-                                   compress=self.compress,
-                                   outputname=outputname)
-                elif self.ofmt == OutputFormat.PNG_FILE:
-                    img.to_png(self._replace_ext(f, ".png"))
+            if self.cache:
+                out = self._output_file(f, outputname)
+                digests[out] = self._digest(f, outputname)
+                if cached.get(out) == digests[out] and path.exists(out):
+                    logging.info(f"unchanged: {f}")
+                    continue
+            files.append(f)
+        self.unchanged = len(self.files) - len(files)
+
+        convert_one = partial(self._convert_one, outputname=outputname)
+        jobs = min(self.jobs, len(files))
+        if jobs > 1:
+            with multiprocessing.Pool(jobs) as pool:
+                results = pool.map(convert_one, files)
+        else:
+            results = [convert_one(f) for f in files]
 
-        return output
+        if self.cache:
+            cached.update(digests)
+            os.makedirs(self.output, exist_ok=True)
+            with open(cache_file, "w") as c:
+                json.dump(cached, c, indent=1, sort_keys=True)
+
+        return [r for r in results if r is not None]
 
 
 def main():
     parser = argparse.ArgumentParser(description='LVGL PNG to bin image tool.')
     parser.add_argument('--ofmt',
-                        help="output filename format, C or BIN",
+                        help="output filename format, C, BIN or ANIM",
                         default="BIN",
-                        choices=["C", "BIN", "PNG"])
+                        choices=["C", "BIN", "PNG", "ANIM"])
     parser.add_argument(
         '--cf',
         help=("bin image color format, use AUTO for automatically "
@@ -1392,6 +1859,31 @@ def main():
                         nargs='?')
     parser.add_argument('--nemagfx', action='store_true',
                     help="export color palette for I8 images in a format compatible with NEMA accelerator", default=False)
+    parser.add_argument('--tile',
+                        help="tile size in pixels for ANIM output",
+                        default=16,
+                        type=int)
+    parser.add_argument('--keyframe',
+                        help="store every Nth frame of an ANIM as a keyframe, 0 for the first frame only",
+                        default=0,
+                        type=int)
+    parser.add_argument('--delay',
+                        help="frame delay in ms for ANIM output",
+                        default=50,
+                        type=int)
+    parser.add_argument('--loop',
+                        help="loop count for ANIM output, 0 loops forever",
+                        default=0,
+                        type=int)
+    parser.add_argument('--swap16', action='store_true',
+                        help="store ANIM pixels high byte first (LV_COLOR_16_SWAP)", default=False)
+    parser.add_argument('-j',
+                        '--jobs',
+                        help="convert files in parallel, default to the number of CPUs",
+                        default=0,
+                        type=int)
+    parser.add_argument('--no-cache', action='store_true',
+                        help="convert every file, even if its input and options did not change", default=False)
     parser.add_argument('-o',
                         '--output',
                         default="./output",
@@ -1410,7 +1902,7 @@ def main():
     elif path.isdir(args.input):
         files = list(Path(args.input).rglob("*.[pP][nN][gG]"))
 
-        if args.name is not None:
+        if args.name is not None and args.ofmt != "ANIM":
             raise BaseException(f"invalid input: cannot specify --name when input is a directory")
     else:
         raise BaseException(f"invalid input: {args.input}")
@@ -1420,6 +1912,23 @@ def main():
 
     logging.info(f"options: {args.__dict__}, files:{[str(f) for f in files]}")
 
+    if args.ofmt == "ANIM":
+        # frames are the PNG files of one folder, in name order
+        if not path.isdir(args.input):
+            raise BaseException(f"invalid input: ANIM needs a folder of PNG frames")
+        files = sorted(Path(args.input).glob("*.[pP][nN][gG]"))
+        name = args.name or path.basename(path.normpath(args.input))
+        anim = LVGLAnim(tile=args.tile,
+                        keyframe_interval=args.keyframe,
+                        loop_count=args.loop,
+                        swap16=args.swap16)
+        anim.from_pngs(files, delay_ms=args.delay,
+                       background=args.background,
+                       rgb565_dither=args.rgb565dither)
+        anim.to_anim(path.join(args.output, name + ".anim"))
+        print(f"done {len(files)} frames")
+        return
+
     if args.cf == "AUTO":
         cf = None
     else:
@@ -1439,12 +1948,14 @@ def main():
                              compress=compress,
                              keep_folder=False,
                              rgb565_dither=args.rgb565dither,
-                             nema_gfx=args.nemagfx)
+                             nema_gfx=args.nemagfx,
+                             jobs=args.jobs,
+                             cache=not args.no_cache)
     output = converter.convert(args.name)
     for f, img in output:
         logging.info(f"len: {img.data_len} for {path.basename(f)} ")
 
-    print(f"done {len(files)} files")
+    print(f"done {len(files)} files, {converter.unchanged} unchanged")
 
 
 def test():
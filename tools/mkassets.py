@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+"""
+Pack LVGL images into an asset image that the firmware maps with
+esp_partition_mmap (components/assets). Pixels are stored exactly as
+lv_img_dsc_t expects them, so the firmware points LVGL straight at flash.
+
+Layout (little endian):
+    header   32 bytes, see PackHeader
+    index    count * 24 bytes, sorted by (name hash, name), see PackEntry
+    names    NUL terminated names, referenced by the index
+    payload  pixel data, every entry aligned to --align bytes
+
+Inputs, searched recursively in the input folder:
+    *.bin    LVGL 8 images, or uncompressed LVGL 9 images from LVGLImage.py
+             (RGB565, ARGB8565, A8)
+    *.png    converted with LVGLImage.py, the color format is taken from the
+             file name like LVGLImage.py does ("logo.ARGB8565.png"),
+             RGB565 otherwise
+
+The asset name is the path relative to the input folder without any
+extension, e.g. "icons/wifi" for icons/wifi.ARGB8565.png.
+
+With --files every file is stored unchanged instead, named by its path
+relative to the input folder including the extension. Copy such a pack to
+the SD card (CONFIG_APP_ASSET_PACK_ENABLE in lvgl_port): "A:/<name>" is then read
+from the pack with one seek instead of a FAT directory walk. Payloads are
+aligned to 512 bytes by default so every file starts on a sector.
+"""
+import sys
+import logging
+import argparse
+from os import path
+from pathlib import Path
+from typing import List
+
+
+def uint16_t(val) -> bytes:
+    return val.to_bytes(2, byteorder='little')
+
+
+def uint32_t(val) -> bytes:
+    return val.to_bytes(4, byteorder='little')
+
+
+def fnv1a32(name: str) -> int:
+    h = 0x811C9DC5
+    for b in name.encode("utf-8"):
+        h ^= b
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+class Error(Exception):
+
+    def __str__(self):
+        return self.__class__.__name__ + ': ' + ' '.join(self.args)
+
+
+class FormatError(Error):
+    """
+    Input file is not an image this tool can pack
+    """
+
+
+# LVGL 8 lv_img_cf_t values
+LV8_CF_TRUE_COLOR = 4
+LV8_CF_TRUE_COLOR_ALPHA = 5
+LV8_CF_ALPHA_8BIT = 14
+
+# LVGL 9 color format -> (LVGL 8 color format, bytes per pixel, has RGB565)
+LV9_CF_MAP = {
+    0x12: (LV8_CF_TRUE_COLOR, 2, True),  # RGB565
+    0x13: (LV8_CF_TRUE_COLOR_ALPHA, 3, True),  # ARGB8565
+    0x0E: (LV8_CF_ALPHA_8BIT, 1, False),  # A8
+}
+
+LV8_PX_SIZE = {
+    LV8_CF_TRUE_COLOR: 2,
+    LV8_CF_TRUE_COLOR_ALPHA: 3,
+    LV8_CF_ALPHA_8BIT: 1,
+}
+
+
+class PackHeader:
+    MAGIC = 0x5041564C  # "LVAP"
+    VERSION = 1
+    SIZE = 32
+    FLAG_SWAP16 = 0x0001
+    FLAG_FILES = 0x0002  # payloads are whole files, no image header
+
+    def __init__(self, flags: int, count: int, names_off: int, data_off: int,
+                 total_size: int):
+        self.flags = flags
+        self.count = count
+        self.names_off = names_off
+        self.data_off = data_off
+        self.total_size = total_size
+
+    @property
+    def binary(self) -> bytearray:
+        binary = bytearray()
+        binary += uint32_t(self.MAGIC)
+        binary += uint16_t(self.VERSION)
+        binary += uint16_t(self.flags)
+        binary += uint32_t(self.count)
+        binary += uint32_t(self.SIZE)  # index offset
+        binary += uint32_t(self.names_off)
+        binary += uint32_t(self.data_off)
+        binary += uint32_t(self.total_size)
+        binary += uint32_t(0)  # reserved
+        return binary
+
+
+class PackEntry:
+    SIZE = 24
+
+    def __init__(self, name: str, cf: int, w: int, h: int, data: bytes):
+        if w >= 2048 or h >= 2048:
+            raise FormatError(f"{name}: {w}x{h} exceeds LVGL 8 image header")
+        self.name = name
+        self.hash = fnv1a32(name)
+        self.cf = cf
+        self.w = w
+        self.h = h
+        self.data = data
+        self.name_off = 0
+        self.data_off = 0
+
+    @property
+    def img_header(self) -> int:
+        # lv_img_header_t: cf:5 always_zero:3 reserved:2 w:11 h:11
+        return self.cf | (self.w << 10) | (self.h << 21)
+
+    @property
+    def binary(self) -> bytearray:
+        binary = bytearray()
+        binary += uint32_t(self.hash)
+        binary += uint32_t(self.name_off)
+        binary += uint32_t(self.data_off)
+        binary += uint32_t(len(self.data))
+        binary += uint32_t(self.img_header)
+        binary += uint32_t(0)  # reserved
+        return binary
+
+
+def swap16(data: bytes, px_size: int) -> bytes:
+    """
+    Swap the bytes of the RGB565 part of every pixel (LV_COLOR_16_SWAP)
+    """
+    out = bytearray(data)
+    out[0::px_size], out[1::px_size] = data[1::px_size], data[0::px_size]
+    return bytes(out)
+
+
+def load_bin(name: str, filename: str, swap: bool) -> PackEntry:
+    with open(filename, "rb") as f:
+        return parse_bin(name, filename, f.read(), swap)
+
+
+def parse_bin(name: str, filename: str, data: bytes, swap: bool) -> PackEntry:
+    if len(data) < 4:
+        raise FormatError(f"{filename}: too short")
+
+    if data[0] != 0x19:
+        # LVGL 8: 4 byte bit field header, pixels already in device order
+        hdr = int.from_bytes(data[0:4], 'little')
+        cf = hdr & 0x1f
+        w = (hdr >> 10) & 0x7ff
+        h = (hdr >> 21) & 0x7ff
+        if cf not in LV8_PX_SIZE:
+            raise FormatError(f"{filename}: unsupported LVGL 8 color format {cf}")
+        size = w * h * LV8_PX_SIZE[cf]
+        if len(data) < 4 + size:
+            raise FormatError(f"{filename}: truncated")
+        return PackEntry(name, cf, w, h, data[4:4 + size])
+
+    if len(data) < 12:
+        raise FormatError(f"{filename}: too short")
+    cf9 = data[1] & 0x1f
+    flags = int.from_bytes(data[2:4], 'little')
+    w = int.from_bytes(data[4:6], 'little')
+    h = int.from_bytes(data[6:8], 'little')
+    stride = int.from_bytes(data[8:10], 'little')
+    if flags & 0x08:
+        raise FormatError(f"{filename}: compressed images can't be mapped")
+    if cf9 not in LV9_CF_MAP:
+        raise FormatError(f"{filename}: unsupported LVGL 9 color format {hex(cf9)}")
+    cf, px_size, rgb565 = LV9_CF_MAP[cf9]
+    row = w * px_size
+    if stride < row or len(data) < 12 + stride * h:
+        raise FormatError(f"{filename}: truncated")
+    pixels = b"".join(data[12 + y * stride:12 + y * stride + row] for y in range(h))
+    if rgb565 and swap:
+        pixels = swap16(pixels, px_size)
+    return PackEntry(name, cf, w, h, pixels)
+
+
+def load_png(name: str, filename: str, swap: bool) -> PackEntry:
+    sys.path.insert(0, path.dirname(path.abspath(__file__)))
+    from LVGLImage import LVGLImage, ColorFormat
+
+    cf = ColorFormat.RGB565
+    for c in path.basename(filename).split(".")[1:-1]:
+        if c in ColorFormat.__members__:
+            cf = ColorFormat[c]
+    if cf.value not in LV9_CF_MAP:
+        raise FormatError(f"{filename}: {cf.name} can't be packed")
+    img = LVGLImage().from_png(filename, cf)
+    return parse_bin(name, filename, bytes(img.header.binary + img.data), swap)
+
+
+class AssetPack:
+
+    def __init__(self, align: int = 4, swap16: bool = False, files: bool = False) -> None:
+        if align < 4 or align & (align - 1):
+            raise ValueError(f"Invalid align: {align}")
+        self.align = align
+        self.swap16 = swap16
+        self.files = files
+        self.entries: List[PackEntry] = []
+
+    def add_files(self, folder: str, exclude: str = None):
+        exclude = path.abspath(exclude) if exclude else None
+        files = sorted(p for p in Path(folder).rglob("*")
+                       if p.is_file() and str(p.absolute()) != exclude)
+        for f in files:
+            name = f.relative_to(folder).as_posix()
+            entry = PackEntry(name, 0, 0, 0, f.read_bytes())
+            logging.info(f"{name}: {len(entry.data)} bytes")
+            self.entries.append(entry)
+        return self
+
+    def add_dir(self, folder: str):
+        files = sorted(p for p in Path(folder).rglob("*")
+                       if p.suffix.lower() in (".bin", ".png"))
+        for f in files:
+            rel = f.relative_to(folder).as_posix()
+            name = rel.split("/")[-1].split(".")[0]
+            name = "/".join(rel.split("/")[:-1] + [name])
+            if f.suffix.lower() == ".bin":
+                entry = load_bin(name, str(f), self.swap16)
+            else:
+                entry = load_png(name, str(f), self.swap16)
+            logging.info(f"{name}: {entry.w}x{entry.h} cf {entry.cf}, {len(entry.data)} bytes")
+            self.entries.append(entry)
+        return self
+
+    def _pad(self, buf: bytearray):
+        if len(buf) % self.align:
+            buf += b"\x00" * (self.align - len(buf) % self.align)
+
+    @property
+    def binary(self) -> bytearray:
+        entries = sorted(self.entries, key=lambda e: (e.hash, e.name))
+        for a, b in zip(entries, entries[1:]):
+            if a.name == b.name:
+                raise FormatError(f"duplicate asset name: {a.name}")
+
+        names = bytearray()
+        names_off = PackHeader.SIZE + PackEntry.SIZE * len(entries)
+        for e in entries:
+            e.name_off = names_off + len(names)
+            names += e.name.encode("utf-8") + b"\x00"
+
+        head = bytearray(PackHeader.SIZE + PackEntry.SIZE * len(entries)) + names
+        self._pad(head)
+        data_off = len(head)
+        payload = bytearray()
+        for e in entries:
+            e.data_off = data_off + len(payload)
+            payload += e.data
+            self._pad(payload)
+
+        total = data_off + len(payload)
+        flags = PackHeader.FLAG_SWAP16 if self.swap16 else 0
+        flags |= PackHeader.FLAG_FILES if self.files else 0
+        header = PackHeader(flags, len(entries), names_off, data_off, total)
+        out = header.binary
+        for e in entries:
+            out += e.binary
+        out += head[len(out):]
+        out += payload
+        return out
+
+    def write(self, filename: str, size: int = 0):
+        binary = self.binary
+        if size and len(binary) > size:
+            raise FormatError(
+                f"assets need {len(binary)} bytes, partition is {size}")
+        with open(filename, "wb") as f:
+            f.write(binary)
+        return len(binary)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Pack LVGL images for the assets partition, or files for an SD card asset pack')
+    parser.add_argument('-o', '--output', required=True, help="output image file")
+    parser.add_argument('--size', default="0", type=lambda x: int(x, 0),
+                        help="partition size, fail if the assets don't fit")
+    parser.add_argument('--align', default=None, type=int,
+                        help="payload alignment in bytes, power of 2 and at least 4, "
+                        "default 4, or 512 with --files")
+    parser.add_argument('--swap16', action='store_true', default=False,
+                        help="store RGB565 high byte first (LV_COLOR_16_SWAP)")
+    parser.add_argument('--files', action='store_true', default=False,
+                        help="store every file unchanged, for an asset pack on the SD card")
+    parser.add_argument('-v', '--verbose', action='store_true')
+    parser.add_argument('input', help="folder with the images or files to pack")
+    args = parser.parse_args()
+
+    if args.verbose:
+        logging.basicConfig(level=logging.INFO)
+    if not path.isdir(args.input):
+        raise BaseException(f"invalid input: {args.input}")
+
+    align = args.align or (512 if args.files else 4)
+    pack = AssetPack(align=align, swap16=args.swap16, files=args.files)
+    if args.files:
+        pack.add_files(args.input, exclude=args.output)
+    else:
+        pack.add_dir(args.input)
+    size = pack.write(args.output, args.size)
+    print(f"done {len(pack.entries)} assets, {size} bytes")
+
+
+if __name__ == "__main__":
+    main()